@@ -0,0 +1,109 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "agent_behaviours.h"
+#include "ai_lod.h"
+#include "behaviour_system.h"
+#include "dungeon_generator.h"
+#include "flow_field.h"
+#include "influence_map.h"
+#include "random.h"
+#include "spatial_index.h"
+#include "walkability_grid.h"
+#include "worker_pool.h"
+
+// Травоядные под BehaviourSystem на большой карте: все агенты каждый тик против AiLod,
+// где каждый тик обновляются только агенты у игрока, а остальные - раз в --period тиков.
+// Ближних AiLod находит по пространственному индексу агентов; в игре его каждый тик пересобирает
+// SceneIndex для рендера, поэтому здесь сборка индекса в замер не входит.
+// "steps/agent/s" - сколько шагов в секунду в среднем делает агент, при LOD должно остаться тем же
+// bench_ai_lod [--size=1024] [--agents=100000] [--ticks=240] [--period=8]
+int main(int argc, char *argv[])
+{
+    int size = 1024;
+    int agents = 100000;
+    int ticks = 240;
+    unsigned period = 8;
+    for (int i = 1; i < argc; i++) {
+        sscanf(argv[i], "--size=%d", &size);
+        sscanf(argv[i], "--agents=%d", &agents);
+        sscanf(argv[i], "--ticks=%d", &ticks);
+        sscanf(argv[i], "--period=%u", &period);
+    }
+    auto dungeon = std::make_shared<Dungeon>(size, size, size * size / 400, 42u, 128);
+    BehaviourProgram program;
+    if (!compile_fsm(make_herbivore_fsm(), program))
+        return 1;
+
+    using Clock = std::chrono::steady_clock;
+    const float dt = 1.f / 60.f;
+    printf("%dx%d, %d herbivores, %d ticks of %.4f s\n", size, size, agents, ticks, dt);
+
+    for (bool useLod : { false, true }) {
+        // система живёт в своём мире, чтобы World::update не обходил агентов
+        auto world = std::make_shared<World>();
+        auto agentWorld = std::make_shared<World>();
+        world->add_service(std::make_shared<Random>(1));
+        auto pool = world->add_service(std::make_shared<WorkerPool>());
+        world->add_service(std::make_shared<WalkabilityGrid>(dungeon));
+        auto fields = world->add_service(std::make_shared<FlowFields>(dungeon, pool));
+        for (int i = 0; i < size * size / 2000; i++)
+            fields->food.add_source(dungeon->getFloorPosition(i * 7919 % dungeon->getFloorCount()));
+        // неподвижные хищники: опасность успевает разойтись от них
+        auto danger = world->add_service(std::make_shared<InfluenceMap>(dungeon, pool));
+        for (int t = 0; t < 30; t++) {
+            for (int i = 0; i < size * size / 8000; i++)
+                danger->stamp(dungeon->getFloorPosition(i * 104729 % dungeon->getFloorCount()), 1.f);
+            danger->update();
+        }
+        fields->food.update();
+        const int2 player = dungeon->getFloorPosition(dungeon->getFloorCount() / 2);
+        std::shared_ptr<AiLod> lod;
+        if (useLod)
+            lod = world->add_service(std::make_shared<AiLod>(2, period));
+        auto system = world->create_object()->add_component<BehaviourSystem>(program);
+
+        std::vector<std::shared_ptr<Transform2D>> transforms;
+        std::vector<uint32_t> ids;
+        for (int i = 0; i < agents; i++) {
+            auto agent = agentWorld->create_object();
+            ids.push_back(agent->get_id());
+            const int2 p = dungeon->getFloorPosition(uint32_t(uint64_t(i) * 2654435761u % dungeon->getFloorCount()));
+            transforms.push_back(agent->add_component<Transform2D>(p.x, p.y));
+            agent->add_component<Stamina>(100);
+            agent->add_component<Health>(100)->set(i % 2 ? 100 : 50);
+            system->add(agent);
+        }
+        std::vector<int2> start(agents);
+        for (int i = 0; i < agents; i++)
+            start[i] = int2((int)transforms[i]->x, (int)transforms[i]->y);
+
+        SpatialIndex index(size, size);
+        std::vector<int2> positions(agents);
+        double seconds = 0;
+        size_t updated = 0;
+        for (int t = 0; t < ticks; t++) {
+            if (lod) {
+                for (int i = 0; i < agents; i++)
+                    positions[i] = int2((int)transforms[i]->x, (int)transforms[i]->y);
+                index.build(positions);
+                lod->set_active_points(std::span(&player, 1), index, ids);
+            }
+            auto begin = Clock::now();
+            world->update(dt);
+            seconds += std::chrono::duration<double>(Clock::now() - begin).count();
+            updated += system->get_updated_count();
+        }
+        // шаги считаются по смещению: у блуждающих агентов - заниженная, но одинаковая в обоих режимах оценка
+        double steps = 0;
+        for (int i = 0; i < agents; i++)
+            steps += std::abs(transforms[i]->x - start[i].x) + std::abs(transforms[i]->y - start[i].y);
+        printf("  %-8s %8.3f ms/tick  %9.0f agents updated/tick  %6.3f cells away/agent/s\n",
+               useLod ? "AiLod" : "all", seconds * 1000 / ticks, double(updated) / ticks,
+               steps / agents / (ticks * dt));
+    }
+    return 0;
+}
@@ -0,0 +1,156 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "agent_behaviours.h"
+#include "behaviour.h"
+
+// Решение "что делать" для 1k..1M агентов за тик: дерево из объектов с виртуальным tick()
+// у каждого агента против FSM и дерева, скомпилированных в таблицы BehaviourRuntime.
+// Факты каждый тик меняются у части агентов, их подготовка в замер не входит
+// bench_behaviour [--ticks=100] [--change=5] (процент агентов со сменой фактов за тик)
+struct INode {
+    virtual ~INode() = default;
+    // -1 - неудача, иначе номер действия
+    virtual int tick(BehaviourFacts facts) = 0;
+};
+
+struct ConditionNode : INode {
+    BehaviourFacts mask;
+    explicit ConditionNode(BehaviourFacts mask) : mask(mask) {}
+    int tick(BehaviourFacts facts) override { return (facts & mask) == mask ? 0 : -1; }
+};
+
+struct ActionNode : INode {
+    int action;
+    explicit ActionNode(AgentAction action) : action(int(action)) {}
+    int tick(BehaviourFacts) override { return action; }
+};
+
+struct SequenceNode : INode {
+    std::vector<std::unique_ptr<INode>> children;
+    int tick(BehaviourFacts facts) override {
+        int result = -1;
+        for (auto &child : children)
+            if ((result = child->tick(facts)) < 0)
+                return -1;
+        return result;
+    }
+};
+
+struct SelectorNode : INode {
+    std::vector<std::unique_ptr<INode>> children;
+    int tick(BehaviourFacts facts) override {
+        for (auto &child : children)
+            if (int result = child->tick(facts); result >= 0)
+                return result;
+        return -1;
+    }
+};
+
+// то же, что make_herbivore_tree, но отдельными объектами на каждого агента
+static std::unique_ptr<INode> make_object_tree()
+{
+    auto flee = std::make_unique<SequenceNode>();
+    flee->children.push_back(std::make_unique<ConditionNode>(ThreatNear));
+    flee->children.push_back(std::make_unique<ActionNode>(AgentAction::Flee));
+    auto forage = std::make_unique<SequenceNode>();
+    forage->children.push_back(std::make_unique<ConditionNode>(Hungry));
+    forage->children.push_back(std::make_unique<ConditionNode>(FoodKnown));
+    forage->children.push_back(std::make_unique<ActionNode>(AgentAction::Forage));
+    auto root = std::make_unique<SelectorNode>();
+    root->children.push_back(std::move(flee));
+    root->children.push_back(std::move(forage));
+    root->children.push_back(std::make_unique<ActionNode>(AgentAction::Wander));
+    return root;
+}
+
+static uint32_t xorshift32(uint32_t &s)
+{
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    return s;
+}
+
+int main(int argc, char *argv[])
+{
+    int ticks = 100;
+    int change = 5;
+    for (int i = 1; i < argc; i++) {
+        sscanf(argv[i], "--ticks=%d", &ticks);
+        sscanf(argv[i], "--change=%d", &change);
+    }
+    BehaviourProgram fsmProgram, treeProgram;
+    if (!compile_fsm(make_herbivore_fsm(), fsmProgram) || !compile_behaviour_tree(make_herbivore_tree(), treeProgram))
+        return 1;
+
+    using Clock = std::chrono::steady_clock;
+    auto ns = [](Clock::duration d) { return std::chrono::duration<double, std::nano>(d).count(); };
+    printf("herbivore behaviour, %d ticks, %d%% of agents change facts per tick, ns per agent per tick (ms per tick)\n",
+           ticks, change);
+    printf("%10s %18s %18s %18s\n", "agents", "objects", "FSM table", "BT table");
+
+    for (size_t count : { size_t(1000), size_t(100000), size_t(1000000) }) {
+        // у каждого варианта одна и та же последовательность фактов
+        std::vector<BehaviourFacts> facts(count);
+        uint32_t rng;
+        auto first_tick = [&] {
+            rng = 12345;
+            for (auto &f : facts)
+                f = xorshift32(rng) & 0xF;
+        };
+        auto next_tick = [&] {
+            for (auto &f : facts)
+                if (xorshift32(rng) % 100 < uint32_t(change))
+                    f ^= 1u << (rng >> 30);
+        };
+
+        std::vector<std::unique_ptr<INode>> trees(count);
+        for (auto &tree : trees)
+            tree = make_object_tree();
+        std::vector<int> actions(count);
+        double objects = 0;
+        first_tick();
+        for (int t = 0; t < ticks; t++) {
+            if (t)
+                next_tick();
+            auto start = Clock::now();
+            for (size_t i = 0; i < count; i++)
+                actions[i] = trees[i]->tick(facts[i]);
+            objects += ns(Clock::now() - start);
+        }
+
+        auto run = [&](const BehaviourProgram &program) {
+            BehaviourRuntime runtime(program);
+            for (size_t i = 0; i < count; i++)
+                runtime.add();
+            double total = 0;
+            first_tick();
+            for (int t = 0; t < ticks; t++) {
+                if (t)
+                    next_tick();
+                std::copy(facts.begin(), facts.end(), runtime.facts.begin());
+                auto start = Clock::now();
+                runtime.think();
+                total += ns(Clock::now() - start);
+            }
+            // последний тик должен выбрать те же действия, что и дерево из объектов
+            for (uint32_t i = 0; i < count; i++) {
+                if (runtime.get_action(runtime.get_state(i)) != actions[i]) {
+                    printf("agent %u: action %d instead of %d\n", i, runtime.get_action(runtime.get_state(i)), actions[i]);
+                    exit(1);
+                }
+            }
+            return total;
+        };
+        const double fsm = run(fsmProgram);
+        const double tree = run(treeProgram);
+        const double perTick = double(count) * ticks;
+        printf("%10zu %9.2f (%6.2f) %9.2f (%6.2f) %9.2f (%6.2f)\n", count,
+               objects / perTick, objects / ticks / 1e6, fsm / perTick, fsm / ticks / 1e6, tree / perTick, tree / ticks / 1e6);
+    }
+    return 0;
+}
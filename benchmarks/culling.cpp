@@ -0,0 +1,106 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "dungeon_generator.h"
+#include "random.h"
+#include "spatial_index.h"
+
+// Сколько спрайтов за кадр уходит на отрисовку и сколько стоит их отбор, на картах 128..4096:
+// "all" - как было: каждая клетка и каждая сущность переводится в экранные координаты и отдаётся
+// на отрисовку (обрезает уже SDL); "culled" - клетки из диапазона, вычисленного по камере,
+// сущности из SpatialIndex с точной проверкой. Окно --width x --height, --ppm пикселей на клетку,
+// одна сущность на --density клеток пола, камера ходит по карте
+// bench_culling [--width=1600] [--height=1200] [--ppm=32] [--density=20] [--frames=20]
+int main(int argc, char *argv[])
+{
+    int width = 1600, height = 1200;
+    float ppm = 32.f;
+    int density = 20;
+    int frames = 20;
+    for (int i = 1; i < argc; i++) {
+        sscanf(argv[i], "--width=%d", &width);
+        sscanf(argv[i], "--height=%d", &height);
+        sscanf(argv[i], "--ppm=%f", &ppm);
+        sscanf(argv[i], "--density=%d", &density);
+        sscanf(argv[i], "--frames=%d", &frames);
+    }
+    using Clock = std::chrono::steady_clock;
+    auto ms = [](Clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+    printf("%dx%d window at %.0f px per cell, ms per frame (sprites submitted)\n", width, height, ppm);
+    printf("%10s %10s %24s %24s\n", "map", "entities", "all", "culled");
+
+    struct Rect {
+        float x, y, w, h;
+    };
+    std::vector<Rect> submitted;
+    Random random(1);
+    for (int size : { 128, 512, 1024, 2048, 4096 }) {
+        Dungeon dungeon(size, size, size * size / 400, 42u, size > 256 ? 128 : 0);
+        std::vector<float2> entities(size_t(dungeon.getFloorCount() / density));
+        for (size_t i = 0; i < entities.size(); i++) {
+            const int2 cell = dungeon.getFloorPosition(random.get_int(uint32_t(dungeon.getFloorCount()), uint32_t(i), 0, SpawnPosition));
+            entities[i] = float2(cell.x + random.get_float(uint32_t(i), 0, WanderStep), float(cell.y));
+        }
+
+        auto submit = [&](double x, double y, double camX, double camY) {
+            submitted.push_back(Rect{ float((x - camX) * ppm + width / 2), float((y - camY) * ppm + height / 2), ppm, ppm });
+        };
+        // камера проходит по диагонали карты
+        auto camera = [&](int frame) { return double(size) * (frame + 0.5) / frames; };
+
+        double all = 0;
+        size_t allSprites = 0;
+        auto begin = Clock::now();
+        for (int f = 0; f < frames; f++) {
+            const double cam = camera(f);
+            submitted.clear();
+            for (int y = 0; y < size; y++)
+                for (int x = 0; x < size; x++)
+                    submit(x, y, cam, cam);
+            for (const float2 &e : entities)
+                submit(e.x, e.y, cam, cam);
+            allSprites += submitted.size();
+        }
+        all = ms(Clock::now() - begin) / frames;
+
+        SpatialIndex index(size, size);
+        std::vector<int2> positions(entities.size());
+        std::vector<uint32_t> nearby;
+        double culled = 0;
+        size_t culledSprites = 0;
+        begin = Clock::now();
+        for (int f = 0; f < frames; f++) {
+            // индекс пересобирается каждый кадр, как в SceneIndexSystem
+            for (size_t i = 0; i < entities.size(); i++)
+                positions[i] = int2(int(std::floor(entities[i].x)), int(std::floor(entities[i].y)));
+            index.build(positions);
+
+            const double cam = camera(f);
+            const double minX = cam - width / 2 / ppm, maxX = cam + width / 2 / ppm;
+            const double minY = cam - height / 2 / ppm, maxY = cam + height / 2 / ppm;
+            submitted.clear();
+            const int x0 = std::max(int(std::floor(minX)), 0), x1 = std::min(int(std::floor(maxX)), size - 1);
+            const int y0 = std::max(int(std::floor(minY)), 0), y1 = std::min(int(std::floor(maxY)), size - 1);
+            for (int y = y0; y <= y1; y++)
+                for (int x = x0; x <= x1; x++)
+                    submit(x, y, cam, cam);
+            nearby.clear();
+            index.query(int2(int(std::floor(minX)) - 1, int(std::floor(minY)) - 1), int2(int(std::floor(maxX)), int(std::floor(maxY))), nearby);
+            for (uint32_t i : nearby) {
+                const float2 &e = entities[i];
+                if (e.x + 1 > minX && e.x < maxX && e.y + 1 > minY && e.y < maxY)
+                    submit(e.x, e.y, cam, cam);
+            }
+            culledSprites += submitted.size();
+        }
+        culled = ms(Clock::now() - begin) / frames;
+
+        char mapName[32];
+        snprintf(mapName, sizeof(mapName), "%dx%d", size, size);
+        printf("%10s %10zu %12.3f (%9zu) %12.3f (%9zu)\n", mapName, entities.size(), all, allSprites / frames,
+               culled, culledSprites / frames);
+    }
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "food_storage.h"
+#include "health.h"
+#include "stamina.h"
+#include "transform2d.h"
+#include "world.h"
+
+// Появление и поедание 1k..1M еды: прежняя еда отдельными объектами мира с виртуальным
+// on_consume, созданная через new, против FoodStorage (плотные массивы std::variant и std::visit).
+// Считаются и выделения памяти за цикл после прогрева. Объекты - только до 10k:
+// World::update удаляет каждый объект поиском по списку, на 100k это уже минуты
+// bench_food [--repeats=5]
+
+static size_t allocations = 0;
+
+void *operator new(size_t size)
+{
+    allocations++;
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+// еда в том виде, что была до FoodStorage
+class IFood : public Component {
+public:
+    virtual void on_consume(GameObjectPtr consumer) = 0;
+};
+class ObjectHealthFood : public IFood {
+public:
+    int restore;
+    ObjectHealthFood(int restore) : restore(restore) {}
+    void on_consume(GameObjectPtr consumer) override {
+        if (auto health = consumer->get_component<Health>()) {
+            health->change(restore);
+            get_owner()->get_world()->destroy_object(get_owner());
+        }
+    }
+};
+class ObjectStaminaFood : public IFood {
+public:
+    int restore;
+    ObjectStaminaFood(int restore) : restore(restore) {}
+    void on_consume(GameObjectPtr consumer) override {
+        if (auto stamina = consumer->get_component<Stamina>()) {
+            stamina->change(restore);
+            get_owner()->get_world()->destroy_object(get_owner());
+        }
+    }
+};
+
+int main(int argc, char *argv[])
+{
+    int repeats = 5;
+    for (int i = 1; i < argc; i++)
+        sscanf(argv[i], "--repeats=%d", &repeats);
+    using Clock = std::chrono::steady_clock;
+    auto ms = [](Clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+    printf("spawn N food, then one consumer eats all of it, ms per cycle (allocations per cycle)\n");
+    printf("%10s %24s %24s\n", "food", "objects", "FoodStorage");
+
+    for (size_t count : { size_t(1000), size_t(10000), size_t(100000), size_t(1000000) }) {
+        auto world = std::make_shared<World>();
+        auto consumer = world->create_object();
+        auto health = consumer->add_component<Health>(1000);
+        consumer->add_component<Stamina>(1000);
+        world->update(0.f);
+
+        double objects = 0;
+        size_t objectAllocations = 0;
+        for (int r = 0; r <= repeats && count <= 10000; r++) {
+            const size_t allocationsBefore = allocations;
+            auto begin = Clock::now();
+            for (size_t i = 0; i < count; i++) {
+                auto obj = world->create_object();
+                obj->add_component<Transform2D>(int(i % 1024), int(i / 1024));
+                if (i % 2)
+                    obj->add_component<IFood>((IFood *)new ObjectHealthFood(10));
+                else
+                    obj->add_component<IFood>((IFood *)new ObjectStaminaFood(10));
+            }
+            world->update(0.f);
+            for (auto &obj : world->get_objects())
+                if (auto food = obj->get_component<IFood>())
+                    food->on_consume(consumer);
+            world->update(0.f);
+            // первый проход - прогрев
+            if (r) {
+                objects += ms(Clock::now() - begin);
+                objectAllocations += allocations - allocationsBefore;
+            }
+        }
+
+        auto vitals = world->get_service<Vitals>();
+        FoodStorage storage;
+        storage.add_kind(HealthFood{ 10 }, 1);
+        storage.add_kind(StaminaFood{ 10 }, 1);
+        std::vector<uint32_t> foods(count), rows(count, vitals->find(consumer->get_id()));
+        double stored = 0;
+        size_t storedAllocations = 0;
+        for (int r = 0; r <= repeats; r++) {
+            const size_t allocationsBefore = allocations;
+            auto begin = Clock::now();
+            for (size_t i = 0; i < count; i++)
+                storage.spawn(int2(int(i % 1024), int(i / 1024)), uint8_t(i % 2));
+            for (size_t i = 0; i < count; i++)
+                foods[i] = uint32_t(i);
+            storage.consume(foods, rows, *vitals);
+            if (r) {
+                stored += ms(Clock::now() - begin);
+                storedAllocations += allocations - allocationsBefore;
+            }
+        }
+        if (storage.size()) {
+            printf("%zu food left\n", storage.size());
+            return 1;
+        }
+        if (count <= 10000)
+            printf("%10zu %12.3f (%9.0f) %12.3f (%9.0f)\n", count, objects / repeats, double(objectAllocations) / repeats,
+                   stored / repeats, double(storedAllocations) / repeats);
+        else
+            printf("%10zu %24s %12.3f (%9.0f)\n", count, "-", stored / repeats, double(storedAllocations) / repeats);
+    }
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "food_spawner.h"
+#include "food_storage.h"
+#include "random.h"
+
+// Долгая игра на карте --size x --size: каждый тик появляется --spawns еды и съедается --eaten.
+// "scan" - как было: вид еды перебором весов, клетка через Dungeon::getFloorPosition (обход маски пола),
+// без пределов; "spawner" - FoodSpawner (AliasTable по комнатам и видам, пределы по комнатам).
+// Время появления одной еды в начале и в конце, и сколько еды и номеров в FoodStorage к концу
+// bench_food_spawner [--size=2048] [--ticks=2000] [--spawns=50] [--eaten=40]
+int main(int argc, char *argv[])
+{
+    int size = 2048;
+    int ticks = 2000;
+    int spawns = 50;
+    int eatenPerTick = 40;
+    for (int i = 1; i < argc; i++) {
+        sscanf(argv[i], "--size=%d", &size);
+        sscanf(argv[i], "--ticks=%d", &ticks);
+        sscanf(argv[i], "--spawns=%d", &spawns);
+        sscanf(argv[i], "--eaten=%d", &eatenPerTick);
+    }
+    auto dungeon = std::make_shared<Dungeon>(size, size, size * size / 400, 42u, 128);
+    Random random(1);
+    using Clock = std::chrono::steady_clock;
+    auto us = [](Clock::duration d) { return std::chrono::duration<double, std::micro>(d).count(); };
+    printf("%dx%d, %zu rooms, %d ticks, %d spawns and %d eaten per tick, us per spawn\n",
+           size, size, dungeon->getRooms().size(), ticks, spawns, eatenPerTick);
+    printf("%10s %12s %12s %10s %10s\n", "", "first tick", "last tick", "food", "capacity");
+
+    auto make_storage = [] {
+        auto storage = std::make_shared<FoodStorage>();
+        storage->add_kind(HealthFood{ 10 }, 100);
+        storage->add_kind(HealthFood{ 25 }, 30);
+        storage->add_kind(StaminaFood{ 10 }, 35);
+        storage->add_kind(StaminaFood{ 25 }, 20);
+        return storage;
+    };
+    // один едок на всех; съеденная еда выбирается по номеру из Random, одинаково в обоих вариантах
+    Vitals vitals;
+    uint32_t row;
+    vitals.attach(nullptr, 0, VitalHealth, 1000, &row);
+    vitals.attach(nullptr, 0, VitalStamina, 1000, &row);
+    auto eat = [&](FoodStorage &storage, uint32_t tick) {
+        for (int i = 0; i < eatenPerTick && storage.size(); i++) {
+            const uint32_t foods[] = { random.get_int(uint32_t(storage.size()), 0, tick, WanderStep, i) };
+            const uint32_t rows[] = { row };
+            storage.consume(foods, rows, vitals);
+        }
+    };
+
+    auto run = [&](const char *name, FoodStorage &storage, auto &&spawn, size_t capacity) {
+        double first = 0, last = 0;
+        for (int t = 0; t < ticks; t++) {
+            auto begin = Clock::now();
+            for (int i = 0; i < spawns; i++)
+                spawn(uint32_t(t), uint32_t(i));
+            const double spent = us(Clock::now() - begin) / spawns;
+            if (t == 0)
+                first = spent;
+            if (t == ticks - 1)
+                last = spent;
+            eat(storage, uint32_t(t));
+        }
+        if (capacity)
+            printf("%10s %12.3f %12.3f %10zu %10zu\n", name, first, last, storage.size(), capacity);
+        else
+            printf("%10s %12.3f %12.3f %10zu %10s\n", name, first, last, storage.size(), "-");
+    };
+
+    auto scanStorage = make_storage();
+    int weightSum = 0;
+    for (const auto &kind : scanStorage->get_kinds())
+        weightSum += kind.weight;
+    run("scan", *scanStorage, [&](uint32_t tick, uint32_t index) {
+        const int2 cell = dungeon->getFloorPosition(random.get_int(uint32_t(dungeon->getFloorCount()), 1, tick, FoodPosition, index));
+        int value = int(random.get_int(uint32_t(weightSum), 1, tick, FoodKind, index));
+        const auto &kinds = scanStorage->get_kinds();
+        for (size_t kind = 0; kind < kinds.size(); kind++) {
+            if (value < kinds[kind].weight) {
+                scanStorage->spawn(cell, uint8_t(kind));
+                break;
+            }
+            value -= kinds[kind].weight;
+        }
+    }, 0);
+
+    auto storage = make_storage();
+    FoodSpawner spawner(dungeon, storage, 1.f / 20);
+    run("spawner", *storage, [&](uint32_t tick, uint32_t index) {
+        spawner.spawn(random, 1, tick, index);
+    }, spawner.get_capacity());
+
+    // доли видов еды должны совпасть с весами
+    std::vector<size_t> counts(storage->get_kinds().size());
+    for (uint8_t kind : storage->kindOf)
+        counts[kind]++;
+    printf("kinds in the spawner's storage:");
+    for (size_t kind = 0; kind < counts.size(); kind++)
+        printf(" %.3f (%.3f)", double(counts[kind]) / storage->size(), double(storage->get_kinds()[kind].weight) / weightSum);
+    printf("\n");
+    return 0;
+}
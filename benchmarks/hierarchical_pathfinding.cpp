@@ -0,0 +1,96 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "dungeon_generator.h"
+#include "hierarchical_pathfinder.h"
+#include "pathfinder.h"
+
+// Длинные запросы через всю карту: HPA* по комнатам против A* и JPS по всей сетке
+// на карте из кусков (Dungeon с chunkSize), как у больших пресгенерированных уровней.
+// "plan" - только путь по порталам (find_waypoints), "HPA*" - с разворачиванием в клетки.
+// Затем --edits одиночных правок карты: обновление графа по журналу правок против полной перестройки,
+// и те же запросы после правок ("HPA*'" - без ориентиров, они выключаются до перестройки)
+// bench_hierarchical_pathfinding [--size=4096] [--chunk=128] [--cluster=64] [--rooms=N] [--queries=100] [--edits=100] [--seed=N]
+int main(int argc, char *argv[])
+{
+    int size = 4096;
+    int chunk = 128;
+    int cluster = 64;
+    int rooms = 0;
+    int queries = 100;
+    int edits = 100;
+    unsigned seed = 42;
+    for (int i = 1; i < argc; i++) {
+        sscanf(argv[i], "--size=%d", &size);
+        sscanf(argv[i], "--chunk=%d", &chunk);
+        sscanf(argv[i], "--cluster=%d", &cluster);
+        sscanf(argv[i], "--rooms=%d", &rooms);
+        sscanf(argv[i], "--queries=%d", &queries);
+        sscanf(argv[i], "--edits=%d", &edits);
+        sscanf(argv[i], "--seed=%u", &seed);
+    }
+    if (!rooms)
+        rooms = int(int64_t(size) * size / 400);
+    using Clock = std::chrono::steady_clock;
+    auto us = [](Clock::duration d) { return std::chrono::duration<double, std::micro>(d).count(); };
+
+    auto start = Clock::now();
+    auto dungeon = std::make_shared<Dungeon>(size, size, rooms, seed, chunk);
+    const double generateUs = us(Clock::now() - start);
+    start = Clock::now();
+    HierarchicalPathfinder hierarchical(dungeon, cluster);
+    const double buildUs = us(Clock::now() - start);
+    Pathfinder pathfinder(dungeon);
+
+    // пары через всю карту в одной области связности
+    std::vector<std::pair<int2, int2>> pairs;
+    while (int(pairs.size()) < queries) {
+        int2 a = dungeon->getRandomFloorPosition(), b = dungeon->getRandomFloorPosition();
+        if (std::abs(a.x - b.x) + std::abs(a.y - b.y) >= size / 2 && dungeon->getRegions().same_region(a, b))
+            pairs.emplace_back(a, b);
+    }
+
+    printf("%dx%d (chunks %d), %zu rooms, generated in %.0f ms\n", size, size, chunk, dungeon->getRooms().size(), generateUs / 1000);
+    printf("abstract graph %zu nodes / %zu edges, %zu portals / %zu portal edges (cluster %d), built in %.0f ms\n",
+           hierarchical.get_node_count(), hierarchical.get_edge_count(), hierarchical.get_portal_count(),
+           hierarchical.get_portal_edge_count(), cluster, buildUs / 1000);
+    auto run = [&](const char *name, auto &&query) {
+        std::vector<int2> path;
+        size_t length = 0, expanded = 0;
+        auto begin = Clock::now();
+        for (auto [a, b] : pairs) {
+            expanded += query(a, b, path);
+            length += path.size();
+        }
+        const double total = us(Clock::now() - begin);
+        printf("  %-6s %10.1f us/query  %10.1f expanded/q  %8.1f points/path\n",
+               name, total / pairs.size(), double(expanded) / pairs.size(), double(length) / pairs.size());
+    };
+    run("plan", [&](int2 a, int2 b, std::vector<int2> &path) { hierarchical.find_waypoints(a, b, path); return hierarchical.get_expanded_nodes(); });
+    run("HPA*", [&](int2 a, int2 b, std::vector<int2> &path) { hierarchical.find_path(a, b, path); return hierarchical.get_expanded_nodes(); });
+    run("JPS", [&](int2 a, int2 b, std::vector<int2> &path) { pathfinder.find_path_jps(a, b, path); return pathfinder.get_expanded_nodes(); });
+    run("A*", [&](int2 a, int2 b, std::vector<int2> &path) { pathfinder.find_path(a, b, path); return pathfinder.get_expanded_nodes(); });
+
+    // правки рядом с полом: стена в комнате, пролом рядом с коридором
+    std::mt19937 rng(seed);
+    double updateUs = 0;
+    for (int i = 0; i < edits; i++) {
+        const int2 c = dungeon->getRandomFloorPosition();
+        const int x = c.x + int(rng() % 5) - 2, y = c.y + int(rng() % 5) - 2;
+        dungeon->setTile(x, y, dungeon->isFloor(x, y) ? Dungeon::WALL : Dungeon::FLOOR);
+        start = Clock::now();
+        hierarchical.update();
+        updateUs += us(Clock::now() - start);
+    }
+    if (edits > 0)
+        printf("%d edits: update %.3f ms/edit\n", edits, updateUs / edits / 1000);
+    run("HPA*'", [&](int2 a, int2 b, std::vector<int2> &path) { hierarchical.find_path(a, b, path); return hierarchical.get_expanded_nodes(); });
+    start = Clock::now();
+    hierarchical.rebuild();
+    printf("full rebuild %.0f ms\n", us(Clock::now() - start) / 1000);
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "dungeon_generator.h"
+#include "flow_field.h"
+#include "influence_map.h"
+#include "simd.h"
+#include "walkability_grid.h"
+#include "worker_pool.h"
+
+// "Рядом ли хищник" для --agents травоядных при --predators бродячих хищниках, мс за тик:
+// перебор всех хищников каждым агентом, поле расстояний FlowField от хищников (BFS каждый тик)
+// и InfluenceMap (штампы, размытие, одно чтение на агента) на каждом наборе команд процессора
+// bench_influence_map [--size=1024] [--agents=100000] [--predators=1000] [--ticks=60]
+int main(int argc, char *argv[])
+{
+    int size = 1024;
+    int agents = 100000;
+    int predatorCount = 1000;
+    int ticks = 60;
+    for (int i = 1; i < argc; i++) {
+        sscanf(argv[i], "--size=%d", &size);
+        sscanf(argv[i], "--agents=%d", &agents);
+        sscanf(argv[i], "--predators=%d", &predatorCount);
+        sscanf(argv[i], "--ticks=%d", &ticks);
+    }
+    auto dungeon = std::make_shared<Dungeon>(size, size, size * size / 400, 42u, 128);
+    WalkabilityGrid grid(dungeon);
+    std::vector<int2> herbivores(agents);
+    for (int i = 0; i < agents; i++)
+        herbivores[i] = dungeon->getFloorPosition(uint32_t(uint64_t(i) * 2654435761u % dungeon->getFloorCount()));
+
+    using Clock = std::chrono::steady_clock;
+    auto ms = [](Clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+    printf("%dx%d, %d herbivores, %d predators, %d ticks, ms per tick\n", size, size, agents, predatorCount, ticks);
+
+    // у всех вариантов одни и те же хищники
+    auto run = [&](const char *name, auto &&tick) {
+        std::vector<int2> predators(predatorCount);
+        for (int i = 0; i < predatorCount; i++)
+            predators[i] = dungeon->getFloorPosition(uint32_t(uint64_t(i) * 40503u % dungeon->getFloorCount()));
+        uint32_t rng = 1;
+        size_t near = 0;
+        double total = 0;
+        for (int t = 0; t < ticks; t++) {
+            for (int2 &p : predators) {
+                rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+                const int2 d = (rng >> 31) ? int2((rng >> 30) & 1 ? 1 : -1, 0) : int2(0, (rng >> 30) & 1 ? 1 : -1);
+                if (grid.can_pass(int2(p.x + d.x, p.y + d.y)))
+                    p = int2(p.x + d.x, p.y + d.y);
+            }
+            auto begin = Clock::now();
+            near += tick(predators);
+            total += ms(Clock::now() - begin);
+        }
+        printf("  %-16s %9.3f   %6.2f%% of agents in danger\n", name, total / ticks, 100.0 * near / (double(agents) * ticks));
+    };
+
+    if (int64_t(agents) * predatorCount <= int64_t(1) << 28) {
+        run("scan", [&](const std::vector<int2> &predators) {
+            size_t near = 0;
+            for (int2 h : herbivores)
+                for (int2 p : predators)
+                    if (std::abs(h.x - p.x) + std::abs(h.y - p.y) <= 4) {
+                        near++;
+                        break;
+                    }
+            return near;
+        });
+    }
+    auto pool = std::make_shared<WorkerPool>();
+    FlowField threat(dungeon, pool);
+    run("flow field", [&](const std::vector<int2> &predators) {
+        threat.set_sources(predators);
+        threat.update();
+        size_t near = 0;
+        for (int2 h : herbivores)
+            near += threat.get_distance(h) <= 4;
+        return near;
+    });
+    const SimdLevel best = get_simd_level();
+    for (SimdLevel level : { SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Avx2 }) {
+        if (level > best)
+            break;
+        limit_simd_level(level);
+        char name[32];
+        snprintf(name, sizeof(name), "influence %s", get_simd_name(level));
+        InfluenceMap danger(dungeon, pool);
+        run(name, [&](const std::vector<int2> &predators) {
+            for (int2 p : predators)
+                danger.stamp(p, 1.f);
+            danger.update();
+            size_t near = 0;
+            for (int2 h : herbivores)
+                near += danger.get(h) >= 0.02f;
+            return near;
+        });
+        if (level == best)
+            printf("  influence map: %zu of %d rows active\n", danger.get_active_row_count(), size);
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "frame_arena.h"
+#include "interactions.h"
+
+// Хищники и жертвы на квадрате --area x --area, так что в клетках много конфликтов.
+// "scan" - каждый хищник обходит всех жертв, как было в Predator::on_update (только до 10k),
+// "resolver" - InteractionResolver. Результат резолвера сверяется на перемешанном входе.
+// Каждый resolve - отдельный тик: после него FrameArena сбрасывается, как в конце кадра игры
+// bench_interactions [--area=256] [--seed=1]
+int main(int argc, char *argv[])
+{
+    int area = 256;
+    unsigned seed = 1;
+    for (int i = 1; i < argc; i++) {
+        sscanf(argv[i], "--area=%d", &area);
+        sscanf(argv[i], "--seed=%u", &seed);
+    }
+    using Clock = std::chrono::steady_clock;
+    auto us = [](Clock::duration d) { return std::chrono::duration<double, std::micro>(d).count(); };
+    printf("actors and targets on %dx%d cells, us per tick\n", area, area);
+    printf("%10s %12s %12s %10s\n", "actors", "scan", "resolver", "pairs");
+
+    auto pool = std::make_shared<WorkerPool>();
+    std::mt19937 rng(seed);
+    for (size_t count : { size_t(1000), size_t(10000), size_t(100000), size_t(1000000) }) {
+        auto make = [&](uint32_t firstId) {
+            std::vector<InteractionActor> actors(count);
+            for (uint32_t i = 0; i < count; i++)
+                actors[i] = { int2(int(rng() % area), int(rng() % area)), firstId + i, uint32_t(rng()) };
+            return actors;
+        };
+        const auto predators = make(0);
+        const auto victims = make(uint32_t(count));
+
+        double scan = 0;
+        if (count <= 10000) {
+            // первый подошедший в порядке обхода, без учёта того, что жертву уже съели
+            auto begin = Clock::now();
+            size_t found = 0;
+            for (const auto &predator : predators)
+                for (const auto &victim : victims)
+                    if (predator.cell.x == victim.cell.x && predator.cell.y == victim.cell.y) {
+                        found++;
+                        break;
+                    }
+            scan = us(Clock::now() - begin);
+            if (!found)
+                printf("no pairs\n");
+        }
+
+        InteractionResolver resolver(pool);
+        std::vector<Interaction> pairs;
+        resolver.resolve(predators, victims, pairs); // прогрев буферов
+        FrameArena::get().reset();
+        const int repeats = count <= 100000 ? 10 : 2;
+        auto begin = Clock::now();
+        for (int r = 0; r < repeats; r++) {
+            resolver.resolve(predators, victims, pairs);
+            FrameArena::get().reset();
+        }
+        const double resolved = us(Clock::now() - begin) / repeats;
+
+        // те же пары (по id) при другом порядке входа
+        auto toIds = [](const std::vector<Interaction> &result, const std::vector<InteractionActor> &a,
+                        const std::vector<InteractionActor> &t) {
+            std::vector<std::pair<uint32_t, uint32_t>> ids;
+            for (const Interaction &p : result)
+                ids.emplace_back(a[p.actor].id, t[p.target].id);
+            std::sort(ids.begin(), ids.end());
+            return ids;
+        };
+        auto shuffledPredators = predators, shuffledVictims = victims;
+        std::shuffle(shuffledPredators.begin(), shuffledPredators.end(), rng);
+        std::shuffle(shuffledVictims.begin(), shuffledVictims.end(), rng);
+        std::vector<Interaction> shuffledPairs;
+        resolver.resolve(shuffledPredators, shuffledVictims, shuffledPairs);
+        FrameArena::get().reset();
+        if (toIds(pairs, predators, victims) != toIds(shuffledPairs, shuffledPredators, shuffledVictims)) {
+            printf("result depends on input order\n");
+            return 1;
+        }
+        if (count <= 10000)
+            printf("%10zu %12.1f %12.1f %10zu\n", count, scan, resolved, pairs.size());
+        else
+            printf("%10zu %12s %12.1f %10zu\n", count, "-", resolved, pairs.size());
+    }
+    return 0;
+}
@@ -0,0 +1,55 @@
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+#include "dungeon_generator.h"
+#include "level_file.h"
+
+// Сравнивает загрузку уровня из файла (mmap) с генерацией Dungeon того же размера
+// bench_level_loading [--width=2048] [--height=2048] [--rooms=20000] [--runs=10]
+int main(int argc, char* argv[])
+{
+    int width = 2048;
+    int height = 2048;
+    int rooms = 20000;
+    int runs = 10;
+    for (int i = 1; i < argc; i++) {
+        sscanf(argv[i], "--width=%d", &width);
+        sscanf(argv[i], "--height=%d", &height);
+        sscanf(argv[i], "--rooms=%d", &rooms);
+        sscanf(argv[i], "--runs=%d", &runs);
+    }
+    const char* path = "bench_level.lvl";
+    using Clock = std::chrono::steady_clock;
+    auto ms = [](Clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+
+    double generateMs = 0.0;
+    for (int r = 0; r < runs; r++) {
+        auto start = Clock::now();
+        Dungeon dungeon(width, height, rooms, 42u + r);
+        generateMs += ms(Clock::now() - start);
+        if (r == 0 && !save_level(dungeon, path))
+            return 1;
+    }
+
+    double loadMs = 0.0;
+    int floorCount = 0;
+    for (int r = 0; r < runs; r++) {
+        auto start = Clock::now();
+        auto dungeon = load_level(path);
+        if (!dungeon)
+            return 1;
+        // трогаем данные, чтобы учесть подкачку страниц
+        floorCount = 0;
+        for (int y = 0; y < dungeon->getHeight(); y += 64)
+            floorCount += dungeon->getTile(dungeon->getWidth() / 2, y) == Dungeon::FLOOR;
+        loadMs += ms(Clock::now() - start);
+    }
+    std::remove(path);
+
+    std::cout << width << "x" << height << ", " << rooms << " room attempts, " << runs << " runs\n"
+              << "Dungeon::generate: " << generateMs / runs << " ms\n"
+              << "load_level (mmap): " << loadMs / runs << " ms\n"
+              << "speedup: " << generateMs / loadMs << "x (" << floorCount << ")" << std::endl;
+    return 0;
+}
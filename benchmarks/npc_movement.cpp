@@ -0,0 +1,107 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "dungeon_generator.h"
+#include "npc_movement.h"
+#include "simd.h"
+#include "walkability_grid.h"
+
+// Случайное блуждание NPC: по объекту на агента (double, rand(), виртуальная проверка - как в Enemy)
+// против SoA-ядра move_npcs на каждом наборе команд процессора (см. simd.h), на 1k..1M агентов.
+// Результаты ядра на всех наборах команд сверяются
+// bench_npc_movement [--size=1024] [--ticks=100]
+struct IPassCheck {
+    virtual bool can_pass(int2 cell) = 0;
+    virtual ~IPassCheck() = default;
+};
+
+struct GridPassCheck : IPassCheck {
+    std::shared_ptr<WalkabilityGrid> grid;
+    explicit GridPassCheck(std::shared_ptr<WalkabilityGrid> grid) : grid(grid) {}
+    bool can_pass(int2 cell) override { return grid->can_pass(cell); }
+};
+
+struct ObjectNpc {
+    double x, y;
+    float speed, accumulator;
+    std::unique_ptr<IPassCheck> check;
+
+    void update(float dt) {
+        accumulator += dt * speed;
+        if (accumulator < 1.f)
+            return;
+        accumulator -= 1.f;
+        const int2 directions[] = { int2{1, 0}, int2{-1, 0}, int2{0, 1}, int2{0, -1} };
+        const int2 d = directions[rand() % 4];
+        if (check->can_pass(int2((int)x + d.x, (int)y + d.y))) {
+            x += d.x;
+            y += d.y;
+        }
+    }
+};
+
+int main(int argc, char *argv[])
+{
+    int size = 1024;
+    int ticks = 100;
+    for (int i = 1; i < argc; i++) {
+        sscanf(argv[i], "--size=%d", &size);
+        sscanf(argv[i], "--ticks=%d", &ticks);
+    }
+    auto dungeon = std::make_shared<Dungeon>(size, size, size * size / 400, 42u, 128);
+    auto grid = std::make_shared<WalkabilityGrid>(dungeon);
+    std::vector<int2> positions(1000000);
+    for (int2 &p : positions)
+        p = dungeon->getRandomFloorPosition();
+
+    using Clock = std::chrono::steady_clock;
+    const float dt = 1.f / 60.f;
+    const SimdLevel best = get_simd_level();
+    printf("%dx%d, %d ticks of %.4f s, ns per agent per tick\n", size, size, ticks, dt);
+    printf("  %8s %10s %10s %10s %10s\n", "agents", "objects", "scalar", "SSE2", "AVX2");
+    for (int agents : {1000, 10000, 100000, 1000000}) {
+        std::vector<ObjectNpc> objects;
+        NpcMovementArrays initial;
+        for (int i = 0; i < agents; i++) {
+            const float speed = i % 3 ? 10.f : 5.f;
+            objects.push_back(ObjectNpc{double(positions[i].x), double(positions[i].y), speed, 0.f,
+                                        std::make_unique<GridPassCheck>(grid)});
+            initial.add(positions[i], speed, uint32_t(i) * 2654435761u + 1);
+        }
+        std::vector<uint64_t> moved((agents + 63) / 64);
+        auto time = [&](auto &&tick) {
+            auto start = Clock::now();
+            for (int t = 0; t < ticks; t++)
+                tick();
+            return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / (double(ticks) * agents);
+        };
+        const double objectNs = time([&] {
+            for (ObjectNpc &npc : objects)
+                npc.update(dt);
+        });
+        char columns[3][16];
+        NpcMovementArrays scalar;
+        for (SimdLevel level : { SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Avx2 }) {
+            char *column = columns[int(level)];
+            if (level > best) {
+                snprintf(column, 16, "%10s", "-");
+                continue;
+            }
+            limit_simd_level(level);
+            NpcMovementArrays npcs = initial;
+            snprintf(column, 16, "%10.2f", time([&] { move_npcs(npcs, *grid, dt, moved); }));
+            if (level == SimdLevel::Scalar) {
+                scalar = npcs;
+            } else if (npcs.x != scalar.x || npcs.y != scalar.y || npcs.rng != scalar.rng || npcs.accumulator != scalar.accumulator) {
+                printf("%s and scalar kernels differ\n", get_simd_name(level));
+                return 1;
+            }
+        }
+        limit_simd_level(best);
+        printf("  %8d %10.2f %s %s %s\n", agents, objectNs, columns[0], columns[1], columns[2]);
+    }
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "dungeon_generator.h"
+#include "path_request_service.h"
+
+// Все агенты просят путь в одном кадре: сколько стоит кадр и за сколько кадров очередь рассасывается.
+// Половина агентов стоит группами в одних клетках и идёт к общим целям - такие запросы склеиваются и берутся из кэша
+// С рабочими потоками кадр длится --frame-ms, остаток кадра потоки ищут пути параллельно с "симуляцией"
+// --hierarchical=N - запросы дальше N клеток решает HierarchicalPathfinder
+// bench_path_requests [--agents=20000] [--size=1024] [--workers=0] [--budget=5000] [--frame-ms=16] [--hierarchical=0] [--seed=N]
+int main(int argc, char *argv[])
+{
+    int agents = 20000;
+    int size = 1024;
+    int workers = 0;
+    int budget = 5000;
+    int frameMs = 16;
+    int hierarchical = 0;
+    unsigned seed = 42;
+    for (int i = 1; i < argc; i++) {
+        sscanf(argv[i], "--agents=%d", &agents);
+        sscanf(argv[i], "--size=%d", &size);
+        sscanf(argv[i], "--workers=%d", &workers);
+        sscanf(argv[i], "--budget=%d", &budget);
+        sscanf(argv[i], "--frame-ms=%d", &frameMs);
+        sscanf(argv[i], "--hierarchical=%d", &hierarchical);
+        sscanf(argv[i], "--seed=%u", &seed);
+    }
+    using Clock = std::chrono::steady_clock;
+    auto dungeon = std::make_shared<Dungeon>(size, size, size * size / 400, seed, 128);
+    PathRequestService service(dungeon, workers, size_t(budget), 256, hierarchical);
+
+    std::vector<int2> groupStarts, groupGoals;
+    for (int i = 0; i < 64; i++) {
+        groupStarts.push_back(dungeon->getRandomFloorPosition());
+        groupGoals.push_back(dungeon->getRandomFloorPosition());
+    }
+    std::vector<std::pair<int2, int2>> requests;
+    for (int i = 0; i < agents; i++) {
+        if (i % 2)
+            requests.emplace_back(groupStarts[i % 64], groupGoals[(i / 64) % 64]);
+        else
+            requests.emplace_back(dungeon->getRandomFloorPosition(), dungeon->getRandomFloorPosition());
+    }
+    std::vector<PathRequestService::Ticket> tickets;
+    auto start = Clock::now();
+    for (auto [from, to] : requests)
+        tickets.push_back(service.request(from, to));
+    const double submitMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    int frames = 0, ready = 0, failed = 0;
+    double worstMs = 0, totalMs = 0;
+    size_t worstNodes = 0;
+    PathRequestService::Path path;
+    while (!tickets.empty()) {
+        auto frameStart = Clock::now();
+        service.update();
+        std::erase_if(tickets, [&](PathRequestService::Ticket ticket) {
+            switch (service.poll(ticket, path)) {
+            case PathRequestService::Status::Pending: return false;
+            case PathRequestService::Status::Ready: ready++; return true;
+            default: failed++; return true;
+            }
+        });
+        const double ms = std::chrono::duration<double, std::milli>(Clock::now() - frameStart).count();
+        worstMs = std::max(worstMs, ms);
+        totalMs += ms;
+        worstNodes = std::max(worstNodes, service.get_frame_nodes());
+        frames++;
+        if (workers > 0)
+            std::this_thread::sleep_until(frameStart + std::chrono::milliseconds(frameMs));
+    }
+    printf("%d agents on %dx%d, %d workers, budget %d nodes/frame: submitted in %.1f ms\n",
+           agents, size, size, workers, budget, submitMs);
+    printf("  %d frames, update %.2f ms/frame avg, %.2f ms worst, %zu nodes worst frame\n",
+           frames, totalMs / frames, worstMs, worstNodes);
+    printf("  %d ready, %d failed, %zu merged, %zu cache hits\n",
+           ready, failed, service.get_merged_requests(), service.get_cache_hits());
+    return 0;
+}
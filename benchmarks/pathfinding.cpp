@@ -0,0 +1,91 @@
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "dungeon_generator.h"
+#include "pathfinder.h"
+
+// Запросов в секунду для Pathfinder (A*, A* с фильтром, JPS) на уровне из игры (120x50) и на большой карте 2048x2048
+// bench_pathfinding [--queries=N] [--seed=N]
+struct BenchResult {
+    double queriesPerSecond;
+    double expandedPerQuery;
+    double pathLength;
+    int found;
+};
+
+template<typename Query>
+static BenchResult run_queries(const std::vector<std::pair<int2, int2>> &pairs, Query &&query)
+{
+    using Clock = std::chrono::steady_clock;
+    size_t expanded = 0, length = 0;
+    int found = 0;
+    std::vector<int2> path;
+    auto start = Clock::now();
+    for (auto [from, to] : pairs) {
+        size_t nodes = 0;
+        if (query(from, to, path, nodes)) {
+            found++;
+            length += path.size();
+        }
+        expanded += nodes;
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return BenchResult{pairs.size() / seconds, double(expanded) / pairs.size(), double(length) / std::max(found, 1), found};
+}
+
+static void print(const char *name, const BenchResult &r)
+{
+    printf("  %-28s %12.0f q/s  %10.1f expanded/q  %8.1f cells/path  (%d found)\n",
+           name, r.queriesPerSecond, r.expandedPerQuery, r.pathLength, r.found);
+}
+
+static void bench_level(int width, int height, int rooms, int queries, unsigned seed)
+{
+    auto dungeon = std::make_shared<Dungeon>(width, height, rooms, seed);
+    std::mt19937 rng(seed);
+    std::vector<std::pair<int2, int2>> pairs;
+    for (int i = 0; i < queries; i++)
+        pairs.emplace_back(dungeon->getRandomFloorPosition(), dungeon->getRandomFloorPosition());
+
+    // "хищники" - случайные 2% клеток пола, которые фильтр запрещает
+    std::vector<uint8_t> blocked(size_t(width) * height, 0);
+    for (int i = 0; i < dungeon->getFloorCount() / 50; i++) {
+        int2 p = dungeon->getRandomFloorPosition();
+        blocked[size_t(p.y) * width + p.x] = 1;
+    }
+
+    Pathfinder pathfinder(dungeon);
+    printf("%dx%d, %zu rooms, %d queries\n", width, height, dungeon->getRooms().size(), queries);
+    print("A*", run_queries(pairs, [&](int2 from, int2 to, std::vector<int2> &path, size_t &nodes) {
+        bool ok = pathfinder.find_path(from, to, path);
+        nodes = pathfinder.get_expanded_nodes();
+        return ok;
+    }));
+    print("A* + filter", run_queries(pairs, [&](int2 from, int2 to, std::vector<int2> &path, size_t &nodes) {
+        bool ok = pathfinder.find_path(from, to, path, [&](int2 c) { return !blocked[size_t(c.y) * width + c.x]; });
+        nodes = pathfinder.get_expanded_nodes();
+        return ok;
+    }));
+    print("JPS", run_queries(pairs, [&](int2 from, int2 to, std::vector<int2> &path, size_t &nodes) {
+        bool ok = pathfinder.find_path_jps(from, to, path);
+        nodes = pathfinder.get_expanded_nodes();
+        return ok;
+    }));
+}
+
+int main(int argc, char *argv[])
+{
+    int queries = 0;
+    unsigned seed = 42;
+    for (int i = 1; i < argc; i++) {
+        sscanf(argv[i], "--queries=%d", &queries);
+        sscanf(argv[i], "--seed=%u", &seed);
+    }
+    // размеры и число комнат как в init_world
+    bench_level(120, 50, 100, queries ? queries : 100000, seed);
+    bench_level(2048, 2048, 20000, queries ? queries : 200, seed);
+    return 0;
+}
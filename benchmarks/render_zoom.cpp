@@ -0,0 +1,142 @@
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "background_cache.h"
+#include "camera2d.h"
+#include "dungeon_overview.h"
+#include "dungeon_tiles.h"
+#include "frame_arena.h"
+#include "health.h"
+#include "random.h"
+#include "render_frame.h"
+#include "scene_index.h"
+#include "sprite.h"
+#include "stamina.h"
+#include "world.h"
+
+void build_render_frame(World& world, int screenW, int screenH, RenderFrame& frame);
+void draw_render_frame(SDL_Renderer* renderer, const RenderFrame& frame, ChunkTextures& chunkTextures,
+                       OverviewTextures& overviewTextures, SpriteBatch& batch);
+
+// Время кадра при отдалении камеры от 64 до 1/16 пикселя на клетку на программном рендерере SDL
+// (в SDL_Surface --width x --height): карта --size x --size, --agents сущностей со спрайтом и
+// полосками здоровья и усталости, --edits правок карты за кадр, камера идёт вдоль диагонали.
+// "build" - build_render_frame на потоке симуляции, "draw" - draw_render_frame с перерисовками
+// кусков фона и загрузками обзорной карты; "worst" - самый долгий кадр, обычно первый после
+// смены масштаба. Ниже LodPixelsPerMeter (render.cpp) кадр рисуется из DungeonOverview,
+// и его время не должно расти с отдалением
+// bench_render_zoom [--size=2048] [--agents=100000] [--edits=16] [--width=1600] [--height=1200] [--frames=20]
+int main(int argc, char *argv[])
+{
+    int size = 2048;
+    int agents = 100000;
+    int edits = 16;
+    int width = 1600, height = 1200;
+    int frames = 20;
+    for (int i = 1; i < argc; i++) {
+        sscanf(argv[i], "--size=%d", &size);
+        sscanf(argv[i], "--agents=%d", &agents);
+        sscanf(argv[i], "--edits=%d", &edits);
+        sscanf(argv[i], "--width=%d", &width);
+        sscanf(argv[i], "--height=%d", &height);
+        sscanf(argv[i], "--frames=%d", &frames);
+    }
+    SDL_Surface *target = SDL_CreateSurface(width, height, SDL_PIXELFORMAT_RGBA32);
+    SDL_Renderer *renderer = target ? SDL_CreateSoftwareRenderer(target) : nullptr;
+    if (!renderer) {
+        fprintf(stderr, "Failed to create the software renderer: %s\n", SDL_GetError());
+        return 1;
+    }
+    // атлас 64x16: два пола, стена и сущность
+    SDL_Surface *atlasSurface = SDL_CreateSurface(64, 16, SDL_PIXELFORMAT_RGBA32);
+    if (!atlasSurface) {
+        fprintf(stderr, "Failed to create the atlas: %s\n", SDL_GetError());
+        return 1;
+    }
+    for (int y = 0; y < 16; y++)
+        for (int x = 0; x < 64; x++)
+            ((uint32_t *)((uint8_t *)atlasSurface->pixels + y * atlasSurface->pitch))[x] = 0xff000000u | ((x / 16) * 0x400000) | (y * 0x0800);
+    TexturePtr atlas(SDL_CreateTextureFromSurface(renderer, atlasSurface), SDL_DestroyTexture);
+    SDL_DestroySurface(atlasSurface);
+    if (!atlas) {
+        fprintf(stderr, "Failed to create the atlas texture: %s\n", SDL_GetError());
+        return 1;
+    }
+    auto tile = [&](int i) { return Sprite(atlas, SDL_FRect{ float(i * 16), 0.f, 16.f, 16.f }); };
+
+    auto world = std::make_shared<World>();
+    auto camera = world->create_object();
+    auto camera2d = camera->add_component<Camera2D>(32.f);
+    auto cameraTransform = camera->add_component<Transform2D>(0.f, 0.f);
+
+    auto dungeon = std::make_shared<Dungeon>(size, size, size * size / 400, 42u, size > 256 ? 128 : 0);
+    auto tiles = world->add_service(std::make_shared<DungeonTiles>());
+    tiles->dungeon = dungeon;
+    tiles->floor[0] = tile(0);
+    tiles->floor[1] = tile(1);
+    tiles->wall = tile(2);
+    world->add_service(std::make_shared<BackgroundCache>(tiles, ChunkTextures::is_supported(renderer)));
+    world->add_service(std::make_shared<DungeonOverview>(tiles));
+
+    Random random(1);
+    for (int i = 0; i < agents; i++) {
+        auto agent = world->create_object();
+        const int2 cell = dungeon->getFloorPosition(random.get_int(uint32_t(dungeon->getFloorCount()), uint32_t(i), 0, SpawnPosition));
+        agent->add_component<Sprite>(tile(3));
+        agent->add_component<Transform2D>(float(cell.x), float(cell.y));
+        agent->add_component<Health>(100);
+        agent->add_component<Stamina>(100);
+    }
+    world->update(0.f);
+    // сущности стоят на месте, индекс строится один раз
+    auto scene = world->add_service(std::make_shared<SceneIndex>(size, size));
+    scene->rebuild(*world, nullptr);
+
+    RenderFrame frame;
+    ChunkTextures chunkTextures;
+    OverviewTextures overviewTextures;
+    SpriteBatch batch;
+    using Clock = std::chrono::steady_clock;
+    auto ms = [](Clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+    printf("%dx%d map, %d agents, %d edits per frame, %dx%d software renderer, ms per frame\n", size, size, agents, edits,
+           width, height);
+    printf("%10s %10s %10s %10s %10s\n", "px/cell", "build", "draw", "worst", "items");
+
+    uint32_t editIndex = 0;
+    for (float ppm : { 64.f, 32.f, 16.f, 8.f, 4.f, 2.f, 1.f, 0.5f, 0.25f, 0.125f, 0.0625f }) {
+        camera2d->pixelsPerMeter = ppm;
+        double build = 0, draw = 0, worst = 0;
+        size_t items = 0;
+        for (int f = 0; f < frames; f++) {
+            // камера проходит по диагонали карты
+            cameraTransform->x = cameraTransform->y = float(size) * (f + 0.5f) / frames;
+            for (int e = 0; e < edits; e++, editIndex++) {
+                const uint32_t x = random.get_int(uint32_t(size), editIndex, 0, WanderStep, 0);
+                const uint32_t y = random.get_int(uint32_t(size), editIndex, 0, WanderStep, 1);
+                dungeon->setTile(int(x), int(y), dungeon->isFloor(int(x), int(y)) ? Dungeon::WALL : Dungeon::FLOOR);
+            }
+
+            auto begin = Clock::now();
+            build_render_frame(*world, width, height, frame);
+            auto built = Clock::now();
+            SDL_RenderClear(renderer);
+            draw_render_frame(renderer, frame, chunkTextures, overviewTextures, batch);
+            auto drawn = Clock::now();
+            FrameArena::get().reset();
+
+            build += ms(built - begin);
+            draw += ms(drawn - built);
+            worst = std::max(worst, ms(drawn - begin));
+            items += frame.queue.size();
+        }
+        printf("%10g %10.3f %10.3f %10.3f %10zu\n", ppm, build / frames, draw / frames, worst, items / frames);
+    }
+
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroySurface(target);
+    return 0;
+}
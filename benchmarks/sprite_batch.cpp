@@ -0,0 +1,110 @@
+#include <SDL3/SDL.h>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "random.h"
+#include "sprite.h"
+#include "sprite_batch.h"
+
+// Кадры в секунду на программном рендерере SDL (в SDL_Surface --width x --height) для 10k..1M
+// спрайтов 16x16 из одного атласа, у каждого полоска здоровья (фон и заполнение):
+// "calls" - как было: SDL_RenderTexture на спрайт и SDL_RenderFillRects на полоски;
+// "batch" - SpriteBatch, один SDL_RenderGeometry на слой и текстуру
+// bench_sprite_batch [--width=1600] [--height=1200] [--frames=5]
+int main(int argc, char *argv[])
+{
+    int width = 1600, height = 1200;
+    int frames = 5;
+    for (int i = 1; i < argc; i++) {
+        sscanf(argv[i], "--width=%d", &width);
+        sscanf(argv[i], "--height=%d", &height);
+        sscanf(argv[i], "--frames=%d", &frames);
+    }
+    SDL_Surface *target = SDL_CreateSurface(width, height, SDL_PIXELFORMAT_RGBA32);
+    SDL_Renderer *renderer = target ? SDL_CreateSoftwareRenderer(target) : nullptr;
+    if (!renderer) {
+        fprintf(stderr, "Failed to create the software renderer: %s\n", SDL_GetError());
+        return 1;
+    }
+    // атлас 256x256 из клеток 16x16 разного цвета
+    SDL_Surface *atlasSurface = SDL_CreateSurface(256, 256, SDL_PIXELFORMAT_RGBA32);
+    if (!atlasSurface) {
+        fprintf(stderr, "Failed to create the atlas: %s\n", SDL_GetError());
+        return 1;
+    }
+    for (int y = 0; y < 256; y++)
+        for (int x = 0; x < 256; x++)
+            ((uint32_t *)((uint8_t *)atlasSurface->pixels + y * atlasSurface->pitch))[x] = 0xff000000u | ((x / 16) * 0x10) | ((y / 16) * 0x1000);
+    TexturePtr atlas(SDL_CreateTextureFromSurface(renderer, atlasSurface), SDL_DestroyTexture);
+    SDL_DestroySurface(atlasSurface);
+    if (!atlas) {
+        fprintf(stderr, "Failed to create the atlas texture: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    Random random(1);
+    using Clock = std::chrono::steady_clock;
+    auto seconds = [](Clock::duration d) { return std::chrono::duration<double>(d).count(); };
+    printf("%dx%d software renderer, frames per second (draw calls per frame)\n", width, height);
+    printf("%10s %22s %22s\n", "sprites", "calls", "batch");
+
+    SpriteBatch batch;
+    for (size_t count : { size_t(10000), size_t(100000), size_t(1000000) }) {
+        std::vector<Sprite> sprites(count);
+        std::vector<SDL_FRect> dst(count), backBars(count), healthBars(count);
+        for (size_t i = 0; i < count; i++) {
+            const uint32_t tile = random.get_int(256, uint32_t(i), 0, SpawnKind);
+            sprites[i] = Sprite(atlas, SDL_FRect{ float(tile % 16 * 16), float(tile / 16 * 16), 16.f, 16.f });
+            dst[i] = SDL_FRect{ random.get_float(uint32_t(i), 0, SpawnPosition, 0) * (width - 16),
+                                random.get_float(uint32_t(i), 0, SpawnPosition, 1) * (height - 16), 16.f, 16.f };
+            backBars[i] = SDL_FRect{ dst[i].x, dst[i].y, 2.f, 16.f };
+            const float value = random.get_float(uint32_t(i), 0, SpawnPosition, 2);
+            healthBars[i] = SDL_FRect{ dst[i].x, dst[i].y + (1.f - value) * 16.f, 2.f, value * 16.f };
+        }
+
+        auto calls = [&] {
+            for (size_t i = 0; i < count; i++)
+                DrawSprite(renderer, sprites[i], dst[i]);
+            SDL_SetRenderDrawColorFloat(renderer, 0.2f, 0.2f, 0.2f, 1.f);
+            SDL_RenderFillRects(renderer, backBars.data(), int(count));
+            SDL_SetRenderDrawColorFloat(renderer, 0.91f, 0.27f, 0.22f, 1.f);
+            SDL_RenderFillRects(renderer, healthBars.data(), int(count));
+            return count + 2;
+        };
+        auto batched = [&] {
+            batch.set_layer(0);
+            for (size_t i = 0; i < count; i++)
+                batch.add(sprites[i], dst[i]);
+            batch.set_layer(1);
+            for (size_t i = 0; i < count; i++) {
+                batch.add_rect(backBars[i], SDL_FColor{ 0.2f, 0.2f, 0.2f, 1.f });
+                batch.add_rect(healthBars[i], SDL_FColor{ 0.91f, 0.27f, 0.22f, 1.f });
+            }
+            batch.flush(renderer);
+            return batch.get_draw_calls();
+        };
+        auto fps = [&](auto &&draw, size_t &drawCalls) {
+            // первый кадр - прогрев
+            double spent = 0;
+            for (int f = 0; f <= frames; f++) {
+                auto begin = Clock::now();
+                SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+                SDL_RenderClear(renderer);
+                drawCalls = draw();
+                SDL_RenderPresent(renderer);
+                if (f)
+                    spent += seconds(Clock::now() - begin);
+            }
+            return frames / spent;
+        };
+        size_t callsDraws = 0, batchDraws = 0;
+        const double callsFps = fps(calls, callsDraws);
+        const double batchFps = fps(batched, batchDraws);
+        printf("%10zu %10.1f (%9zu) %10.1f (%9zu)\n", count, callsFps, callsDraws, batchFps, batchDraws);
+    }
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroySurface(target);
+    return 0;
+}
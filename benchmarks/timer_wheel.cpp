@@ -0,0 +1,61 @@
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "timer_wheel.h"
+
+// 1k..1M таймеров с периодами от 1 до --maxPeriod секунд, --ticks кадров по 1/60 с.
+// "accumulators" - у каждого таймера свой счётчик времени, который проверяется каждый кадр
+// (как было в StarvationSystem и FoodGenerator), "wheel" - TimerWheel.
+// Число срабатываний обоих вариантов должно совпасть
+// bench_timer_wheel [--ticks=600] [--maxPeriod=60]
+int main(int argc, char *argv[])
+{
+    int ticks = 600;
+    int maxPeriod = 60;
+    for (int i = 1; i < argc; i++) {
+        sscanf(argv[i], "--ticks=%d", &ticks);
+        sscanf(argv[i], "--maxPeriod=%d", &maxPeriod);
+    }
+    using Clock = std::chrono::steady_clock;
+    auto ms = [](Clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+    const float dt = 1.f / 60.f;
+    printf("periodic timers of 1..%d s, %d ticks of %.4f s, ms per tick\n", maxPeriod, ticks, dt);
+    printf("%10s %14s %14s %12s\n", "timers", "accumulators", "wheel", "fired/tick");
+
+    for (size_t count : { size_t(1000), size_t(100000), size_t(1000000) }) {
+        // периоды кратны шагу колеса, чтобы оба варианта срабатывали на одних и тех же кадрах
+        std::vector<int> periods(count);
+        for (size_t i = 0; i < count; i++)
+            periods[i] = 60 * (1 + int(i * 2654435761u % uint32_t(maxPeriod)));
+
+        std::vector<int> accumulators(count, 0);
+        size_t scanned = 0;
+        auto begin = Clock::now();
+        for (int t = 0; t < ticks; t++) {
+            for (size_t i = 0; i < count; i++) {
+                if (++accumulators[i] >= periods[i]) {
+                    accumulators[i] = 0;
+                    scanned++;
+                }
+            }
+        }
+        const double scan = ms(Clock::now() - begin) / ticks;
+
+        TimerWheel wheel(dt);
+        size_t fired = 0;
+        for (size_t i = 0; i < count; i++)
+            wheel.every(periods[i] * dt, [&fired] { fired++; });
+        begin = Clock::now();
+        for (int t = 0; t < ticks; t++)
+            wheel.advance(dt);
+        const double wheeled = ms(Clock::now() - begin) / ticks;
+        if (fired != scanned) {
+            printf("%zu timers fired instead of %zu\n", fired, scanned);
+            return 1;
+        }
+        printf("%10zu %14.3f %14.3f %12.1f\n", count, scan, wheeled, double(fired) / ticks);
+    }
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "health.h"
+#include "simd.h"
+#include "stamina.h"
+#include "vitals.h"
+#include "world.h"
+
+// Голод и усталость для 1k..1M объектов: прежний обход всех объектов с get_component
+// и change() у каждого против одного прохода drain_vitals по столбцам Vitals: скалярного, SSE2 и AVX2
+// (столбец "-", если процессор его не умеет, см. simd.h).
+// "slice" - самый долгий кадр, если проход разложен на --slices кадров
+// bench_vitals [--repeats=20] [--slices=8]
+
+// Health и Stamina в том виде, что были до Vitals: значения внутри объекта
+struct ObjectHealth : Component {
+    int current, max;
+    ObjectHealth(int value) : current(value), max(value) {}
+    void change(int delta) {
+        current += delta;
+        if (current > max) current = max;
+        if (current < 0) current = 0;
+    }
+};
+struct ObjectStamina : ObjectHealth {
+    using ObjectHealth::ObjectHealth;
+};
+
+int main(int argc, char *argv[])
+{
+    int repeats = 20;
+    int slices = 8;
+    for (int i = 1; i < argc; i++) {
+        sscanf(argv[i], "--repeats=%d", &repeats);
+        sscanf(argv[i], "--slices=%d", &slices);
+    }
+    using Clock = std::chrono::steady_clock;
+    auto ms = [](Clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+    printf("health -2 and stamina -5 for every object, ms per pass, %d repeats\n", repeats);
+    printf("%10s %10s %10s %10s %10s %10s %8s\n", "objects", "objects", "scalar", "SSE2", "AVX2", "slice", "deaths");
+    const SimdLevel best = get_simd_level();
+
+    for (size_t count : { size_t(1000), size_t(100000), size_t(1000000) }) {
+        auto world = std::make_shared<World>();
+        for (size_t i = 0; i < count; i++) {
+            auto obj = world->create_object();
+            // часть объектов умирает на первом же проходе
+            const int hp = int(i % 50) + 1;
+            obj->add_component<ObjectHealth>(100)->current = hp;
+            obj->add_component<ObjectStamina>(100);
+            obj->add_component<Health>(100)->set(hp);
+            obj->add_component<Stamina>(100);
+        }
+        world->update(0.f);
+        auto vitals = world->get_service<Vitals>();
+
+        auto begin = Clock::now();
+        size_t objectDeaths = 0;
+        for (int r = 0; r < repeats; r++) {
+            for (auto &obj : world->get_objects()) {
+                if (auto health = obj->get_component<ObjectHealth>()) {
+                    health->change(-2);
+                    objectDeaths += health->current <= 0;
+                }
+                if (auto stamina = obj->get_component<ObjectStamina>())
+                    stamina->change(-5);
+            }
+        }
+        const double objects = ms(Clock::now() - begin) / repeats;
+
+        // обе версии прогоняются по одинаковым копиям столбцов
+        const Vitals initial = *vitals;
+        const uint16_t drain[VitalKindCount] = { 2, 5 };
+        std::vector<uint32_t> scalarEmptied, simdEmptied;
+        auto run = [&](auto &&pass, std::vector<uint32_t> &emptied) {
+            *vitals = initial;
+            double total = 0;
+            size_t deaths = 0;
+            for (int r = 0; r < repeats; r++) {
+                emptied.clear();
+                auto start = Clock::now();
+                pass(emptied);
+                total += ms(Clock::now() - start);
+                deaths += emptied.size();
+            }
+            return std::make_pair(total / repeats, deaths);
+        };
+        const auto [scalar, scalarDeaths] = run([&](std::vector<uint32_t> &e) {
+            drain_vitals_scalar(*vitals, drain, 0, vitals->size(), e);
+        }, scalarEmptied);
+        const Vitals scalarResult = *vitals;
+        char columns[2][16];
+        for (SimdLevel level : { SimdLevel::Sse2, SimdLevel::Avx2 }) {
+            char *column = columns[level == SimdLevel::Avx2];
+            if (level > best) {
+                snprintf(column, 16, "%10s", "-");
+                continue;
+            }
+            limit_simd_level(level);
+            const auto [simd, simdDeaths] = run([&](std::vector<uint32_t> &e) {
+                drain_vitals(*vitals, drain, 0, vitals->size(), e);
+            }, simdEmptied);
+            if (scalarEmptied != simdEmptied || scalarDeaths != simdDeaths || scalarDeaths != objectDeaths
+                || scalarResult.current[VitalHealth] != vitals->current[VitalHealth]
+                || scalarResult.current[VitalStamina] != vitals->current[VitalStamina]) {
+                printf("%s and scalar passes differ\n", get_simd_name(level));
+                return 1;
+            }
+            snprintf(column, 16, "%10.3f", simd);
+        }
+        limit_simd_level(best);
+
+        *vitals = initial;
+        double slice = 0;
+        std::vector<uint32_t> emptied;
+        for (int s = 0; s < slices; s++) {
+            auto start = Clock::now();
+            drain_vitals(*vitals, drain, vitals->size() * s / slices, vitals->size() * (s + 1) / slices, emptied);
+            slice = std::max(slice, ms(Clock::now() - start));
+        }
+        printf("%10zu %10.3f %10.3f %s %s %10.3f %8zu\n", count, objects, scalar, columns[0], columns[1], slice, scalarDeaths / repeats);
+        *vitals = initial; // строки отвязываются от компонентов при удалении мира
+    }
+    return 0;
+}
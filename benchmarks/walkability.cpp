@@ -0,0 +1,90 @@
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "dungeon_generator.h"
+#include "simd.h"
+#include "walkability_grid.h"
+
+// Проверка шага для множества агентов: виртуальный can_pass на агента (как было с IRestrictor),
+// встраиваемый WalkabilityGrid::can_pass и пакетный can_pass по всем позициям сразу
+// на каждом наборе команд, который есть у процессора (см. simd.h)
+// bench_walkability [--agents=100000] [--size=1024] [--frames=200]
+struct IPassCheck {
+    virtual bool can_pass(int2 cell) = 0;
+    virtual ~IPassCheck() = default;
+};
+
+struct DungeonPassCheck : IPassCheck {
+    std::shared_ptr<Dungeon> dungeon;
+    explicit DungeonPassCheck(std::shared_ptr<Dungeon> dungeon) : dungeon(dungeon) {}
+    bool can_pass(int2 cell) override { return dungeon->isFloor(cell.x, cell.y); }
+};
+
+int main(int argc, char *argv[])
+{
+    int agents = 100000;
+    int size = 1024;
+    int frames = 200;
+    for (int i = 1; i < argc; i++) {
+        sscanf(argv[i], "--agents=%d", &agents);
+        sscanf(argv[i], "--size=%d", &size);
+        sscanf(argv[i], "--frames=%d", &frames);
+    }
+    auto dungeon = std::make_shared<Dungeon>(size, size, size * size / 400, 42u, 128);
+    WalkabilityGrid grid(dungeon);
+
+    // по агенту на свой экземпляр проверки, как раньше в init_world
+    std::vector<std::unique_ptr<IPassCheck>> perAgent;
+    std::vector<int2> candidates;
+    std::mt19937 rng(1);
+    const int2 steps[4] = { int2{1, 0}, int2{-1, 0}, int2{0, 1}, int2{0, -1} };
+    for (int i = 0; i < agents; i++) {
+        perAgent.push_back(std::make_unique<DungeonPassCheck>(dungeon));
+        const int2 pos = dungeon->getRandomFloorPosition();
+        const int2 step = steps[rng() % 4];
+        candidates.push_back(int2{pos.x + step.x, pos.y + step.y});
+    }
+    std::vector<uint64_t> mask((candidates.size() + 63) / 64);
+
+    using Clock = std::chrono::steady_clock;
+    auto run = [&](const char *name, auto &&frame) {
+        size_t passed = 0;
+        auto start = Clock::now();
+        for (int f = 0; f < frames; f++)
+            passed += frame();
+        const double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        printf("  %-14s %8.2f ns/agent  (%zu passed)\n", name, ns / (double(frames) * agents), passed / frames);
+    };
+    printf("%d agents on %dx%d\n", agents, size, size);
+    run("virtual", [&] {
+        size_t passed = 0;
+        for (int i = 0; i < agents; i++)
+            passed += perAgent[i]->can_pass(candidates[i]);
+        return passed;
+    });
+    run("inline", [&] {
+        size_t passed = 0;
+        for (int i = 0; i < agents; i++)
+            passed += grid.can_pass(candidates[i]);
+        return passed;
+    });
+    const SimdLevel best = get_simd_level();
+    for (SimdLevel level : { SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Avx2 }) {
+        if (level > best)
+            break;
+        limit_simd_level(level);
+        char name[32];
+        snprintf(name, sizeof(name), "batch %s", get_simd_name(level));
+        run(name, [&] {
+            grid.can_pass(candidates, mask);
+            size_t passed = 0;
+            for (uint64_t word : mask)
+                passed += std::popcount(word);
+            return passed;
+        });
+    }
+    return 0;
+}
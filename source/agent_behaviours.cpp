@@ -0,0 +1,62 @@
+#include "agent_behaviours.h"
+
+static uint16_t action_id(AgentAction action)
+{
+    return uint16_t(action);
+}
+
+FsmDefinition make_herbivore_fsm()
+{
+    FsmDefinition fsm;
+    fsm.states = {
+        { "Wander", action_id(AgentAction::Wander) },
+        { "Forage", action_id(AgentAction::Forage) },
+        { "Flee", action_id(AgentAction::Flee) },
+    };
+    fsm.transitions = {
+        // бегство важнее всего, из любого состояния
+        { FsmDefinition::AnyState, "Flee", ThreatNear },
+        { "Wander", "Forage", Hungry | FoodKnown },
+        { "Forage", "Wander", 0, Hungry },
+        { "Forage", "Wander", 0, FoodKnown },
+        { "Flee", "Forage", Hungry | FoodKnown },
+        { "Flee", "Wander", 0, ThreatNear },
+    };
+    return fsm;
+}
+
+BehaviourTreeDefinition make_herbivore_tree()
+{
+    BehaviourTreeDefinition tree;
+    tree.root = tree.selector({
+        tree.sequence({ tree.condition(ThreatNear), tree.action(action_id(AgentAction::Flee), "Flee") }),
+        tree.sequence({ tree.condition(Hungry), tree.condition(FoodKnown),
+                        tree.action(action_id(AgentAction::Forage), "Forage") }),
+        tree.action(action_id(AgentAction::Wander), "Wander"),
+    });
+    return tree;
+}
+
+FsmDefinition make_predator_fsm()
+{
+    FsmDefinition fsm;
+    fsm.states = {
+        { "Roam", action_id(AgentAction::Wander) },
+        { "Hunt", action_id(AgentAction::Hunt) },
+    };
+    fsm.transitions = {
+        { "Roam", "Hunt", PreyNear },
+        { "Hunt", "Roam", 0, PreyNear },
+    };
+    return fsm;
+}
+
+BehaviourTreeDefinition make_predator_tree()
+{
+    BehaviourTreeDefinition tree;
+    tree.root = tree.selector({
+        tree.sequence({ tree.condition(PreyNear), tree.action(action_id(AgentAction::Hunt), "Hunt") }),
+        tree.action(action_id(AgentAction::Wander), "Roam"),
+    });
+    return tree;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "behaviour.h"
+
+// Факты, которые игра собирает для каждого агента перед think()
+enum AgentFact : BehaviourFacts {
+    ThreatNear = 1u << 0, // хищник ближе FleeDistance
+    Hungry     = 1u << 1, // здоровье ниже порога
+    FoodKnown  = 1u << 2, // до еды есть путь
+    PreyNear   = 1u << 3, // травоядное ближе HuntDistance
+};
+
+// Что делает агент в своём состоянии (BehaviourProgram::State::action)
+enum class AgentAction : uint16_t {
+    Wander,
+    Forage,
+    Flee,
+    Hunt,
+};
+
+// Поведение травоядных: убегать от хищника, голодным идти к еде, иначе бродить.
+// FSM и дерево описывают одно и то же и дают одинаковые состояния на любых фактах
+FsmDefinition make_herbivore_fsm();
+BehaviourTreeDefinition make_herbivore_tree();
+// Поведение хищников: гнаться за травоядным поблизости, иначе бродить
+FsmDefinition make_predator_fsm();
+BehaviourTreeDefinition make_predator_tree();
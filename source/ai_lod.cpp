@@ -0,0 +1,31 @@
+#include "ai_lod.h"
+
+#include <algorithm>
+#include <bit>
+
+AiLod::AiLod(int nearCells, uint32_t farPeriod)
+    : nearCells(nearCells), farPeriod(std::bit_ceil(std::max(farPeriod, 1u)))
+{
+}
+
+void AiLod::set_active_points(std::span<const int2> points, const SpatialIndex &index, std::span<const uint32_t> ids)
+{
+    nearEntities.clear();
+    if (seen.size() < ids.size())
+        seen.resize(ids.size(), generation);
+    generation++;
+    const int cellSize = SpatialIndex::CellSize;
+    for (int2 point : points) {
+        // прямоугольник из целых крупных клеток: запрос вернёт ровно их точки
+        const int cx = point.x / cellSize, cy = point.y / cellSize;
+        items.clear();
+        index.query(int2((cx - nearCells) * cellSize, (cy - nearCells) * cellSize),
+                    int2((cx + nearCells + 1) * cellSize - 1, (cy + nearCells + 1) * cellSize - 1), items);
+        for (uint32_t item : items) {
+            if (item >= ids.size() || seen[item] == generation)
+                continue;
+            seen[item] = generation;
+            nearEntities.push_back(ids[item]);
+        }
+    }
+}
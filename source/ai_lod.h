@@ -0,0 +1,38 @@
+#pragma once
+
+#include "math2d.h"
+#include "spatial_index.h"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Уровень детализации ИИ. Ближние сущности - те, что по пространственному индексу сцены стоят
+// в крупных клетках SpatialIndex::CellSize в радиусе nearCells от камеры или игрока; они обновляются каждый тик.
+// Список собирается запросом к индексу и стоит столько, сколько сущностей рядом, а не на всей карте.
+// Дальние агенты разложены по farPeriod корзинам (по номеру сущности) и обновляются раз
+// в farPeriod тиков (округляется вверх до степени двойки), получая всё накопленное с прошлого обновления время
+class AiLod {
+public:
+    explicit AiLod(int nearCells = 2, uint32_t farPeriod = 8);
+
+    // Камеры и игроки этого тика; ids[i] - номер сущности точки i индекса index
+    void set_active_points(std::span<const int2> points, const SpatialIndex &index, std::span<const uint32_t> ids);
+
+    // Номера сущностей рядом с точками, каждый по разу
+    std::span<const uint32_t> get_near_entities() const { return nearEntities; }
+
+    // Корзина дальней сущности entity; на тике tick обновляется корзина get_due_bucket(tick)
+    uint32_t get_bucket(uint32_t entity) const { return entity & (farPeriod - 1); }
+    uint32_t get_due_bucket(uint32_t tick) const { return (0u - tick) & (farPeriod - 1); }
+
+    uint32_t get_far_period() const { return farPeriod; }
+
+private:
+    int nearCells;
+    uint32_t farPeriod;
+    std::vector<uint32_t> nearEntities;
+    std::vector<uint32_t> items;
+    // отметки уже собранных точек индекса: точки рядом с двумя наблюдателями не повторяются
+    std::vector<uint32_t> seen;
+    uint32_t generation = 0;
+};
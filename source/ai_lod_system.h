@@ -0,0 +1,34 @@
+#pragma once
+
+#include "component.h"
+#include "game_object.h"
+#include "world.h"
+#include "ai_lod.h"
+#include "scene_index.h"
+#include "transform2d.h"
+
+// Feeds camera and player positions to AiLod once per tick, before the AI systems run.
+// Near agents are looked up in the SceneIndex, which still holds the previous tick's positions
+class AiLodSystem : public Component {
+    std::shared_ptr<AiLod> lod;
+    std::vector<std::weak_ptr<GameObject>> watchers;
+    std::vector<int2> points;
+public:
+    AiLodSystem(std::shared_ptr<AiLod> lod)
+        : lod(lod) {}
+
+    void add_watcher(GameObjectPtr watcher) {
+        watchers.push_back(watcher);
+    }
+
+    void on_update(float dt) override {
+        points.clear();
+        std::erase_if(watchers, [](const std::weak_ptr<GameObject> &watcher) { return watcher.expired(); });
+        for (auto &watcher : watchers) {
+            if (auto transform = watcher.lock()->get_component<Transform2D>())
+                points.push_back(int2((int)transform->x, (int)transform->y));
+        }
+        if (auto scene = get_owner()->get_world()->get_service<SceneIndex>())
+            lod->set_active_points(points, scene->get_entity_index(), scene->get_entity_ids());
+    }
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Выбор номера с заданными весами за O(1) (метод Уолкера/Vose): каждый столбец таблицы
+// хранит порог и запасной номер. Выбор - один равномерный столбец и одно сравнение,
+// оба числа берутся снаружи (например, из Random), так что общего состояния нет
+class AliasTable {
+public:
+    // Веса >= 0; если все нули или их нет, таблица пуста
+    void build(std::span<const double> weights) {
+        const size_t n = weights.size();
+        threshold.assign(n, UINT32_MAX);
+        alias.resize(n);
+        double sum = 0;
+        for (double w : weights)
+            sum += w > 0 ? w : 0;
+        if (n == 0 || sum <= 0) {
+            threshold.clear();
+            alias.clear();
+            return;
+        }
+        // доля каждого столбца в единицах "средний вес"
+        std::vector<double> scaled(n);
+        std::vector<uint32_t> small, large;
+        for (size_t i = 0; i < n; i++) {
+            scaled[i] = (weights[i] > 0 ? weights[i] : 0) * double(n) / sum;
+            alias[i] = uint32_t(i);
+            (scaled[i] < 1.0 ? small : large).push_back(uint32_t(i));
+        }
+        while (!small.empty() && !large.empty()) {
+            const uint32_t s = small.back(), l = large.back();
+            small.pop_back();
+            threshold[s] = uint32_t(scaled[s] * 4294967296.0);
+            alias[s] = l;
+            scaled[l] -= 1.0 - scaled[s];
+            if (scaled[l] < 1.0) {
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+        // оставшиеся (в том числе из-за округления) берут свой столбец целиком, alias[i] == i
+    }
+
+    size_t size() const { return alias.size(); }
+    bool empty() const { return alias.empty(); }
+
+    // column и coin - равномерные 32-битные числа
+    uint32_t sample(uint32_t column, uint32_t coin) const {
+        const uint32_t i = uint32_t((uint64_t(column) * alias.size()) >> 32);
+        return coin < threshold[i] ? i : alias[i];
+    }
+
+private:
+    std::vector<uint32_t> threshold; // доля своего номера в столбце, из 2^32
+    std::vector<uint32_t> alias;
+};
@@ -0,0 +1,166 @@
+#include "background_cache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+uint64_t BackgroundCache::hash_chunk(int cx, int cy) const
+{
+    // FNV-1a по проходимости и варианту каждой клетки
+    uint64_t hash = 14695981039346656037ull;
+    const int x1 = std::min((cx + 1) * ChunkCells, dungeon->getWidth());
+    const int y1 = std::min((cy + 1) * ChunkCells, dungeon->getHeight());
+    for (int y = cy * ChunkCells; y < y1; y++)
+        for (int x = cx * ChunkCells; x < x1; x++) {
+            const uint8_t cell = uint8_t(dungeon->isFloor(x, y) ? 1 + dungeon->getVariant(x, y) : 0);
+            hash = (hash ^ cell) * 1099511628211ull;
+        }
+    return hash;
+}
+
+void BackgroundCache::redraw_chunk(int cx, int cy, uint32_t texture, BackgroundCommands &commands) const
+{
+    const uint32_t first = uint32_t(commands.tiles.size());
+    const float size = float(pixelsPerCell);
+    const int x1 = std::min((cx + 1) * ChunkCells, dungeon->getWidth());
+    const int y1 = std::min((cy + 1) * ChunkCells, dungeon->getHeight());
+    for (int y = cy * ChunkCells; y < y1; y++)
+        for (int x = cx * ChunkCells; x < x1; x++) {
+            const Sprite &sprite = dungeon->isFloor(x, y) ? tiles->floor[dungeon->getVariant(x, y)] : tiles->wall;
+            commands.tiles.push_back(BackgroundCommands::Tile{
+                sprite.texture.get(), sprite.src,
+                SDL_FRect{ (x - cx * ChunkCells) * size, (y - cy * ChunkCells) * size, size, size } });
+        }
+    commands.redraws.push_back(BackgroundCommands::Redraw{ texture, first, uint32_t(commands.tiles.size()) - first });
+}
+
+bool BackgroundCache::update(int2 viewMin, int2 viewMax, float pixelsPerMeter, BackgroundCommands &commands)
+{
+    visible.clear();
+    redrawn = 0;
+    if (unsupported || !tiles->dungeon)
+        return false;
+    if (tiles->dungeon != dungeon) {
+        // карту сгенерировали заново: все куски недействительны, текстуры пригодятся
+        for (uint32_t i : resident)
+            freeTextures.push_back(chunks[i].texture);
+        resident.clear();
+        dungeon = tiles->dungeon;
+        columns = (dungeon->getWidth() + ChunkCells - 1) / ChunkCells;
+        rows = (dungeon->getHeight() + ChunkCells - 1) / ChunkCells;
+        chunks.assign(size_t(columns) * rows, Chunk{});
+    }
+    const int pixels = std::clamp(int(std::ceil(pixelsPerMeter)), 1, MaxPixelsPerCell);
+    if (pixels != pixelsPerCell) {
+        // текстуры другого размера: ChunkTextures создаст их заново
+        for (uint32_t i : resident)
+            chunks[i].texture = NoTexture;
+        resident.clear();
+        freeTextures.clear();
+        textureCount = 0;
+        pixelsPerCell = pixels;
+    }
+    const int texturePixels = ChunkCells * pixelsPerCell;
+    commands.chunkPixels = texturePixels;
+
+    if (viewMax.x < 0 || viewMax.y < 0 || viewMin.x >= dungeon->getWidth() || viewMin.y >= dungeon->getHeight())
+        return true;
+    const int cx0 = std::max(viewMin.x, 0) / ChunkCells, cx1 = std::min(viewMax.x, dungeon->getWidth() - 1) / ChunkCells;
+    const int cy0 = std::max(viewMin.y, 0) / ChunkCells, cy1 = std::min(viewMax.y, dungeon->getHeight() - 1) / ChunkCells;
+    // сверх бюджета куски дальше одного от поля зрения отдают текстуры
+    if (resident.size() * texturePixels * texturePixels > MaxTexturePixels)
+        std::erase_if(resident, [&](uint32_t i) {
+            const int cx = int(i % columns), cy = int(i / columns);
+            if (cx >= cx0 - 1 && cx <= cx1 + 1 && cy >= cy0 - 1 && cy <= cy1 + 1)
+                return false;
+            freeTextures.push_back(chunks[i].texture);
+            chunks[i].texture = NoTexture;
+            return true;
+        });
+
+    const uint32_t revision = dungeon->getRevision();
+    for (int cy = cy0; cy <= cy1; cy++)
+        for (int cx = cx0; cx <= cx1; cx++) {
+            const uint32_t index = uint32_t(cy * columns + cx);
+            Chunk &chunk = chunks[index];
+            bool dirty = false;
+            if (chunk.texture == NoTexture) {
+                if (!freeTextures.empty()) {
+                    chunk.texture = freeTextures.back();
+                    freeTextures.pop_back();
+                } else {
+                    chunk.texture = textureCount++;
+                }
+                resident.push_back(index);
+                chunk.hash = hash_chunk(cx, cy);
+                chunk.revision = revision;
+                dirty = true;
+            } else if (chunk.revision != revision) {
+                chunk.revision = revision;
+                const uint64_t hash = hash_chunk(cx, cy);
+                dirty = hash != chunk.hash;
+                chunk.hash = hash;
+            }
+            if (dirty) {
+                redraw_chunk(cx, cy, chunk.texture, commands);
+                redrawn++;
+            }
+            const int2 cell(cx * ChunkCells, cy * ChunkCells);
+            const int2 cells(std::min(ChunkCells, dungeon->getWidth() - cell.x), std::min(ChunkCells, dungeon->getHeight() - cell.y));
+            visible.push_back(Visible{ chunk.texture, SDL_FRect{ 0.f, 0.f, float(cells.x * pixelsPerCell), float(cells.y * pixelsPerCell) },
+                                       cell, cells });
+        }
+    return true;
+}
+
+bool ChunkTextures::is_supported(SDL_Renderer *renderer)
+{
+    TexturePtr probe(SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, 1, 1), SDL_DestroyTexture);
+    if (!probe)
+        return false;
+    SDL_Texture *previous = SDL_GetRenderTarget(renderer);
+    const bool supported = SDL_SetRenderTarget(renderer, probe.get());
+    SDL_SetRenderTarget(renderer, previous);
+    return supported;
+}
+
+void ChunkTextures::apply(SDL_Renderer *renderer, const BackgroundCommands &commands)
+{
+    if (commands.chunkPixels != pixels) {
+        textures.clear();
+        raw.clear();
+        pixels = commands.chunkPixels;
+    }
+    if (commands.redraws.empty())
+        return;
+    SDL_Texture *previous = SDL_GetRenderTarget(renderer);
+    for (const auto &redraw : commands.redraws) {
+        if (redraw.chunk >= textures.size()) {
+            textures.resize(redraw.chunk + 1);
+            raw.resize(redraw.chunk + 1, nullptr);
+        }
+        TexturePtr &texture = textures[redraw.chunk];
+        if (!texture) {
+            texture = TexturePtr(SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, pixels, pixels),
+                                 SDL_DestroyTexture);
+            if (!texture) {
+                // кусок останется пустым
+                if (!failed)
+                    std::cerr << "Failed to create a background chunk texture: " << SDL_GetError() << std::endl;
+                failed = true;
+                continue;
+            }
+            SDL_SetTextureScaleMode(texture.get(), SDL_SCALEMODE_NEAREST);
+            SDL_SetTextureBlendMode(texture.get(), SDL_BLENDMODE_BLEND);
+            raw[redraw.chunk] = texture.get();
+        }
+        if (!SDL_SetRenderTarget(renderer, texture.get()))
+            continue;
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+        SDL_RenderClear(renderer);
+        for (uint32_t t = redraw.firstTile; t < redraw.firstTile + redraw.tileCount; t++)
+            batch.add(commands.tiles[t].texture, commands.tiles[t].src, commands.tiles[t].dst);
+        batch.flush(renderer);
+    }
+    SDL_SetRenderTarget(renderer, previous);
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "dungeon_tiles.h"
+#include "math2d.h"
+#include "sprite.h"
+#include "sprite_batch.h"
+#include <SDL3/SDL_render.h>
+#include <memory>
+#include <span>
+#include <vector>
+
+// Что потоку отрисовки нужно сделать с текстурами кусков фона в этом кадре
+struct BackgroundCommands {
+    struct Tile {
+        SDL_Texture *texture;
+        SDL_FRect src, dst; // dst - в пикселях текстуры куска
+    };
+    struct Redraw {
+        uint32_t chunk; // номер текстуры куска
+        uint32_t firstTile, tileCount;
+    };
+
+    int chunkPixels = 0; // сторона текстуры куска; при смене все текстуры создаются заново
+    std::vector<Redraw> redraws;
+    std::vector<Tile> tiles;
+
+    void clear() {
+        redraws.clear();
+        tiles.clear();
+    }
+};
+
+// Статичный слой подземелья (пол и стены), заранее нарисованный в текстуры-цели
+// кусками ChunkCells x ChunkCells клеток. Кадр рисует видимый кусок одним спрайтом
+// вместо тысячи тайлов. Кусок перерисовывается, только если изменились его клетки
+// (проверяется по хэшу, когда меняется Dungeon::getRevision или подменяется сама карта)
+// или разрешение, то есть масштаб камеры. Пока текстуры укладываются в MaxTexturePixels, нарисованные куски
+// остаются; сверх него текстуры есть только у кусков в поле зрения и в одном куске вокруг,
+// остальные освобождаются для новых кусков, так что память не зависит от размера карты.
+// Сервис мира, работает на потоке симуляции и только решает, что перерисовать:
+// сами текстуры - у ChunkTextures на потоке отрисовки, куски ссылаются на них по номерам
+class BackgroundCache {
+public:
+    static constexpr int ChunkCells = 32;
+    // Выше этого тайлы растягиваются из текстуры: при SDL_SCALEMODE_NEAREST картинка та же
+    static constexpr int MaxPixelsPerCell = 32;
+    static constexpr size_t MaxTexturePixels = size_t(32) << 20;
+
+    struct Visible {
+        uint32_t chunk; // номер текстуры куска
+        SDL_FRect src;
+        int2 cell;  // левый верхний угол куска
+        int2 cells; // размер куска в клетках, у края карты меньше ChunkCells
+    };
+
+    // renderTargets - умеет ли рендерер рисовать в текстуру (см. ChunkTextures::is_supported)
+    BackgroundCache(std::shared_ptr<DungeonTiles> tiles, bool renderTargets)
+        : tiles(tiles), unsupported(!renderTargets) {}
+
+    // Готовит куски, задевающие клетки [viewMin, viewMax], и дописывает в commands их перерисовку.
+    // false, если рендерер не умеет рисовать в текстуру, тогда тайлы нужно рисовать как есть
+    bool update(int2 viewMin, int2 viewMax, float pixelsPerMeter, BackgroundCommands &commands);
+
+    const std::vector<Visible> &get_visible() const { return visible; }
+    // Сколько кусков перерисовано за последний update
+    size_t get_redrawn_count() const { return redrawn; }
+
+private:
+    static constexpr uint32_t NoTexture = UINT32_MAX;
+
+    struct Chunk {
+        uint32_t texture = NoTexture;
+        uint64_t hash = 0;
+        uint32_t revision = 0;
+    };
+
+    std::shared_ptr<DungeonTiles> tiles;
+    std::shared_ptr<Dungeon> dungeon; // для какой карты заведены chunks
+    int columns = 0, rows = 0;
+    std::vector<Chunk> chunks;
+    std::vector<uint32_t> resident;     // куски, у которых есть текстура
+    std::vector<uint32_t> freeTextures; // номера текстур, отданные кусками
+    uint32_t textureCount = 0;
+    int pixelsPerCell = 0;
+    bool unsupported;
+    std::vector<Visible> visible;
+    size_t redrawn = 0;
+
+    uint64_t hash_chunk(int cx, int cy) const;
+    void redraw_chunk(int cx, int cy, uint32_t texture, BackgroundCommands &commands) const;
+};
+
+// Текстуры кусков фона по номерам; живут на потоке отрисовки и освобождаются до SDL_DestroyRenderer
+class ChunkTextures {
+public:
+    static bool is_supported(SDL_Renderer *renderer);
+
+    // Выполняет перерисовки кадра
+    void apply(SDL_Renderer *renderer, const BackgroundCommands &commands);
+
+    std::span<SDL_Texture *const> get() const { return raw; }
+
+private:
+    std::vector<TexturePtr> textures;
+    std::vector<SDL_Texture *> raw;
+    int pixels = 0;
+    bool failed = false;
+    SpriteBatch batch;
+};
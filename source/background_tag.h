@@ -1,6 +0,0 @@
-#pragma once
-
-#include "component.h"
-
-class BackGroundTag : public Component {
-};
\ No newline at end of file
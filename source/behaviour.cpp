@@ -0,0 +1,285 @@
+#include "behaviour.h"
+
+#include <algorithm>
+#include <bit>
+#include <iostream>
+#include <unordered_map>
+
+bool compile_fsm(const FsmDefinition &definition, BehaviourProgram &program)
+{
+    program = BehaviourProgram{};
+    if (definition.states.empty()) {
+        std::cerr << "FSM has no states\n";
+        return false;
+    }
+    std::unordered_map<std::string, uint16_t> stateIndex;
+    for (const auto &state : definition.states) {
+        if (!stateIndex.emplace(state.name, uint16_t(program.states.size())).second) {
+            std::cerr << "FSM state " << state.name << " is defined twice\n";
+            return false;
+        }
+        program.states.push_back({state.action, 0, 0});
+        program.stateNames.push_back(state.name);
+    }
+    auto find = [&](const std::string &name, uint16_t &index) {
+        auto it = stateIndex.find(name);
+        if (it == stateIndex.end()) {
+            std::cerr << "FSM has no state " << name << "\n";
+            return false;
+        }
+        index = it->second;
+        return true;
+    };
+    if (!definition.initial.empty() && !find(definition.initial, program.initialState))
+        return false;
+
+    std::vector<BehaviourRule> anyRules;
+    std::vector<std::vector<BehaviourRule>> stateRules(program.states.size());
+    for (const auto &transition : definition.transitions) {
+        BehaviourRule rule{transition.require, transition.forbid, 0};
+        if (!find(transition.to, rule.target))
+            return false;
+        if (transition.from == FsmDefinition::AnyState) {
+            anyRules.push_back(rule);
+            continue;
+        }
+        uint16_t from;
+        if (!find(transition.from, from))
+            return false;
+        stateRules[from].push_back(rule);
+    }
+    for (size_t s = 0; s < program.states.size(); s++) {
+        auto &state = program.states[s];
+        state.firstRule = uint32_t(program.rules.size());
+        for (const auto *rules : { &anyRules, &stateRules[s] })
+            for (const BehaviourRule &rule : *rules)
+                // правило, где один бит и нужен, и запрещён, не сработает никогда
+                if ((rule.require & rule.forbid) == 0)
+                    program.rules.push_back(rule);
+        state.ruleCount = uint32_t(program.rules.size()) - state.firstRule;
+    }
+    return true;
+}
+
+// Разворачивает поддерево в правила: путь от корня до действия - это условия, собранные
+// в последовательностях по дороге; порядок правил повторяет порядок обхода селекторов
+static bool flatten_tree(const BehaviourTreeDefinition &tree, int node, BehaviourFacts require, BehaviourFacts forbid,
+                         std::vector<BehaviourRule> &rules, std::vector<int> &actionNodes, int depth)
+{
+    using Kind = BehaviourTreeDefinition::Kind;
+    if (node < 0 || node >= int(tree.nodes.size()) || depth > int(tree.nodes.size())) {
+        std::cerr << "Behaviour tree has a bad node reference " << node << "\n";
+        return false;
+    }
+    const auto &n = tree.nodes[node];
+    switch (n.kind) {
+    case Kind::Action: {
+        // одно действие - одно состояние, даже если оно встречается в дереве несколько раз
+        auto it = std::find_if(actionNodes.begin(), actionNodes.end(),
+                               [&](int other) { return tree.nodes[other].value == n.value; });
+        const uint16_t target = uint16_t(it - actionNodes.begin());
+        if (it == actionNodes.end())
+            actionNodes.push_back(node);
+        if ((require & forbid) == 0)
+            rules.push_back({require, forbid, target});
+        return true;
+    }
+    case Kind::Selector:
+        for (int child : n.children)
+            if (!flatten_tree(tree, child, require, forbid, rules, actionNodes, depth + 1))
+                return false;
+        return true;
+    case Kind::Sequence:
+        if (n.children.empty()) {
+            std::cerr << "Behaviour tree sequence " << node << " is empty\n";
+            return false;
+        }
+        for (size_t i = 0; i + 1 < n.children.size(); i++) {
+            const int child = n.children[i];
+            const bool isCondition = child >= 0 && child < int(tree.nodes.size()) &&
+                (tree.nodes[child].kind == Kind::Condition || tree.nodes[child].kind == Kind::NotCondition);
+            // действие в середине последовательности требует памяти о том, где агент остановился
+            if (!isCondition) {
+                std::cerr << "Behaviour tree sequence " << node << " has a non-condition before its last child\n";
+                return false;
+            }
+            if (tree.nodes[child].kind == Kind::Condition)
+                require |= tree.nodes[child].value;
+            else
+                forbid |= tree.nodes[child].value;
+        }
+        return flatten_tree(tree, n.children.back(), require, forbid, rules, actionNodes, depth + 1);
+    case Kind::Condition:
+    case Kind::NotCondition:
+        std::cerr << "Behaviour tree condition " << node << " is not followed by an action\n";
+        return false;
+    }
+    return false;
+}
+
+bool compile_behaviour_tree(const BehaviourTreeDefinition &definition, BehaviourProgram &program)
+{
+    program = BehaviourProgram{};
+    std::vector<BehaviourRule> rules;
+    std::vector<int> actionNodes;
+    if (!flatten_tree(definition, definition.root, 0, 0, rules, actionNodes, 0))
+        return false;
+    if (actionNodes.empty()) {
+        std::cerr << "Behaviour tree has no actions\n";
+        return false;
+    }
+    // дерево каждый тик обходится от корня, поэтому правила не зависят от текущего состояния
+    program.rules = std::move(rules);
+    for (int node : actionNodes) {
+        program.states.push_back({uint16_t(definition.nodes[node].value), 0, uint32_t(program.rules.size())});
+        program.stateNames.push_back(definition.nodes[node].name);
+    }
+    return true;
+}
+
+BehaviourRuntime::BehaviourRuntime(BehaviourProgram program)
+    : program(std::move(program))
+{
+    groupStart.assign(this->program.states.size() + 1, 0);
+    build_table();
+}
+
+void BehaviourRuntime::build_table()
+{
+    BehaviourFacts used = 0;
+    for (const BehaviourRule &rule : program.rules)
+        used |= rule.require | rule.forbid;
+    tableBits = std::bit_width(used);
+    if (tableBits > MaxTableBits)
+        return;
+    const size_t factCount = size_t(1) << tableBits;
+    table.resize(program.states.size() * factCount);
+    for (uint16_t s = 0; s < program.states.size(); s++) {
+        const std::span<const BehaviourRule> rules = program.get_rules(s);
+        for (BehaviourFacts f = 0; f < factCount; f++) {
+            auto rule = std::find_if(rules.begin(), rules.end(), [&](const BehaviourRule &r) { return r.matches(f); });
+            table[s * factCount + f] = rule != rules.end() ? rule->target : s;
+        }
+    }
+}
+
+uint32_t BehaviourRuntime::add()
+{
+    state.push_back(program.initialState);
+    facts.push_back(0);
+    regroup = true;
+    return uint32_t(state.size() - 1);
+}
+
+void BehaviourRuntime::remove(uint32_t agent)
+{
+    state[agent] = state.back();
+    state.pop_back();
+    facts[agent] = facts.back();
+    facts.pop_back();
+    regroup = true;
+}
+
+void BehaviourRuntime::swap(uint32_t a, uint32_t b)
+{
+    std::swap(state[a], state[b]);
+    std::swap(facts[a], facts[b]);
+    regroup = true;
+}
+
+void BehaviourRuntime::reorder(std::span<const uint32_t> from)
+{
+    std::vector<uint16_t> newState(from.size());
+    std::vector<BehaviourFacts> newFacts(from.size());
+    for (size_t k = 0; k < from.size(); k++) {
+        newState[k] = state[from[k]];
+        newFacts[k] = facts[from[k]];
+    }
+    state.swap(newState);
+    facts.swap(newFacts);
+    regroup = true;
+}
+
+void BehaviourRuntime::clear()
+{
+    state.clear();
+    facts.clear();
+    regroup = true;
+}
+
+void BehaviourRuntime::think(uint32_t begin, uint32_t end)
+{
+    // группы другого отрезка строятся заново
+    if (begin != groupBegin || end != groupEnd)
+        regroup = true;
+    if (table.empty()) {
+        if (regroup)
+            group_by_state(begin, end);
+        think_rules();
+    } else {
+        think_table(begin, end);
+    }
+    if (changedCount || regroup)
+        group_by_state(begin, end);
+}
+
+void BehaviourRuntime::think_table(uint32_t begin, uint32_t end)
+{
+    // биты фактов, которые правила не читают, отбрасываются
+    const BehaviourFacts mask = (BehaviourFacts(1) << tableBits) - 1;
+    const uint16_t *next = table.data();
+    uint16_t *states = state.data();
+    const BehaviourFacts *agentFacts = facts.data();
+    size_t changed = 0;
+    for (size_t agent = begin; agent < end; agent++) {
+        const uint16_t s = next[(size_t(states[agent]) << tableBits) | (agentFacts[agent] & mask)];
+        changed += s != states[agent];
+        states[agent] = s;
+    }
+    changedCount = changed;
+}
+
+void BehaviourRuntime::think_rules()
+{
+    changedCount = 0;
+    for (uint16_t s = 0; s < program.states.size(); s++) {
+        const std::span<const BehaviourRule> rules = program.get_rules(s);
+        if (rules.empty())
+            continue;
+        const uint32_t *agents = order.data() + groupStart[s];
+        const size_t count = groupStart[s + 1] - groupStart[s];
+        size_t changed = 0;
+        for (size_t k = 0; k < count; k++) {
+            const uint32_t agent = agents[k];
+            const BehaviourFacts f = facts[agent];
+            uint16_t next = s;
+            for (const BehaviourRule &rule : rules) {
+                if (rule.matches(f)) {
+                    next = rule.target;
+                    break;
+                }
+            }
+            changed += next != s;
+            state[agent] = next;
+        }
+        changedCount += changed;
+    }
+}
+
+void BehaviourRuntime::group_by_state(uint32_t begin, uint32_t end)
+{
+    // сортировка подсчётом по состоянию, внутри группы - по номеру агента
+    std::fill(groupStart.begin(), groupStart.end(), 0);
+    for (uint32_t agent = begin; agent < end; agent++)
+        groupStart[state[agent] + 1]++;
+    for (size_t s = 1; s < groupStart.size(); s++)
+        groupStart[s] += groupStart[s - 1];
+    order.resize(end - begin);
+    std::vector<uint32_t> &cursor = scratch;
+    cursor.assign(groupStart.begin(), groupStart.end() - 1);
+    for (uint32_t agent = begin; agent < end; agent++)
+        order[cursor[state[agent]]++] = agent;
+    groupBegin = begin;
+    groupEnd = end;
+    regroup = false;
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <span>
+#include <string>
+#include <vector>
+
+// Факты об агенте на этом тике, по биту на факт (угроза рядом, голоден, ...).
+// Что значит каждый бит, решает игра; движок только сравнивает маски
+using BehaviourFacts = uint32_t;
+
+// Переход: срабатывает, если в фактах есть все биты require и нет ни одного бита forbid
+struct BehaviourRule {
+    BehaviourFacts require = 0;
+    BehaviourFacts forbid = 0;
+    uint16_t target = 0;
+
+    bool matches(BehaviourFacts facts) const { return (facts & require) == require && (facts & forbid) == 0; }
+};
+
+// Поведение, скомпилированное в плоские таблицы: у каждого состояния - действие
+// и отрезок правил в общем массиве. Правила проверяются по порядку, первое подошедшее
+// задаёт следующее состояние; если не подошло ни одно, агент остаётся в своём.
+// Обе формы описания (FSM и дерево поведения) компилируются в этот формат
+struct BehaviourProgram {
+    struct State {
+        uint16_t action = 0;
+        uint32_t firstRule = 0, ruleCount = 0;
+    };
+    std::vector<State> states;
+    std::vector<BehaviourRule> rules;
+    std::vector<std::string> stateNames;
+    uint16_t initialState = 0;
+
+    std::span<const BehaviourRule> get_rules(uint16_t state) const {
+        return { rules.data() + states[state].firstRule, states[state].ruleCount };
+    }
+};
+
+// Конечный автомат как данные. Переходы из AnyState проверяются раньше переходов
+// самого состояния (как у родительского состояния в иерархическом FSM)
+struct FsmDefinition {
+    static constexpr const char *AnyState = "*";
+
+    struct State {
+        std::string name;
+        uint16_t action;
+    };
+    struct Transition {
+        std::string from, to;
+        BehaviourFacts require = 0, forbid = 0;
+    };
+    std::vector<State> states;
+    std::vector<Transition> transitions;
+    std::string initial; // пусто - первое состояние
+};
+
+// Реактивное дерево поведения: каждый тик обходится заново от корня, до первого действия.
+// Sequence - условия и последним дочерним узлом поддерево; Selector - первое сработавшее поддерево.
+// Condition проходит, если в фактах есть все биты value, NotCondition - если нет ни одного.
+// Каждое действие становится состоянием, и у всех состояний один и тот же список правил
+struct BehaviourTreeDefinition {
+    enum class Kind : uint8_t { Selector, Sequence, Condition, NotCondition, Action };
+
+    struct Node {
+        Kind kind;
+        uint32_t value = 0; // маска фактов или номер действия
+        std::vector<int> children;
+        std::string name;   // для действий - имя состояния
+    };
+    std::vector<Node> nodes;
+    int root = -1;
+
+    int selector(std::initializer_list<int> children) { return add(Kind::Selector, 0, children); }
+    int sequence(std::initializer_list<int> children) { return add(Kind::Sequence, 0, children); }
+    int condition(BehaviourFacts facts) { return add(Kind::Condition, facts, {}); }
+    int not_condition(BehaviourFacts facts) { return add(Kind::NotCondition, facts, {}); }
+    int action(uint16_t action, std::string name) {
+        const int node = add(Kind::Action, action, {});
+        nodes[node].name = std::move(name);
+        return node;
+    }
+
+private:
+    int add(Kind kind, uint32_t value, std::initializer_list<int> children) {
+        nodes.push_back(Node{kind, value, children, {}});
+        return int(nodes.size()) - 1;
+    }
+};
+
+// false и сообщение в std::cerr, если описание с ошибкой
+bool compile_fsm(const FsmDefinition &definition, BehaviourProgram &program);
+bool compile_behaviour_tree(const BehaviourTreeDefinition &definition, BehaviourProgram &program);
+
+// Исполнитель одной программы для множества агентов.
+// Если правила используют только младшие MaxTableBits бит фактов, они сворачиваются
+// в таблицу переходов [состояние][факты] и тик - это один проход по агентам с чтением из неё.
+// Иначе правила состояния проверяются подряд для всей группы агентов в этом состоянии.
+// Агенты сгруппированы по текущему состоянию, действия игра выполняет пакетом по get_agents(state);
+// внутри группы агенты идут по возрастанию номера. think(begin, end) обновляет только агентов
+// из отрезка номеров, и get_agents тогда отдаёт только их: так обходятся агенты, которым пора обновиться
+class BehaviourRuntime {
+public:
+    static constexpr int MaxTableBits = 12;
+
+    explicit BehaviourRuntime(BehaviourProgram program);
+
+    // факты агентов, заполняются игрой перед think()
+    std::vector<BehaviourFacts> facts;
+
+    uint32_t add();
+    // удаление перестановкой последнего агента на место agent
+    void remove(uint32_t agent);
+    // поменять местами номера агентов a и b вместе с их состоянием и фактами
+    void swap(uint32_t a, uint32_t b);
+    // перенумеровать всех агентов: новый агент k - это прежний from[k]
+    void reorder(std::span<const uint32_t> from);
+    void clear();
+    size_t size() const { return state.size(); }
+
+    // Один тик: переходы для всех агентов, затем перегруппировка тех, кто сменил состояние
+    void think() { think(0, uint32_t(size())); }
+    // То же для агентов [begin, end); остальные не меняются
+    void think(uint32_t begin, uint32_t end);
+
+    const BehaviourProgram &get_program() const { return program; }
+    uint16_t get_state(uint32_t agent) const { return state[agent]; }
+    uint16_t get_action(uint16_t state) const { return program.states[state].action; }
+    // агенты в состоянии state из отрезка последнего think()
+    std::span<const uint32_t> get_agents(uint16_t state) const {
+        return { order.data() + groupStart[state], groupStart[state + 1] - groupStart[state] };
+    }
+    // сменили состояние на последнем think()
+    size_t get_changed_count() const { return changedCount; }
+
+private:
+    BehaviourProgram program;
+    std::vector<uint16_t> state;
+    std::vector<uint32_t> order;      // номера агентов отрезка, сгруппированные по состоянию
+    uint32_t groupBegin = 0, groupEnd = 0; // отрезок, по которому построен order
+    std::vector<uint32_t> groupStart; // начало группы в order, states.size() + 1 элементов
+    std::vector<uint32_t> scratch;
+    // следующее состояние по (state << tableBits) | facts, пусто - таблица слишком велика
+    std::vector<uint16_t> table;
+    int tableBits = 0;
+    bool regroup = true;
+    size_t changedCount = 0;
+
+    void build_table();
+    void think_rules();
+    void think_table(uint32_t begin, uint32_t end);
+    void group_by_state(uint32_t begin, uint32_t end);
+};
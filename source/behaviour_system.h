@@ -0,0 +1,347 @@
+#pragma once
+
+#include "component.h"
+#include "game_object.h"
+#include "world.h"
+#include "agent_behaviours.h"
+#include "ai_lod.h"
+#include "behaviour.h"
+#include "flow_field.h"
+#include "health.h"
+#include "influence_map.h"
+#include "npc_movement.h"
+#include "path_follower.h"
+#include "random.h"
+#include "stamina.h"
+#include "transform2d.h"
+#include "walkability_grid.h"
+#include <algorithm>
+#include <bit>
+#include <span>
+#include <unordered_map>
+
+// FSM / behaviour tree AI for a group of NPCs sharing one BehaviourProgram.
+// Every tick facts are gathered for the agents, BehaviourRuntime picks their states,
+// then each state's action runs as one batch over the agents in that state: it only picks
+// the agents' next steps, and move_npcs takes the steps for the whole slice at once.
+// With an AiLod service, agents are stored grouped by their far bucket, with the agents near
+// cameras and players in one more group at the end. A tick senses, thinks and moves only the near
+// group and the bucket that is due, so its cost follows the agents updated, not all agents.
+// Far agents get all the time accumulated since their last update
+class BehaviourSystem : public Component {
+public:
+    // danger a predator leaves about 4 cells away in an open room, see InfluenceMap
+    static constexpr float DangerThreshold = 0.02f;
+    static constexpr uint16_t HuntDistance = 8; // cells to the nearest prey
+    static constexpr int HungryHealth = 70;
+
+    explicit BehaviourSystem(BehaviourProgram program)
+        : runtime(std::move(program)) {}
+
+    void on_create() override {
+        flowFields = get_owner()->get_world()->get_service<FlowFields>();
+        grid = get_owner()->get_world()->get_service<WalkabilityGrid>();
+        random = get_owner()->get_world()->get_service<Random>();
+        lod = get_owner()->get_world()->get_service<AiLod>();
+        danger = get_owner()->get_world()->get_service<InfluenceMap>();
+        // without AiLod everyone stays in the near group
+        nearGroup = lod ? lod->get_far_period() : 0;
+        groupStart.assign(nearGroup + 2, 0);
+    }
+
+    void add(GameObjectPtr agent) {
+        auto transform = agent->get_component<Transform2D>();
+        auto stamina = agent->get_component<Stamina>();
+        if (!transform || !stamina || !slotById.try_emplace(agent->get_id(), uint32_t(ids.size())).second)
+            return;
+        // appended to the near group, moved to its bucket on the next tick if it is far
+        runtime.add();
+        owners.push_back(agent);
+        ids.push_back(agent->get_id());
+        transforms.push_back(transform);
+        staminas.push_back(stamina);
+        healths.push_back(agent->get_component<Health>());
+        followers.push_back(agent->get_component<PathFollower>());
+        // the random walk of each agent is its own xorshift stream, seeded per entity
+        const uint32_t seed = random ? random->get_uint(agent->get_id(), 0, WanderStep) : agent->get_id();
+        movement.add(int2((int)transform->x, (int)transform->y), stamina->get_speed(), seed);
+        updatedAt.push_back(clock);
+        nearTick.push_back(0);
+        groupStart.back() = uint32_t(ids.size());
+    }
+
+    // agents updated on the last tick
+    size_t get_updated_count() const { return updatedCount; }
+
+    void on_update(float dt) override {
+        if (!flowFields || !grid || !danger)
+            return;
+        clock += dt;
+        const uint32_t tick = get_owner()->get_world()->get_tick();
+        updatedCount = 0;
+        if (lod)
+            refresh_near(tick);
+        update_group(nearGroup);
+        if (lod)
+            update_group(lod->get_due_bucket(tick));
+    }
+
+private:
+    BehaviourRuntime runtime;
+    std::shared_ptr<FlowFields> flowFields;
+    std::shared_ptr<WalkabilityGrid> grid;
+    std::shared_ptr<Random> random;
+    std::shared_ptr<AiLod> lod;
+    std::shared_ptr<InfluenceMap> danger;
+
+    // parallel to the runtime's agents, grouped: far buckets 0..nearGroup-1, then the near group
+    std::vector<std::weak_ptr<GameObject>> owners;
+    std::vector<uint32_t> ids;
+    std::vector<std::shared_ptr<Transform2D>> transforms;
+    std::vector<std::shared_ptr<Stamina>> staminas;
+    std::vector<std::shared_ptr<Health>> healths;
+    std::vector<std::shared_ptr<PathFollower>> followers;
+    NpcMovementArrays movement;
+    std::vector<double> updatedAt;    // clock at the agent's last update
+    std::vector<uint32_t> nearTick;   // last tick AiLod reported the agent near
+    std::unordered_map<uint32_t, uint32_t> slotById;
+    std::vector<uint32_t> groupStart; // nearGroup + 2 entries, the last one is the agent count
+    uint32_t nearGroup = 0;
+    double clock = 0;
+    size_t updatedCount = 0;
+    std::vector<uint64_t> moved;
+
+    void update_group(uint32_t group) {
+        remove_dead(group);
+        const uint32_t begin = groupStart[group], end = groupStart[group + 1];
+        if (begin == end)
+            return;
+        updatedCount += end - begin;
+        sense(begin, end);
+        runtime.think(begin, end);
+        // a far agent may take several steps at once for the ticks it skipped,
+        // each picked from the cell the previous one reached
+        const size_t stateCount = runtime.get_program().states.size();
+        for (bool stepping = true; stepping;) {
+            stepping = false;
+            for (uint16_t state = 0; state < stateCount; state++) {
+                const auto agents = runtime.get_agents(state);
+                if (!agents.empty())
+                    stepping |= act(AgentAction(runtime.get_action(state)), agents);
+            }
+            if (stepping)
+                step(begin, end);
+        }
+    }
+
+    // moves agents that came near into the near group and the rest of it back to their buckets;
+    // costs as much as the agents near the watchers
+    void refresh_near(uint32_t tick) {
+        size_t moves = 0;
+        for (uint32_t id : lod->get_near_entities()) {
+            auto it = slotById.find(id);
+            if (it == slotById.end())
+                continue;
+            nearTick[it->second] = tick;
+            moves += it->second < groupStart[nearGroup];
+        }
+        for (uint32_t i = groupStart[nearGroup]; i < ids.size(); i++)
+            moves += nearTick[i] != tick;
+        // each move swaps across up to nearGroup boundaries; after many adds one sort is cheaper
+        if (moves * nearGroup > ids.size()) {
+            regroup_all(tick);
+            return;
+        }
+        for (uint32_t id : lod->get_near_entities()) {
+            auto it = slotById.find(id);
+            if (it != slotById.end() && it->second < groupStart[nearGroup])
+                move_to_group(it->second, nearGroup);
+        }
+        // the agent swapped into i when i leaves is one already checked
+        for (uint32_t i = groupStart[nearGroup]; i < ids.size(); i++)
+            if (nearTick[i] != tick)
+                move_to_group(i, lod->get_bucket(ids[i]));
+    }
+
+    template<typename T>
+    static void reorder(std::vector<T> &values, std::span<const uint32_t> from) {
+        std::vector<T> sorted(from.size());
+        for (size_t k = 0; k < from.size(); k++)
+            sorted[k] = std::move(values[from[k]]);
+        values.swap(sorted);
+    }
+
+    // counting sort of all agents by group, stable within a group
+    void regroup_all(uint32_t tick) {
+        auto group_of = [&](uint32_t i) { return nearTick[i] == tick ? nearGroup : lod->get_bucket(ids[i]); };
+        std::fill(groupStart.begin(), groupStart.end(), 0);
+        for (uint32_t i = 0; i < ids.size(); i++)
+            groupStart[group_of(i) + 1]++;
+        for (size_t g = 1; g < groupStart.size(); g++)
+            groupStart[g] += groupStart[g - 1];
+        std::vector<uint32_t> from(ids.size());
+        std::vector<uint32_t> cursor(groupStart.begin(), groupStart.end() - 1);
+        for (uint32_t i = 0; i < ids.size(); i++)
+            from[cursor[group_of(i)]++] = i;
+        runtime.reorder(from);
+        reorder(owners, from);
+        reorder(ids, from);
+        reorder(transforms, from);
+        reorder(staminas, from);
+        reorder(healths, from);
+        reorder(followers, from);
+        movement.reorder(from);
+        reorder(updatedAt, from);
+        reorder(nearTick, from);
+        for (uint32_t i = 0; i < ids.size(); i++)
+            slotById[ids[i]] = i;
+    }
+
+    template<typename T>
+    static void swap_at(std::vector<T> &values, uint32_t a, uint32_t b) {
+        std::swap(values[a], values[b]);
+    }
+
+    void swap_agents(uint32_t a, uint32_t b) {
+        if (a == b)
+            return;
+        runtime.swap(a, b);
+        swap_at(owners, a, b);
+        swap_at(ids, a, b);
+        swap_at(transforms, a, b);
+        swap_at(staminas, a, b);
+        swap_at(healths, a, b);
+        swap_at(followers, a, b);
+        movement.swap(a, b);
+        swap_at(updatedAt, a, b);
+        swap_at(nearTick, a, b);
+        slotById[ids[a]] = a;
+        slotById[ids[b]] = b;
+    }
+
+    // one swap per group boundary crossed, at most the far period; returns the agent's new slot
+    uint32_t move_to_group(uint32_t i, uint32_t target) {
+        uint32_t group = uint32_t(std::upper_bound(groupStart.begin(), groupStart.end(), i) - groupStart.begin()) - 1;
+        for (; group < target; group++) {
+            // the group's last slot becomes the first slot of the next group
+            const uint32_t last = --groupStart[group + 1];
+            swap_agents(i, last);
+            i = last;
+        }
+        for (; group > target; group--) {
+            const uint32_t first = groupStart[group]++;
+            swap_agents(i, first);
+            i = first;
+        }
+        return i;
+    }
+
+    void remove(uint32_t i) {
+        const uint32_t last = uint32_t(ids.size() - 1);
+        swap_agents(move_to_group(i, nearGroup), last);
+        slotById.erase(ids[last]);
+        runtime.remove(last);
+        owners.pop_back();
+        ids.pop_back();
+        transforms.pop_back();
+        staminas.pop_back();
+        healths.pop_back();
+        followers.pop_back();
+        movement.remove(last);
+        updatedAt.pop_back();
+        nearTick.pop_back();
+        groupStart.back() = last;
+    }
+
+    void remove_dead(uint32_t group) {
+        // dead NPCs are removed from the world, their weak pointers expire;
+        // checked only for the group being updated, the others are not touched anyway.
+        // Removal moves the group's last agent into i
+        for (uint32_t i = groupStart[group]; i < groupStart[group + 1];) {
+            if (owners[i].expired())
+                remove(i);
+            else
+                i++;
+        }
+    }
+
+    void sense(uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; i++) {
+            movement.speed[i] = staminas[i]->get_speed();
+            movement.accumulator[i] += float(clock - updatedAt[i]) * movement.speed[i];
+            updatedAt[i] = clock;
+            const int2 cell(movement.x[i], movement.y[i]);
+            BehaviourFacts facts = 0;
+            if (danger->get(cell) >= DangerThreshold)
+                facts |= ThreatNear;
+            if (healths[i] && healths[i]->get() < HungryHealth)
+                facts |= Hungry;
+            if (flowFields->food.get_distance(cell) != FlowField::Unreachable)
+                facts |= FoodKnown;
+            if (flowFields->prey.get_distance(cell) <= HuntDistance)
+                facts |= PreyNear;
+            runtime.facts[i] = facts;
+        }
+    }
+
+    int2 get_cell(uint32_t i) const { return int2(movement.x[i], movement.y[i]); }
+
+    // along a requested path to a random cell if there is a PathFollower, otherwise at random
+    NpcStep wander_step(uint32_t i) {
+        auto &follower = followers[i];
+        if (!follower)
+            return NpcStep::Random;
+        int2 step;
+        if (follower->next_step(get_cell(i), step))
+            return to_npc_step(step);
+        // wait in place until the path is ready
+        if (!follower->is_waiting())
+            follower->wander(get_cell(i));
+        return NpcStep::None;
+    }
+
+    // picks the next step of the agents that have one due; false if none of them has
+    bool act(AgentAction action, std::span<const uint32_t> agents) {
+        switch (action) {
+        case AgentAction::Wander:
+            return choose(agents, [&](uint32_t i) { return wander_step(i); });
+        case AgentAction::Forage:
+            return choose(agents, [&](uint32_t i) { return to_npc_step(flowFields->food.next_step(get_cell(i))); });
+        case AgentAction::Flee:
+            return choose(agents, [&](uint32_t i) {
+                const int2 away = danger->step_down(get_cell(i));
+                // cornered: any direction is better than waiting
+                return away.x || away.y ? to_npc_step(away) : NpcStep::Random;
+            });
+        case AgentAction::Hunt:
+            return choose(agents, [&](uint32_t i) { return to_npc_step(flowFields->prey.next_step(get_cell(i))); });
+        }
+        return false;
+    }
+
+    // an agent takes a step each time its accumulated time reaches 1.0
+    template<typename Step>
+    bool choose(std::span<const uint32_t> agents, Step &&step) {
+        bool stepping = false;
+        for (uint32_t i : agents) {
+            if (movement.accumulator[i] < 1.0f)
+                continue;
+            movement.step[i] = step(i);
+            stepping = true;
+        }
+        return stepping;
+    }
+
+    // the kernel moves the whole slice, only the agents that moved write their transforms
+    void step(uint32_t begin, uint32_t end) {
+        moved.resize((end - begin + 63) / 64);
+        move_npcs(movement, *grid, 0.f, begin, end, moved);
+        for (size_t word = 0; word < moved.size(); word++) {
+            for (uint64_t bits = moved[word]; bits; bits &= bits - 1) {
+                const uint32_t i = begin + uint32_t(word * 64 + std::countr_zero(bits));
+                transforms[i]->x = movement.x[i];
+                transforms[i]->y = movement.y[i];
+            }
+        }
+    }
+};
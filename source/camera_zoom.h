@@ -0,0 +1,38 @@
+#pragma once
+#include "game_object.h"
+#include "world.h"
+#include "camera2d.h"
+#include "input_state.h"
+#include <algorithm>
+#include <cmath>
+
+// Zooms the camera of the same object with '=' and '-'. Zooming is exponential, so it takes
+// as long to go from 32 to 16 pixels per meter as from 2 to 1; far out the renderer switches
+// to the dungeon overview (see DungeonOverview)
+class CameraZoom : public Component {
+public:
+    static constexpr float MinPixelsPerMeter = 1.f / 16;
+    static constexpr float MaxPixelsPerMeter = 64.f;
+    // zoom doubles every this many seconds while the key is held
+    static constexpr float SecondsPerDoubling = 0.5f;
+
+    void on_create() override {
+        input = get_owner()->get_world()->get_service<InputState>();
+    }
+
+    void on_update(float dt) override {
+        auto camera = get_owner()->get_component<Camera2D>();
+        if (!camera || !input)
+            return;
+        float direction = 0.f;
+        if (input->is_pressed(InputKey::ZoomIn)) direction += 1.f;
+        if (input->is_pressed(InputKey::ZoomOut)) direction -= 1.f;
+        if (direction == 0.f)
+            return;
+        camera->pixelsPerMeter = std::clamp(camera->pixelsPerMeter * std::exp2(direction * dt / SecondsPerDoubling),
+                                            MinPixelsPerMeter, MaxPixelsPerMeter);
+    }
+
+private:
+    std::shared_ptr<InputState> input;
+};
@@ -3,7 +3,11 @@
 #include <vector>
 #include <random>
 #include <algorithm>
+#include <memory>
+#include <bit>
+#include <cstdint>
 #include "math2d.h"
+#include "dungeon_regions.h"
 
 struct Room {
     int x, y, w, h;
@@ -13,33 +17,128 @@ struct Room {
 
 class Dungeon {
 public:
-    enum Tile {
+    enum Tile : uint8_t {
         WALL,
         FLOOR
     };
-    Dungeon(int width, int height, int roomAttempts = 50)
-        : W(width), H(height), grid(height, std::vector<Tile>(width, WALL)) {
-        generate(roomAttempts);
+    // floor1/floor2 из тайлсета, у стен вариант всегда 0
+    static constexpr int FloorVariants = 2;
+
+    // chunkSize > 0 - большая карта из кусков: комнаты соединяются цепочкой внутри своего куска,
+    // а куски - с соседями справа и снизу. Иначе одна цепочка через всю карту
+    Dungeon(int width, int height, int roomAttempts = 50, uint32_t seed = std::random_device{}(), int chunkSize = 0)
+        : W(width), H(height), wordsPerRow((width + 63) / 64), rng(seed) {
+        ownedWalkable.assign(size_t(wordsPerRow) * H, 0);
+        ownedVariants.assign(size_t(W) * H, 0);
+        walkable = ownedWalkable.data();
+        variants = ownedVariants.data();
+        generate(roomAttempts, chunkSize);
+    }
+
+    // Уровень поверх готовых данных (например, отображённого в память файла, см. level_file.h).
+    // storage держит память живой, пока жив Dungeon.
+    Dungeon(int width, int height, uint64_t *walkableBits, uint8_t *tileVariants,
+            std::vector<Room> rooms, std::shared_ptr<void> storage)
+        : W(width), H(height), wordsPerRow((width + 63) / 64),
+          walkable(walkableBits), variants(tileVariants), storage(std::move(storage)), rooms(std::move(rooms)) {
+        countFloor();
+        rebuildRegions();
+    }
+
+    // walkable и variants указывают в собственные массивы или в storage, копия смотрела бы в чужие
+    Dungeon(const Dungeon &) = delete;
+    Dungeon &operator=(const Dungeon &) = delete;
+
+    int getWidth() const { return W; }
+    int getHeight() const { return H; }
+    int getFloorCount() const { return floorCount; }
+    const std::vector<Room> &getRooms() const { return rooms; }
+
+    bool isFloor(int x, int y) const {
+        if (x < 0 || y < 0 || x >= W || y >= H)
+            return false;
+        return (walkable[size_t(y) * wordsPerRow + (x >> 6)] >> (x & 63)) & 1;
+    }
+    Tile getTile(int x, int y) const {
+        return isFloor(x, y) ? FLOOR : WALL;
+    }
+    uint8_t getVariant(int x, int y) const {
+        return variants[size_t(y) * W + x];
+    }
+
+    // Битовая маска проходимости: бит (x & 63) слова x >> 6 строки y. Биты за W всегда 0
+    int getWordsPerRow() const { return wordsPerRow; }
+    const uint64_t *getWalkableRow(int y) const {
+        return walkable + size_t(y) * wordsPerRow;
     }
+    const uint64_t *getWalkableBits() const { return walkable; }
+    const uint8_t *getVariants() const { return variants; }
+
+    // Связные области пола, актуальны после генерации, загрузки и любого setTile
+    const DungeonRegions &getRegions() const { return regions; }
+
+    // Растёт при каждом изменении карты, чтобы кэши могли понять, что их пора пересчитать
+    uint32_t getRevision() const { return revision; }
 
-    const std::vector<std::vector<Tile>> &getGrid() const {
-        return grid;
+    // Журнал последних EditLogSize правок: клетки, изменённые setTile после ревизии since, дописываются в out
+    // (с повторами, если клетку меняли несколько раз). false - журнал их уже не помнит, пересчитывать всё
+    static constexpr uint32_t EditLogSize = 4096;
+    bool getEditsSince(uint32_t since, std::vector<int2> &out) const {
+        if (revision - since > EditLogSize)
+            return false;
+        for (uint32_t r = since; r != revision; r++)
+            out.push_back(editLog[r % EditLogSize]);
+        return true;
+    }
+
+    void setTile(int x, int y, Tile tile) {
+        if (x < 0 || y < 0 || x >= W || y >= H || getTile(x, y) == tile)
+            return;
+        uint64_t &word = walkable[size_t(y) * wordsPerRow + (x >> 6)];
+        const uint64_t bit = uint64_t(1) << (x & 63);
+        bool regionsValid;
+        if (tile == FLOOR) {
+            word |= bit;
+            floorCount++;
+            regionsValid = regions.on_floor_added(int2{x, y});
+        } else {
+            word &= ~bit;
+            floorCount--;
+            regionsValid = regions.on_floor_removed(int2{x, y});
+        }
+        variants[size_t(y) * W + x] = 0;
+        if (!regionsValid)
+            rebuildRegions();
+        if (editLog.empty())
+            editLog.resize(EditLogSize);
+        editLog[revision % EditLogSize] = int2{x, y};
+        revision++;
     }
 
     // Возвращает случайную позицию напольного тайла
-    // Не эффективно для больших карт, но сойдет для примера
     int2 getRandomFloorPosition() {
         std::uniform_int_distribution<size_t> dist(0, floorCount - 1);
-        size_t target = dist(rng);
-        size_t count = 0;
+        return getFloorPosition(dist(rng));
+    }
+
+    // Позиция index-го по порядку (сверху вниз, слева направо) напольного тайла, index < getFloorCount().
+    // Вместе с Random даёт случайную позицию без общего состояния генератора
+    // Не эффективно для больших карт, но сойдет для примера
+    int2 getFloorPosition(size_t index) const {
+        size_t target = index;
         for (int y = 0; y < H; y++) {
-            for (int x = 0; x < W; x++) {
-                if (grid[y][x] == FLOOR) {
-                    if (count == target) {
-                        return int2{x, y};
-                    }
-                    count++;
+            const uint64_t *row = getWalkableRow(y);
+            for (int w = 0; w < wordsPerRow; w++) {
+                uint64_t bits = row[w];
+                size_t count = std::popcount(bits);
+                if (target >= count) {
+                    target -= count;
+                    continue;
                 }
+                // пропускаем target младших установленных битов
+                for (; target > 0; target--)
+                    bits &= bits - 1;
+                return int2{w * 64 + std::countr_zero(bits), y};
             }
         }
         return int2{-1, -1}; // Не должно случиться
@@ -47,12 +146,34 @@ public:
 
 private:
     int W, H;
+    int wordsPerRow;
     int floorCount = 0;
-    std::vector<std::vector<Tile>> grid;
+    uint32_t revision = 0;
+    uint64_t *walkable = nullptr;
+    uint8_t *variants = nullptr;
+    std::vector<uint64_t> ownedWalkable;
+    std::vector<uint8_t> ownedVariants;
+    std::shared_ptr<void> storage;
     std::vector<Room> rooms;
+    std::vector<int2> editLog; // правка, после которой ревизия стала r + 1, лежит в editLog[r % EditLogSize]
+    DungeonRegions regions;
     std::mt19937 rng{ std::random_device{}() };
 
-    void generate(int roomAttempts) {
+    void setFloor(int x, int y) {
+        walkable[size_t(y) * wordsPerRow + (x >> 6)] |= uint64_t(1) << (x & 63);
+    }
+
+    void rebuildRegions() {
+        regions.build(W, H, wordsPerRow, walkable);
+    }
+
+    void countFloor() {
+        floorCount = 0;
+        for (size_t i = 0, n = size_t(wordsPerRow) * H; i < n; i++)
+            floorCount += std::popcount(walkable[i]);
+    }
+
+    void generate(int roomAttempts, int chunkSize) {
         std::uniform_int_distribution<int> rw(4, 10);
         std::uniform_int_distribution<int> rh(4, 8);
         std::uniform_int_distribution<int> rx(1, W - 12);
@@ -65,20 +186,26 @@ private:
         }
 
         // Соединяем комнаты коридорами
-        for (size_t i = 1; i < rooms.size(); i++) {
-            auto& a = rooms[i - 1];
-            auto& b = rooms[i];
-            connectRooms(a, b);
+        if (chunkSize > 0) {
+            connectChunks(chunkSize);
+        } else {
+            for (size_t i = 1; i < rooms.size(); i++) {
+                auto& a = rooms[i - 1];
+                auto& b = rooms[i];
+                connectRooms(a, b);
+            }
         }
-        // Подсчитываем количество напольных тайлов (для getRandomFloorPosition)
-        floorCount = 0;
+        // Выбираем вариант спрайта пола
+        std::uniform_int_distribution<int> variant(0, FloorVariants - 1);
         for (int y = 0; y < H; y++) {
             for (int x = 0; x < W; x++) {
-                if (grid[y][x] == FLOOR) {
-                    floorCount++;
-                }
+                if (isFloor(x, y))
+                    variants[size_t(y) * W + x] = uint8_t(variant(rng));
             }
         }
+        // Подсчитываем количество напольных тайлов (для getRandomFloorPosition)
+        countFloor();
+        rebuildRegions();
     }
 
     bool placeRoom(const Room& r) {
@@ -89,19 +216,45 @@ private:
         // Проверка пересечения
         for (int y = r.y - 1; y < r.y + r.h + 1; y++) {
             for (int x = r.x - 1; x < r.x + r.w + 1; x++) {
-                if (grid[y][x] == FLOOR) return false;
+                if (isFloor(x, y)) return false;
             }
         }
 
         // Рисуем комнату
         for (int y = r.y; y < r.y + r.h; y++) {
             for (int x = r.x; x < r.x + r.w; x++) {
-                grid[y][x] = FLOOR;
+                setFloor(x, y);
             }
         }
         return true;
     }
 
+    void connectChunks(int chunkSize) {
+        const int chunksX = (W + chunkSize - 1) / chunkSize;
+        const int chunksY = (H + chunkSize - 1) / chunkSize;
+        // первая комната куска, по ней кусок соединяется с соседями
+        std::vector<int> first(size_t(chunksX) * chunksY, -1), last(first.size(), -1);
+        for (int i = 0; i < (int)rooms.size(); i++) {
+            const size_t chunk = size_t(rooms[i].centerY() / chunkSize) * chunksX + rooms[i].centerX() / chunkSize;
+            if (last[chunk] >= 0)
+                connectRooms(rooms[last[chunk]], rooms[i]);
+            else
+                first[chunk] = i;
+            last[chunk] = i;
+        }
+        for (int cy = 0; cy < chunksY; cy++) {
+            for (int cx = 0; cx < chunksX; cx++) {
+                const int a = first[size_t(cy) * chunksX + cx];
+                if (a < 0)
+                    continue;
+                if (cx + 1 < chunksX && first[size_t(cy) * chunksX + cx + 1] >= 0)
+                    connectRooms(rooms[a], rooms[first[size_t(cy) * chunksX + cx + 1]]);
+                if (cy + 1 < chunksY && first[size_t(cy + 1) * chunksX + cx] >= 0)
+                    connectRooms(rooms[a], rooms[first[size_t(cy + 1) * chunksX + cx]]);
+            }
+        }
+    }
+
     void connectRooms(const Room& a, const Room& b) {
         int x1 = a.centerX(), y1 = a.centerY();
         int x2 = b.centerX(), y2 = b.centerY();
@@ -118,11 +271,11 @@ private:
 
     void carveHorizontal(int x1, int x2, int y) {
         if (x2 < x1) std::swap(x1, x2);
-        for (int x = x1; x <= x2; x++) grid[y][x] = FLOOR;
+        for (int x = x1; x <= x2; x++) setFloor(x, y);
     }
 
     void carveVertical(int y1, int y2, int x) {
         if (y2 < y1) std::swap(y1, y2);
-        for (int y = y1; y <= y2; y++) grid[y][x] = FLOOR;
+        for (int y = y1; y <= y2; y++) setFloor(x, y);
     }
 };
@@ -0,0 +1,141 @@
+#include "dungeon_overview.h"
+
+#include <algorithm>
+#include <iostream>
+
+uint32_t DungeonOverview::choose_level(float pixelsPerMeter) const
+{
+    const Dungeon &map = *tiles->dungeon;
+    uint32_t level = 0;
+    // 2^(level + 1) клеток всё ещё помещаются в один пиксель экрана
+    while (float(get_block(level + 1)) * pixelsPerMeter <= 1.f && level < 30)
+        level++;
+    while ((map.getWidth() + get_block(level) - 1) / get_block(level) > MaxTextureSize ||
+           (map.getHeight() + get_block(level) - 1) / get_block(level) > MaxTextureSize)
+        level++;
+    return level;
+}
+
+static uint32_t mix_color(uint32_t a, uint32_t b, uint32_t weightB, uint32_t total)
+{
+    uint32_t result = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        const uint32_t ca = (a >> shift) & 0xff, cb = (b >> shift) & 0xff;
+        result |= ((ca * (total - weightB) + cb * weightB) / total) << shift;
+    }
+    return result;
+}
+
+void DungeonOverview::prepare(uint32_t level, OverviewCommands &commands)
+{
+    if (tiles->dungeon != dungeon) {
+        dungeon = tiles->dungeon;
+        built.clear();
+        builtRevision.clear();
+    }
+    if (!dungeon)
+        return;
+    if (level >= built.size()) {
+        built.resize(level + 1, 0);
+        builtRevision.resize(level + 1, 0);
+    }
+    if (built[level] && builtRevision[level] == dungeon->getRevision())
+        return;
+    if (!built[level] || !update_level(level, commands))
+        build_level(level, commands);
+    built[level] = 1;
+    builtRevision[level] = dungeon->getRevision();
+}
+
+void DungeonOverview::build_level(uint32_t level, OverviewCommands &commands)
+{
+    const int block = get_block(level);
+    const int width = (dungeon->getWidth() + block - 1) / block;
+    const int height = (dungeon->getHeight() + block - 1) / block;
+    const uint32_t first = uint32_t(commands.pixels.size());
+    commands.pixels.resize(first + size_t(width) * height, 0);
+    uint32_t *pixels = commands.pixels.data() + first;
+    // сначала число клеток пола в каждом блоке, строка карты за строкой
+    std::vector<uint32_t> floor(size_t(width) * height, 0);
+    for (int y = 0; y < dungeon->getHeight(); y++) {
+        uint32_t *row = floor.data() + size_t(y / block) * width;
+        for (int x = 0; x < dungeon->getWidth(); x++)
+            row[x / block] += dungeon->isFloor(x, y);
+    }
+    for (int py = 0; py < height; py++)
+        for (int px = 0; px < width; px++) {
+            // у края карты блок неполный
+            const uint32_t cells = uint32_t(std::min(block, dungeon->getWidth() - px * block) * std::min(block, dungeon->getHeight() - py * block));
+            pixels[size_t(py) * width + px] = mix_color(WallColor, FloorColor, floor[size_t(py) * width + px], cells);
+        }
+    commands.uploads.push_back(OverviewCommands::Upload{ level, width, height, 0, 0, width, height, first });
+}
+
+bool DungeonOverview::update_level(uint32_t level, OverviewCommands &commands)
+{
+    edits.clear();
+    if (!dungeon->getEditsSince(builtRevision[level], edits))
+        return false;
+    const int block = get_block(level);
+    const int width = (dungeon->getWidth() + block - 1) / block;
+    const int height = (dungeon->getHeight() + block - 1) / block;
+    dirty.clear();
+    for (int2 cell : edits)
+        dirty.push_back(uint32_t(cell.y / block) * uint32_t(width) + uint32_t(cell.x / block));
+    std::sort(dirty.begin(), dirty.end());
+    dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+    if (dirty.size() * FullRebuildFraction > size_t(width) * height)
+        return false;
+
+    // Пиксели одной строки подряд уходят одной загрузкой
+    for (size_t i = 0; i < dirty.size();) {
+        const int py = int(dirty[i] / width), x0 = int(dirty[i] % width);
+        const uint32_t first = uint32_t(commands.pixels.size());
+        int px = x0;
+        for (; i < dirty.size() && px < width && dirty[i] == uint32_t(py) * width + px; i++, px++)
+            commands.pixels.push_back(block_color(block, px, py));
+        commands.uploads.push_back(OverviewCommands::Upload{ level, width, height, x0, py, px - x0, 1, first });
+    }
+    return true;
+}
+
+uint32_t DungeonOverview::block_color(int block, int px, int py) const
+{
+    const int x0 = px * block, x1 = std::min(x0 + block, dungeon->getWidth());
+    const int y0 = py * block, y1 = std::min(y0 + block, dungeon->getHeight());
+    uint32_t floor = 0;
+    for (int y = y0; y < y1; y++)
+        for (int x = x0; x < x1; x++)
+            floor += dungeon->isFloor(x, y);
+    return mix_color(WallColor, FloorColor, floor, uint32_t((x1 - x0) * (y1 - y0)));
+}
+
+void OverviewTextures::apply(SDL_Renderer *renderer, const OverviewCommands &commands)
+{
+    for (const auto &upload : commands.uploads) {
+        if (upload.level >= textures.size()) {
+            textures.resize(upload.level + 1);
+            raw.resize(upload.level + 1, nullptr);
+        }
+        TexturePtr &texture = textures[upload.level];
+        float w = 0, h = 0;
+        if (texture)
+            SDL_GetTextureSize(texture.get(), &w, &h);
+        if (!texture || int(w) != upload.levelWidth || int(h) != upload.levelHeight) {
+            // остальное в новой текстуре не определено, ждём загрузки всего уровня
+            if (upload.width != upload.levelWidth || upload.height != upload.levelHeight)
+                continue;
+            texture = TexturePtr(SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, upload.levelWidth, upload.levelHeight),
+                                 SDL_DestroyTexture);
+            raw[upload.level] = texture.get();
+            if (!texture) {
+                std::cerr << "Failed to create an overview texture: " << SDL_GetError() << std::endl;
+                continue;
+            }
+            SDL_SetTextureScaleMode(texture.get(), SDL_SCALEMODE_LINEAR);
+            SDL_SetTextureBlendMode(texture.get(), SDL_BLENDMODE_NONE);
+        }
+        const SDL_Rect rect = { upload.x, upload.y, upload.width, upload.height };
+        SDL_UpdateTexture(texture.get(), &rect, commands.pixels.data() + upload.firstPixel, upload.width * 4);
+    }
+}
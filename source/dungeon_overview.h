@@ -0,0 +1,79 @@
+#pragma once
+
+#include "dungeon_tiles.h"
+#include <SDL3/SDL_render.h>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+// Загрузки уровней обзорной карты для потока отрисовки в этом кадре
+struct OverviewCommands {
+    struct Upload {
+        uint32_t level;
+        int levelWidth, levelHeight; // размер всего уровня, то есть его текстуры
+        int x, y, width, height;     // обновляемый прямоугольник уровня
+        uint32_t firstPixel;         // в pixels, строки прямоугольника подряд без отступов
+    };
+
+    std::vector<Upload> uploads;
+    std::vector<uint32_t> pixels; // SDL_PIXELFORMAT_RGBA8888
+
+    void clear() {
+        uploads.clear();
+        pixels.clear();
+    }
+};
+
+// Обзорная карта подземелья для сильного отдаления, как mip-уровни: пиксель уровня level
+// сводит блок 2^level x 2^level клеток в один цвет между WallColor и FloorColor по доле пола.
+// Уровень считается целиком при первом запросе и после подмены карты; правки карты
+// (Dungeon::getEditsSince) пересчитывают и загружают только пиксели их блоков, а когда журнал
+// их уже не помнит или их слишком много - уровень снова считается целиком. Сервис мира на потоке симуляции: он только готовит
+// пиксели, текстуры - у OverviewTextures на потоке отрисовки
+class DungeonOverview {
+public:
+    // больше не у всякого рендерера получится создать текстуру
+    static constexpr int MaxTextureSize = 4096;
+    static constexpr uint32_t WallColor = 0x2a2633ffu;
+    static constexpr uint32_t FloorColor = 0x8c7a64ffu;
+
+    explicit DungeonOverview(std::shared_ptr<DungeonTiles> tiles)
+        : tiles(tiles) {}
+
+    // Уровень для масштаба: пиксель уровня не крупнее пикселя экрана, но текстура не больше MaxTextureSize
+    uint32_t choose_level(float pixelsPerMeter) const;
+    // Клеток в стороне пикселя уровня
+    static int get_block(uint32_t level) { return 1 << level; }
+
+    // Досчитывает уровень, если нужно, и дописывает его загрузку в commands
+    void prepare(uint32_t level, OverviewCommands &commands);
+
+private:
+    // Правок больше, чем такая доля пикселей уровня, - дешевле посчитать его целиком
+    static constexpr int FullRebuildFraction = 8;
+
+    void build_level(uint32_t level, OverviewCommands &commands);
+    // false - уровень нужно посчитать целиком
+    bool update_level(uint32_t level, OverviewCommands &commands);
+    uint32_t block_color(int block, int px, int py) const;
+
+    std::shared_ptr<DungeonTiles> tiles;
+    std::shared_ptr<Dungeon> dungeon;
+    std::vector<uint32_t> builtRevision; // по уровням
+    std::vector<uint8_t> built;
+    std::vector<int2> edits;
+    std::vector<uint32_t> dirty; // номера пикселей уровня под правками
+};
+
+// Текстуры уровней обзорной карты; живут на потоке отрисовки и освобождаются до SDL_DestroyRenderer
+class OverviewTextures {
+public:
+    void apply(SDL_Renderer *renderer, const OverviewCommands &commands);
+
+    std::span<SDL_Texture *const> get() const { return raw; }
+
+private:
+    std::vector<TexturePtr> textures;
+    std::vector<SDL_Texture *> raw;
+};
@@ -0,0 +1,145 @@
+#pragma once
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include "math2d.h"
+
+// Метки связных областей пола (4-связность). Клетки с одинаковой меткой достижимы друг из друга,
+// поэтому заведомо невозможные цели отсекаются за O(1), без поиска пути.
+class DungeonRegions {
+public:
+    static constexpr uint32_t NoRegion = 0; // стена или клетка за пределами карты
+
+    // Полная разметка по битовой маске проходимости (формат как в Dungeon):
+    // строки режутся на отрезки пола, пересекающиеся отрезки соседних строк объединяются через union-find
+    void build(int width, int height, int wordsPerRow, const uint64_t *walkable) {
+        W = width;
+        H = height;
+        runs.clear();
+        parent.clear();
+        size_t prevBegin = 0, prevEnd = 0;
+        for (int y = 0; y < H; y++) {
+            const uint64_t *row = walkable + size_t(y) * wordsPerRow;
+            const size_t rowBegin = runs.size();
+            for (int x = next_bit(row, 0, true); x < W;) {
+                const int end = next_bit(row, x, false);
+                const uint32_t id = uint32_t(parent.size());
+                parent.push_back(id);
+                runs.push_back(Run{y, x, end, id});
+                x = next_bit(row, end, true);
+            }
+            // отрезки обеих строк отсортированы по x - идём двумя указателями
+            size_t p = prevBegin;
+            for (size_t c = rowBegin; c < runs.size(); c++) {
+                while (p < prevEnd && runs[p].x1 <= runs[c].x0)
+                    p++;
+                for (size_t q = p; q < prevEnd && runs[q].x0 < runs[c].x1; q++)
+                    unite(runs[q].id, runs[c].id);
+            }
+            prevBegin = rowBegin;
+            prevEnd = runs.size();
+        }
+
+        // корни -> плотные номера 1..N
+        std::vector<uint32_t> compact(parent.size(), NoRegion);
+        regionCount = 0;
+        for (uint32_t i = 0; i < parent.size(); i++) {
+            uint32_t root = find(i);
+            if (compact[root] == NoRegion)
+                compact[root] = ++regionCount;
+        }
+        labels.assign(size_t(W) * H, NoRegion);
+        for (const Run &run : runs) {
+            const uint32_t region = compact[find(run.id)];
+            std::fill(labels.begin() + size_t(run.y) * W + run.x0, labels.begin() + size_t(run.y) * W + run.x1, region);
+        }
+        runs.clear();
+        parent.clear();
+    }
+
+    // Клетка стала полом. Возвращает false, если изменение объединяет разные области
+    // и нужна полная перестройка (build)
+    bool on_floor_added(int2 p) {
+        uint32_t region = NoRegion;
+        for (int2 n : neighbours(p)) {
+            uint32_t r = get_region(n);
+            if (r == NoRegion)
+                continue;
+            if (region != NoRegion && r != region)
+                return false;
+            region = r;
+        }
+        labels[size_t(p.y) * W + p.x] = region != NoRegion ? region : ++regionCount;
+        return true;
+    }
+
+    // Клетка стала стеной. Возвращает false, если область могла распасться и нужна перестройка
+    bool on_floor_removed(int2 p) {
+        int floorNeighbours = 0;
+        for (int2 n : neighbours(p))
+            floorNeighbours += get_region(n) != NoRegion;
+        labels[size_t(p.y) * W + p.x] = NoRegion;
+        // номер изолированной клетки просто остаётся неиспользованным
+        return floorNeighbours <= 1;
+    }
+
+    uint32_t get_region(int2 p) const {
+        if (p.x < 0 || p.y < 0 || p.x >= W || p.y >= H)
+            return NoRegion;
+        return labels[size_t(p.y) * W + p.x];
+    }
+
+    bool same_region(int2 a, int2 b) const {
+        const uint32_t region = get_region(a);
+        return region != NoRegion && region == get_region(b);
+    }
+
+    // верхняя граница номеров областей (после правок могут быть пропуски)
+    uint32_t get_region_count() const { return regionCount; }
+
+private:
+    struct Run {
+        int y, x0, x1; // [x0, x1)
+        uint32_t id;
+    };
+    int W = 0, H = 0;
+    uint32_t regionCount = 0;
+    std::vector<uint32_t> labels;
+    std::vector<Run> runs;
+    std::vector<uint32_t> parent;
+
+    int next_bit(const uint64_t *row, int x, bool set) const {
+        if (x >= W)
+            return W;
+        int w = x >> 6;
+        uint64_t bits = (set ? row[w] : ~row[w]) & (~uint64_t(0) << (x & 63));
+        const int words = (W + 63) >> 6;
+        while (!bits) {
+            if (++w >= words)
+                return W;
+            bits = set ? row[w] : ~row[w];
+        }
+        return std::min(W, (w << 6) + std::countr_zero(bits));
+    }
+
+    uint32_t find(uint32_t i) {
+        while (parent[i] != i) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    }
+
+    void unite(uint32_t a, uint32_t b) {
+        a = find(a);
+        b = find(b);
+        if (a != b)
+            parent[std::max(a, b)] = std::min(a, b);
+    }
+
+    static std::array<int2, 4> neighbours(int2 p) {
+        return { int2{p.x + 1, p.y}, int2{p.x - 1, p.y}, int2{p.x, p.y + 1}, int2{p.x, p.y - 1} };
+    }
+};
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "dungeon_generator.h"
+#include "sprite.h"
+#include <memory>
+
+// Tile sprites of the dungeon, a world service drawn by build_render_frame.
+// Tiles are not objects: the cells are read straight from the dungeon (see BackgroundCache),
+// so an edited cell shows up on the next frame
+struct DungeonTiles {
+    std::shared_ptr<Dungeon> dungeon;
+    Sprite floor[Dungeon::FloorVariants];
+    Sprite wall;
+};
@@ -0,0 +1,297 @@
+#include "flow_field.h"
+
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <bit>
+#include <iterator>
+
+// Меньше строк на поток не окупает синхронизацию между волнами
+static constexpr int MinRowsPerThread = 64;
+
+// set_sources правит поле на месте, пока изменилось не больше этой доли источников: каждый убранный
+// источник заново заливает свою область, при многих изменениях одна битовая перестройка дешевле
+static constexpr size_t IncrementalSourceFraction = 4;
+
+FlowField::FlowField(std::shared_ptr<Dungeon> dungeon, std::shared_ptr<WorkerPool> pool)
+    : dungeon(dungeon), pool(pool),
+      W(dungeon->getWidth()), H(dungeon->getHeight()), wordsPerRow(dungeon->getWordsPerRow()),
+      dungeonRevision(dungeon->getRevision())
+{
+    const size_t cells = size_t(W) * H;
+    const size_t words = size_t(wordsPerRow) * H;
+    distance.assign(cells, Unreachable);
+    direction.assign(cells, None);
+    sourceCount.assign(cells, 0);
+    frontier.assign(words, 0);
+    nextFrontier.assign(words, 0);
+    visited.assign(words, 0);
+    rowRange.assign(H, WordRange{});
+    nextRowRange.assign(H, WordRange{});
+}
+
+void FlowField::add_source(int2 cell)
+{
+    if (!in_bounds(cell))
+        return;
+    const size_t i = index(cell);
+    if (sourceCount[i]++ == 0)
+        sources.push_back(cell);
+    if (dirty || distance[i] == 0 || !dungeon->isFloor(cell.x, cell.y))
+        return;
+    distance[i] = 0;
+    direction[i] = None;
+    relax_from(cell);
+}
+
+void FlowField::remove_source(int2 cell)
+{
+    if (!in_bounds(cell))
+        return;
+    uint16_t &count = sourceCount[index(cell)];
+    if (count > 0 && --count == 0 && !dirty)
+        repair_removed(cell);
+}
+
+void FlowField::set_sources(std::span<const int2> cells)
+{
+    auto less = [](int2 a, int2 b) { return a.y != b.y ? a.y < b.y : a.x < b.x; };
+    // прежние и новые клетки-источники без повторов
+    previousCells.clear();
+    for (int2 cell : sources)
+        if (sourceCount[index(cell)] > 0)
+            previousCells.push_back(cell);
+    std::sort(previousCells.begin(), previousCells.end(), less);
+    previousCells.erase(std::unique(previousCells.begin(), previousCells.end(), [](int2 a, int2 b) { return a.x == b.x && a.y == b.y; }),
+                        previousCells.end());
+    for (int2 cell : sources)
+        sourceCount[index(cell)] = 0;
+    sources.clear();
+    for (int2 cell : cells) {
+        if (in_bounds(cell) && sourceCount[index(cell)]++ == 0)
+            sources.push_back(cell);
+    }
+    nextCells.assign(sources.begin(), sources.end());
+    std::sort(nextCells.begin(), nextCells.end(), less);
+    if (dirty)
+        return;
+
+    removedCells.clear();
+    addedCells.clear();
+    std::set_difference(previousCells.begin(), previousCells.end(), nextCells.begin(), nextCells.end(), std::back_inserter(removedCells), less);
+    std::set_difference(nextCells.begin(), nextCells.end(), previousCells.begin(), previousCells.end(), std::back_inserter(addedCells), less);
+    if ((removedCells.size() + addedCells.size()) * IncrementalSourceFraction > std::max(previousCells.size(), nextCells.size())) {
+        dirty = true;
+        return;
+    }
+    for (int2 cell : removedCells)
+        repair_removed(cell);
+    for (int2 cell : addedCells) {
+        const size_t i = index(cell);
+        if (distance[i] == 0 || !dungeon->isFloor(cell.x, cell.y))
+            continue;
+        distance[i] = 0;
+        direction[i] = None;
+        relax_from(cell);
+    }
+}
+
+void FlowField::update()
+{
+    if (dungeonRevision != dungeon->getRevision()) {
+        dungeonRevision = dungeon->getRevision();
+        dirty = true;
+    }
+    if (dirty)
+        rebuild();
+}
+
+void FlowField::relax_from(int2 cell)
+{
+    queue.clear();
+    queue.push_back(cell);
+    for (size_t head = 0; head < queue.size(); head++) {
+        const int2 c = queue[head];
+        const uint16_t d = distance[index(c)] + 1;
+        for (uint8_t dir = Left; dir <= Down; dir++) {
+            // сосед, из которого шаг dir ведёт в c
+            const int2 n{c.x - Steps[dir].x, c.y - Steps[dir].y};
+            if (!dungeon->isFloor(n.x, n.y) || distance[index(n)] <= d)
+                continue;
+            distance[index(n)] = d;
+            direction[index(n)] = dir;
+            queue.push_back(n);
+        }
+    }
+}
+
+void FlowField::repair_removed(int2 cell)
+{
+    if (distance[index(cell)] != 0)
+        return; // источник в стене ничего не заливал
+    // Поддерево: клетки, чей шаг direction ведёт в уже найденную клетку поддерева.
+    // Остальные клетки ведут к другим источникам, их расстояния не меняются
+    queue.clear();
+    queue.push_back(cell);
+    distance[index(cell)] = Unreachable;
+    direction[index(cell)] = None;
+    for (size_t head = 0; head < queue.size(); head++) {
+        const int2 c = queue[head];
+        for (uint8_t dir = Left; dir <= Down; dir++) {
+            const int2 n{c.x - Steps[dir].x, c.y - Steps[dir].y};
+            if (!in_bounds(n) || distance[index(n)] == Unreachable || direction[index(n)] != dir)
+                continue;
+            distance[index(n)] = Unreachable;
+            direction[index(n)] = None;
+            queue.push_back(n);
+        }
+    }
+    // Граница поддерева с верными расстояниями, по возрастанию расстояния
+    seeds.clear();
+    for (int2 c : queue)
+        for (const int2 step : { Steps[Left], Steps[Right], Steps[Up], Steps[Down] }) {
+            const int2 n{c.x + step.x, c.y + step.y};
+            if (dungeon->isFloor(n.x, n.y) && distance[index(n)] != Unreachable)
+                seeds.push_back(n);
+        }
+    std::sort(seeds.begin(), seeds.end(), [&](int2 a, int2 b) { return distance[index(a)] < distance[index(b)]; });
+
+    // BFS от всех границ сразу: границы вливаются в очередь по мере того, как волна доходит до их расстояния,
+    // так что клетка получает расстояние один раз. Заливка не выходит за поддерево, снаружи расстояния не больше
+    queue.clear();
+    size_t head = 0, seed = 0;
+    while (head < queue.size() || seed < seeds.size()) {
+        int2 c;
+        if (seed < seeds.size() && (head == queue.size() || distance[index(seeds[seed])] <= distance[index(queue[head])]))
+            c = seeds[seed++];
+        else
+            c = queue[head++];
+        const uint16_t d = distance[index(c)] + 1;
+        for (uint8_t dir = Left; dir <= Down; dir++) {
+            const int2 n{c.x - Steps[dir].x, c.y - Steps[dir].y};
+            if (!dungeon->isFloor(n.x, n.y) || distance[index(n)] <= d)
+                continue;
+            distance[index(n)] = d;
+            direction[index(n)] = dir;
+            queue.push_back(n);
+        }
+    }
+}
+
+// Одна волна BFS для строк [yBegin, yEnd): 64 клетки за операцию.
+// Читает frontier (соседние строки тоже), пишет только свои строки nextFrontier/visited/distance
+bool FlowField::expand_rows(int yBegin, int yEnd, uint16_t wave)
+{
+    bool any = false;
+    for (int y = yBegin; y < yEnd; y++) {
+        uint64_t *next = nextFrontier.data() + size_t(y) * wordsPerRow;
+        // диапазоны меняются местами вместе с буферами, так что nextRowRange[y] - это старое содержимое next
+        WordRange &nextRange = nextRowRange[y];
+        if (!nextRange.empty())
+            std::fill(next + nextRange.lo, next + nextRange.hi + 1, 0);
+        nextRange = WordRange{};
+
+        // сверху/снизу слова те же, по горизонтали перенос захватывает соседнее слово
+        WordRange range = rowRange[y];
+        if (!range.empty())
+            range = WordRange{range.lo - 1, range.hi + 1};
+        for (int ny : {y - 1, y + 1}) {
+            if (ny < 0 || ny >= H || rowRange[ny].empty())
+                continue;
+            range = range.empty() ? rowRange[ny] : WordRange{std::min(range.lo, rowRange[ny].lo), std::max(range.hi, rowRange[ny].hi)};
+        }
+        range.lo = std::max(range.lo, 0);
+        range.hi = std::min(range.hi, wordsPerRow - 1);
+        if (range.empty())
+            continue;
+
+        const uint64_t *cur = frontier.data() + size_t(y) * wordsPerRow;
+        const uint64_t *up = y > 0 ? cur - wordsPerRow : nullptr;
+        const uint64_t *down = y + 1 < H ? cur + wordsPerRow : nullptr;
+        const uint64_t *walk = dungeon->getWalkableRow(y);
+        uint64_t *seen = visited.data() + size_t(y) * wordsPerRow;
+        for (int w = range.lo; w <= range.hi; w++) {
+            // бит x в fromLeft: клетка x - 1 в текущей волне, значит шаг из x - влево
+            const uint64_t fromLeft = (cur[w] << 1) | (w > 0 ? cur[w - 1] >> 63 : 0);
+            const uint64_t fromRight = (cur[w] >> 1) | (w + 1 < wordsPerRow ? cur[w + 1] << 63 : 0);
+            const uint64_t fromUp = up ? up[w] : 0;
+            const uint64_t fromDown = down ? down[w] : 0;
+            const uint64_t reached = (fromLeft | fromRight | fromUp | fromDown) & walk[w] & ~seen[w];
+            next[w] = reached;
+            if (!reached)
+                continue;
+            seen[w] |= reached;
+            if (nextRange.empty())
+                nextRange.lo = w;
+            nextRange.hi = w;
+            any = true;
+            for (uint64_t bits = reached; bits; bits &= bits - 1) {
+                const int bit = std::countr_zero(bits);
+                const uint64_t mask = uint64_t(1) << bit;
+                const size_t i = size_t(y) * W + (w << 6) + bit;
+                distance[i] = wave;
+                direction[i] = (fromLeft & mask) ? Left : (fromRight & mask) ? Right : (fromUp & mask) ? Up : Down;
+            }
+        }
+    }
+    return any;
+}
+
+void FlowField::rebuild()
+{
+    dirty = false;
+    std::fill(distance.begin(), distance.end(), Unreachable);
+    std::fill(direction.begin(), direction.end(), None);
+    std::fill(frontier.begin(), frontier.end(), 0);
+    std::fill(visited.begin(), visited.end(), 0);
+    std::fill(nextFrontier.begin(), nextFrontier.end(), 0);
+    std::fill(rowRange.begin(), rowRange.end(), WordRange{});
+    std::fill(nextRowRange.begin(), nextRowRange.end(), WordRange{});
+
+    // выкидываем удалённые источники, нулевая волна - все оставшиеся
+    std::erase_if(sources, [&](int2 cell) { return sourceCount[index(cell)] == 0; });
+    for (int2 cell : sources) {
+        if (!dungeon->isFloor(cell.x, cell.y))
+            continue;
+        const uint64_t bit = uint64_t(1) << (cell.x & 63);
+        frontier[size_t(cell.y) * wordsPerRow + (cell.x >> 6)] |= bit;
+        visited[size_t(cell.y) * wordsPerRow + (cell.x >> 6)] |= bit;
+        WordRange &range = rowRange[cell.y];
+        range = range.empty() ? WordRange{cell.x >> 6, cell.x >> 6}
+                              : WordRange{std::min(range.lo, cell.x >> 6), std::max(range.hi, cell.x >> 6)};
+        distance[index(cell)] = 0;
+    }
+    if (sources.empty())
+        return;
+
+    const int threads = pool ? std::clamp(pool->get_thread_count(), 1, std::max(1, H / MinRowsPerThread)) : 1;
+    if (threads == 1) {
+        for (uint16_t wave = 1; wave < Unreachable && expand_rows(0, H, wave); wave++) {
+            frontier.swap(nextFrontier);
+            rowRange.swap(nextRowRange);
+        }
+        return;
+    }
+
+    // Строки делятся между потоками, между волнами - барьер
+    std::atomic<bool> anyReached = false;
+    uint16_t wave = 1;
+    bool done = false;
+    auto onWaveDone = [&]() noexcept {
+        frontier.swap(nextFrontier);
+        rowRange.swap(nextRowRange);
+        done = !anyReached.exchange(false) || wave + 1 == Unreachable;
+        wave++;
+    };
+    std::barrier sync(threads, onWaveDone);
+    auto worker = [&](int t) {
+        const int yBegin = H * t / threads;
+        const int yEnd = H * (t + 1) / threads;
+        while (!done) {
+            if (expand_rows(yBegin, yEnd, wave))
+                anyReached.store(true, std::memory_order_relaxed);
+            sync.arrive_and_wait();
+        }
+    };
+    pool->run(threads, worker);
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "dungeon_generator.h"
+#include "math2d.h"
+#include "worker_pool.h"
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+// Карта расстояний от множества источников (еда, хищники) по сетке Dungeon.
+// Для каждой клетки хранится расстояние и направление первого шага к ближайшему источнику,
+// так что агент узнаёт свой следующий шаг за O(1), без собственного поиска.
+class FlowField {
+public:
+    static constexpr uint16_t Unreachable = 0xFFFF;
+
+    // Полная перестройка делит строки между потоками pool; без pool - в вызывающем потоке
+    explicit FlowField(std::shared_ptr<Dungeon> dungeon, std::shared_ptr<WorkerPool> pool = nullptr);
+
+    // Новый источник досчитывается сразу: волна идёт только по клеткам, где расстояние уменьшилось
+    void add_source(int2 cell);
+    // Тоже сразу: пересчитываются только клетки, чей ближайший источник был этим
+    // (поддерево направлений с корнем в cell), от соседних клеток с прежними расстояниями
+    void remove_source(int2 cell);
+    // Заменить все источники (например, позиции жертв на этом тике). Если изменилась малая
+    // часть источников, поле правится как add_source/remove_source, иначе перестраивается в update()
+    void set_sources(std::span<const int2> cells);
+
+    // Перестраивает поле, если источники были удалены или карта изменилась
+    void update();
+
+    uint16_t get_distance(int2 cell) const {
+        if (!in_bounds(cell))
+            return Unreachable;
+        return distance[index(cell)];
+    }
+
+    // Шаг к ближайшему источнику, {0, 0} - уже на источнике или источник недостижим
+    int2 next_step(int2 cell) const {
+        if (!in_bounds(cell))
+            return int2{};
+        return Steps[direction[index(cell)]];
+    }
+
+    // Шаг от ближайшего источника: в соседнюю клетку с наибольшим расстоянием
+    int2 step_away(int2 cell) const {
+        const uint16_t here = get_distance(cell);
+        int2 best{};
+        if (here == Unreachable)
+            return best;
+        uint16_t bestDistance = here;
+        for (int dir = 0; dir < 4; dir++) {
+            const int2 next{cell.x + Steps[dir].x, cell.y + Steps[dir].y};
+            const uint16_t d = get_distance(next);
+            if (d != Unreachable && d > bestDistance) {
+                bestDistance = d;
+                best = Steps[dir];
+            }
+        }
+        return best;
+    }
+
+private:
+    enum Direction : uint8_t { Left, Right, Up, Down, None };
+    static constexpr int2 Steps[5] = { int2{-1, 0}, int2{1, 0}, int2{0, -1}, int2{0, 1}, int2{0, 0} };
+
+    std::shared_ptr<Dungeon> dungeon;
+    std::shared_ptr<WorkerPool> pool;
+    int W, H, wordsPerRow;
+    uint32_t dungeonRevision;
+    bool dirty = true;
+
+    std::vector<uint16_t> distance;
+    std::vector<uint8_t> direction;
+    std::vector<uint16_t> sourceCount; // несколько источников могут стоять в одной клетке
+    std::vector<int2> sources;         // может содержать повторы и уже удалённые клетки
+
+    // битовые слои волны, в формате Dungeon::getWalkableRow
+    std::vector<uint64_t> frontier, nextFrontier, visited;
+    // непустые слова строки frontier: волна обходит только их окрестность, а не всю карту
+    struct WordRange {
+        int lo = 0, hi = -1;
+        bool empty() const { return lo > hi; }
+    };
+    std::vector<WordRange> rowRange, nextRowRange;
+    std::vector<int2> queue;
+    std::vector<int2> seeds;
+    std::vector<int2> previousCells, nextCells, removedCells, addedCells; // для set_sources
+
+    bool in_bounds(int2 cell) const { return cell.x >= 0 && cell.y >= 0 && cell.x < W && cell.y < H; }
+    size_t index(int2 cell) const { return size_t(cell.y) * W + cell.x; }
+
+    void rebuild();
+    bool expand_rows(int yBegin, int yEnd, uint16_t wave);
+    void relax_from(int2 cell);
+    void repair_removed(int2 cell);
+};
+
+// Поля, общие для всех агентов мира (см. World::get_service)
+struct FlowFields {
+    FlowField food;
+    FlowField prey;
+
+    explicit FlowFields(std::shared_ptr<Dungeon> dungeon, std::shared_ptr<WorkerPool> pool = nullptr)
+        : food(dungeon, pool), prey(dungeon, pool) {}
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "component.h"
+#include "world.h"
+#include "flow_field.h"
+#include "food_consumer.h"
+#include "influence_map.h"
+#include "predator.h"
+#include "transform2d.h"
+
+// Keeps the shared flow fields and the danger map up to date: prey follows food consumers
+// and predators stamp danger every tick, food sources are kept up to date by FoodStorage
+class FlowFieldSystem : public Component {
+    std::shared_ptr<FlowFields> fields;
+    std::shared_ptr<InfluenceMap> danger;
+    std::vector<int2> prey;
+public:
+    static constexpr float PredatorDanger = 1.f;
+
+    FlowFieldSystem(std::shared_ptr<FlowFields> fields, std::shared_ptr<InfluenceMap> danger)
+        : fields(fields), danger(danger) {}
+
+    void on_update(float dt) override {
+        prey.clear();
+        for (auto& obj : get_owner()->get_world()->get_objects()) {
+            auto transform = obj->get_component<Transform2D>();
+            if (!transform)
+                continue;
+            if (obj->get_component<Predator>())
+                danger->stamp(int2((int)transform->x, (int)transform->y), PredatorDanger);
+            else if (obj->get_component<FoodConsumer>())
+                prey.push_back(int2((int)transform->x, (int)transform->y));
+        }
+        fields->prey.set_sources(prey);
+        fields->food.update();
+        fields->prey.update();
+        danger->update();
+    }
+};
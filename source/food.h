@@ -1,8 +1,14 @@
 #pragma once
 
-#include "component.h"
-class IFood : public Component {
+#include "food_storage.h"
+#include "sprite.h"
+#include "tileset.h"
+#include <vector>
 
-public:
-    virtual void on_consume(GameObjectPtr consumer) = 0;
-};
\ No newline at end of file
+// Sprites of the FoodStorage kinds, by kind index; a world service drawn by build_render_frame
+struct FoodSprites {
+    std::vector<Sprite> byKind;
+};
+
+// Registers the game's food kinds in the storage and their sprites
+void add_food_kinds(FoodStorage &storage, FoodSprites &sprites, TileSet &tileset);
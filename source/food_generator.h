@@ -1,51 +1,54 @@
 #pragma once
 
 #include "game_object.h"
-#include "math2d.h"
-#include "food.h"
+#include "food_spawner.h"
+#include "food_storage.h"
 #include "dungeon_generator.h"
+#include "world.h"
+#include "random.h"
+#include "timer_wheel.h"
 
-
-class IFoodFabrique : public Component {
-public:
-    virtual GameObjectPtr create_food(int2 position) = 0;
-    virtual int weight() const = 0; // for weighted random selection
-};
-
+// Spawns food through FoodSpawner on a periodic timer; uneaten food spoils after lifetime seconds
 class FoodGenerator : public Component {
 private:
-    std::shared_ptr<Dungeon> dungeon;
-    std::vector<std::unique_ptr<IFoodFabrique>> fabriques;
-    float timeSinceLastSpawn = 0.f; // seconds between spawns
-    float spawnInterval = 1.f;
-    int fabriquesProbabilitySum = 0;
+    std::shared_ptr<FoodStorage> storage;
+    FoodSpawner spawner;
+    float spawnInterval = 1.f; // seconds between spawns
+    float lifetime = 60.f;     // seconds until uneaten food spoils
+    std::shared_ptr<TimerWheel> timers;
+    TimerId spawnTimer;
+    uint32_t spawnedThisTick = 0; // index for Random when several spawns happen in one tick
+    uint32_t lastSpawnTick = 0;
 public:
 
-    FoodGenerator(std::shared_ptr<Dungeon> dungeon, std::vector<std::unique_ptr<IFoodFabrique>> fabriques, float spawnInterval)
-        : dungeon(dungeon), fabriques(std::move(fabriques)), spawnInterval(spawnInterval)
-    {
-        for (const auto& fabrique : this->fabriques)
-            fabriquesProbabilitySum += fabrique->weight();
-    }
+    // density - food per room cell, see FoodSpawner
+    FoodGenerator(std::shared_ptr<Dungeon> dungeon, std::shared_ptr<FoodStorage> storage, float spawnInterval,
+                  float lifetime, float density)
+        : storage(storage), spawner(dungeon, storage, density), spawnInterval(spawnInterval), lifetime(lifetime) {}
 
     void generate_random_food()
     {
-        auto position = dungeon->getRandomFloorPosition();
-        int rand_value = rand() % fabriquesProbabilitySum;
-        for (const auto& fabrique : fabriques) {
-            if (rand_value < fabrique->weight()) {
-                fabrique->create_food(position);
-                break;
-            }
-            rand_value -= fabrique->weight();
+        auto owner = get_owner();
+        auto random = owner->get_world()->get_service<Random>();
+        if (!random)
+            return;
+        const uint32_t tick = owner->get_world()->get_tick();
+        if (tick != lastSpawnTick) {
+            lastSpawnTick = tick;
+            spawnedThisTick = 0;
         }
+        const FoodId id = spawner.spawn(*random, owner->get_id(), tick, spawnedThisTick++);
+        // small trivially copyable capture, std::function keeps it without allocating
+        if (id.is_valid() && timers)
+            timers->after(lifetime, [storage = storage.get(), id] { storage->remove(id); });
     }
-    void on_update(float dt) override {
-        timeSinceLastSpawn += dt;
-        if (timeSinceLastSpawn >= spawnInterval) {
-            timeSinceLastSpawn = 0.f;
-            // spawn food
-            generate_random_food();
-        }
+    void on_create() override {
+        timers = get_owner()->get_world()->get_service<TimerWheel>();
+        if (timers)
+            spawnTimer = timers->every(spawnInterval, [this] { generate_random_food(); });
     }
-};
\ No newline at end of file
+    void on_destroy() override {
+        if (timers)
+            timers->cancel(spawnTimer);
+    }
+};
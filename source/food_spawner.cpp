@@ -0,0 +1,49 @@
+#include "food_spawner.h"
+
+#include <algorithm>
+
+FoodSpawner::FoodSpawner(std::shared_ptr<Dungeon> dungeon, std::shared_ptr<FoodStorage> storage, float density)
+    : dungeon(dungeon), storage(storage)
+{
+    std::vector<double> weights;
+    for (const Room &room : dungeon->getRooms())
+        weights.push_back(double(room.w) * room.h);
+    if (weights.empty())
+        weights.push_back(double(dungeon->getFloorCount()));
+    rooms.build(weights);
+    for (double area : weights) {
+        caps.push_back(std::max(1u, uint32_t(area * density)));
+        capacity += caps.back();
+    }
+
+    weights.clear();
+    for (const auto &kind : storage->get_kinds())
+        weights.push_back(double(kind.weight));
+    kinds.build(weights);
+    // все номера еды заводятся сразу, дальше они только переиспользуются
+    storage->reserve(capacity);
+}
+
+FoodId FoodSpawner::spawn(const Random &random, uint32_t entity, uint32_t tick, uint32_t index)
+{
+    if (rooms.empty() || kinds.empty())
+        return FoodId{};
+    const auto position = random.generate(entity, tick, FoodPosition, index);
+    const uint32_t room = rooms.sample(position[0], position[1]);
+    if (storage->get_room_count(room) >= caps[room])
+        return FoodId{};
+    int2 cell;
+    const auto &dungeonRooms = dungeon->getRooms();
+    if (dungeonRooms.empty()) {
+        cell = dungeon->getFloorPosition(uint32_t((uint64_t(position[2]) * dungeon->getFloorCount()) >> 32));
+    } else {
+        const Room &r = dungeonRooms[room];
+        cell = int2(r.x + int((uint64_t(position[2]) * uint32_t(r.w)) >> 32),
+                    r.y + int((uint64_t(position[3]) * uint32_t(r.h)) >> 32));
+        // комната загруженного уровня могла быть изменена setTile
+        if (!dungeon->isFloor(cell.x, cell.y))
+            return FoodId{};
+    }
+    const auto kind = random.generate(entity, tick, FoodKind, index);
+    return storage->spawn(cell, uint8_t(kinds.sample(kind[0], kind[1])), room);
+}
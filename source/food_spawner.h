@@ -0,0 +1,36 @@
+#pragma once
+
+#include "alias_table.h"
+#include "dungeon_generator.h"
+#include "food_storage.h"
+#include "random.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Появление еды за O(1) независимо от размера карты и времени игры: комната выбирается
+// по таблице AliasTable с весом по площади, клетка - равномерно внутри неё, вид еды - по второй
+// таблице с весами видов из FoodStorage. У каждой комнаты предел density * площадь (не меньше 1);
+// если выбранная комната заполнена, еда в этот раз не появляется. Числа в комнатах ведёт FoodStorage,
+// а номера съеденной еды используются снова, так что память после заполнения не растёт.
+// Карта без комнат - одна "комната" на весь пол (медленный поиск клетки, как в Dungeon::getFloorPosition)
+class FoodSpawner {
+public:
+    // Виды еды должны быть уже добавлены в storage
+    FoodSpawner(std::shared_ptr<Dungeon> dungeon, std::shared_ptr<FoodStorage> storage, float density);
+
+    // Одна еда, числа берутся из Random для (entity, tick, index). FoodId{}, если комната заполнена
+    FoodId spawn(const Random &random, uint32_t entity, uint32_t tick, uint32_t index);
+
+    uint32_t get_room_cap(uint32_t room) const { return room < caps.size() ? caps[room] : 0; }
+    // сколько еды может быть одновременно
+    size_t get_capacity() const { return capacity; }
+
+private:
+    std::shared_ptr<Dungeon> dungeon;
+    std::shared_ptr<FoodStorage> storage;
+    AliasTable rooms;
+    AliasTable kinds;
+    std::vector<uint32_t> caps;
+    size_t capacity = 0;
+};
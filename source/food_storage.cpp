@@ -0,0 +1,100 @@
+#include "food_storage.h"
+
+#include <algorithm>
+#include <functional>
+
+uint8_t FoodStorage::add_kind(FoodItem item, int weight)
+{
+    kinds.push_back(Kind{ item, weight });
+    return uint8_t(kinds.size() - 1);
+}
+
+void FoodStorage::reserve(size_t count)
+{
+    cells.reserve(count);
+    items.reserve(count);
+    kindOf.reserve(count);
+    slotOf.reserve(count);
+    roomOf.reserve(count);
+    slots.reserve(count);
+    freeSlots.reserve(count);
+    eaten.reserve(count);
+}
+
+FoodId FoodStorage::spawn(int2 cell, uint8_t kind, uint32_t room)
+{
+    uint32_t slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        slot = uint32_t(slots.size());
+        slots.emplace_back();
+    }
+    slots[slot].index = uint32_t(cells.size());
+    cells.push_back(cell);
+    items.push_back(kinds[kind].item);
+    kindOf.push_back(kind);
+    slotOf.push_back(slot);
+    roomOf.push_back(room);
+    if (room != NoRoom) {
+        if (room >= roomCounts.size())
+            roomCounts.resize(room + 1, 0);
+        roomCounts[room]++;
+    }
+    if (fields)
+        fields->food.add_source(cell);
+    return FoodId{ slot, slots[slot].generation };
+}
+
+bool FoodStorage::remove(FoodId id)
+{
+    const uint32_t index = find(id);
+    if (index == UINT32_MAX)
+        return false;
+    remove_at(index);
+    return true;
+}
+
+void FoodStorage::remove_at(uint32_t index)
+{
+    if (fields)
+        fields->food.remove_source(cells[index]);
+    if (roomOf[index] != NoRoom)
+        roomCounts[roomOf[index]]--;
+    Slot &removed = slots[slotOf[index]];
+    removed.index = UINT32_MAX;
+    removed.generation++;
+    freeSlots.push_back(slotOf[index]);
+
+    const uint32_t last = uint32_t(cells.size() - 1);
+    if (index != last) {
+        cells[index] = cells[last];
+        items[index] = items[last];
+        kindOf[index] = kindOf[last];
+        slotOf[index] = slotOf[last];
+        roomOf[index] = roomOf[last];
+        slots[slotOf[index]].index = index;
+    }
+    cells.pop_back();
+    items.pop_back();
+    kindOf.pop_back();
+    slotOf.pop_back();
+    roomOf.pop_back();
+}
+
+void FoodStorage::consume(std::span<const uint32_t> foods, std::span<const uint32_t> consumerRows, Vitals &vitals)
+{
+    eaten.clear();
+    for (size_t i = 0; i < foods.size(); i++) {
+        const uint32_t row = consumerRows[i];
+        if (row == Vitals::Detached)
+            continue;
+        if (std::visit([&](const auto &food) { return food.apply(vitals, row); }, items[foods[i]]))
+            eaten.push_back(foods[i]);
+    }
+    // с конца: последняя еда, переезжающая на место удалённой, сама уже не удаляется
+    std::sort(eaten.begin(), eaten.end(), std::greater<>());
+    for (uint32_t index : eaten)
+        remove_at(index);
+}
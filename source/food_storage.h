@@ -0,0 +1,105 @@
+#pragma once
+
+#include "flow_field.h"
+#include "math2d.h"
+#include "vitals.h"
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <variant>
+#include <vector>
+
+// Виды еды - простые значения; новый вид добавляется в FoodItem.
+// apply возвращает false, если едоку это значение не нужно (у него нет такой шкалы), тогда еда остаётся
+struct HealthFood {
+    uint16_t restore;
+    bool apply(Vitals &vitals, uint32_t row) const {
+        if (vitals.get_max(VitalHealth, row) == 0)
+            return false;
+        vitals.change(VitalHealth, row, restore);
+        return true;
+    }
+};
+
+struct StaminaFood {
+    uint16_t restore;
+    bool apply(Vitals &vitals, uint32_t row) const {
+        if (vitals.get_max(VitalStamina, row) == 0)
+            return false;
+        vitals.change(VitalStamina, row, restore);
+        return true;
+    }
+};
+
+using FoodItem = std::variant<HealthFood, StaminaFood>;
+
+// Номер еды, не меняется при перестановках; после удаления устаревает
+struct FoodId {
+    uint32_t slot = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool is_valid() const { return slot != UINT32_MAX; }
+};
+
+// Вся еда мира (см. World::get_service) плотными массивами: клетка, значение и вид
+// (по виду выбирается спрайт). Еда не объект мира: появление, поиск и поедание идут
+// без выделения памяти и без виртуальных вызовов. Удаление переставляет последнюю еду
+// на место удалённой, внешние ссылки держат FoodId, освободившиеся номера используются снова.
+// Источники поля food в FlowFields обновляются здесь же. Еда может быть приписана к комнате,
+// тогда число еды в каждой комнате всегда известно (см. FoodSpawner)
+class FoodStorage {
+public:
+    static constexpr uint32_t NoRoom = UINT32_MAX;
+
+    struct Kind {
+        FoodItem item;
+        int weight; // относительная частота появления
+    };
+
+    explicit FoodStorage(std::shared_ptr<FlowFields> fields = nullptr)
+        : fields(fields) {}
+
+    uint8_t add_kind(FoodItem item, int weight);
+    const std::vector<Kind> &get_kinds() const { return kinds; }
+
+    // Плотные массивы, индекс < size(); после remove индексы сдвигаются
+    std::vector<int2> cells;
+    std::vector<FoodItem> items;
+    std::vector<uint8_t> kindOf;
+    std::vector<uint32_t> slotOf;
+    std::vector<uint32_t> roomOf;
+
+    size_t size() const { return cells.size(); }
+    void reserve(size_t count);
+
+    FoodId spawn(int2 cell, uint8_t kind, uint32_t room = NoRoom);
+    // false, если еды уже нет
+    bool remove(FoodId id);
+    // Индекс еды id или UINT32_MAX
+    uint32_t find(FoodId id) const {
+        return id.slot < slots.size() && slots[id.slot].generation == id.generation ? slots[id.slot].index : UINT32_MAX;
+    }
+
+    uint32_t get_room_count(uint32_t room) const {
+        return room < roomCounts.size() ? roomCounts[room] : 0;
+    }
+
+    // Пачкой: еда foods[i] (индексы, без повторов) съедается едоком со строкой Vitals consumerRows[i].
+    // Съеденная еда удаляется
+    void consume(std::span<const uint32_t> foods, std::span<const uint32_t> consumerRows, Vitals &vitals);
+
+private:
+    struct Slot {
+        uint32_t index = UINT32_MAX; // UINT32_MAX - свободен
+        uint32_t generation = 0;
+    };
+
+    std::shared_ptr<FlowFields> fields;
+    std::vector<Kind> kinds;
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+    std::vector<uint32_t> eaten;
+    std::vector<uint32_t> roomCounts;
+
+    void remove_at(uint32_t index);
+};
@@ -0,0 +1,76 @@
+#include "frame_arena.h"
+
+#include <algorithm>
+
+FrameArena::FrameArena(size_t blockSize)
+{
+    add_block(blockSize);
+    current = 0;
+}
+
+FrameArena &FrameArena::get()
+{
+    static thread_local FrameArena arena;
+    return arena;
+}
+
+void FrameArena::add_block(size_t minSize)
+{
+    blocks.push_back(Block{ std::make_unique<std::byte[]>(minSize), minSize });
+}
+
+size_t FrameArena::get_capacity() const
+{
+    size_t capacity = 0;
+    for (const Block &block : blocks)
+        capacity += block.size;
+    return capacity;
+}
+
+void *FrameArena::allocate(size_t size, size_t alignment)
+{
+    size = std::max<size_t>(size, 1);
+    for (;;) {
+        Block &block = blocks[current];
+        const uintptr_t base = uintptr_t(block.memory.get());
+        const size_t aligned = ((base + offset + alignment - 1) & ~uintptr_t(alignment - 1)) - base;
+        if (aligned + size <= block.size) {
+            used += aligned - offset + size;
+            offset = aligned + size;
+            framePeak = std::max(framePeak, used);
+            return block.memory.get() + aligned;
+        }
+        // остаток блока пропадает до конца кадра
+        used += block.size - offset;
+        if (current + 1 == blocks.size())
+            add_block(std::max(blocks.back().size * 2, size + alignment));
+        current++;
+        offset = 0;
+    }
+}
+
+void FrameArena::deallocate(void *p, size_t size)
+{
+    // вершина текущего блока: освобождения в обратном порядке возвращают память
+    std::byte *top = blocks[current].memory.get() + offset;
+    size = std::max<size_t>(size, 1);
+    if (static_cast<std::byte *>(p) + size != top)
+        return;
+    offset -= size;
+    used -= size;
+}
+
+void FrameArena::reset()
+{
+    highWater = std::max(highWater, framePeak);
+    if (blocks.size() > 1) {
+        // кадр не уместился в один блок: дальше хватит одного на всё
+        const size_t total = get_capacity();
+        blocks.clear();
+        add_block(total);
+    }
+    current = 0;
+    offset = 0;
+    used = 0;
+    framePeak = 0;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+// Линейный распределитель для данных, живущих один кадр. У каждого потока свой (get).
+// Выделение - сдвиг указателя в текущем блоке; если блок кончился, заводится следующий.
+// reset в конце кадра освобождает всё разом, а блоки, понадобившиеся за кадр, сливаются в один
+// блок их общего размера: после первых кадров память из кучи больше не берётся.
+// deallocate возвращает память, только если она на вершине (временные массивы, освобождаемые
+// в обратном порядке), остальное ждёт reset.
+// Пик за кадр (читать до reset) и за всё время - для профилировщика (см. main.cpp)
+class FrameArena {
+public:
+    static constexpr size_t DefaultBlockSize = size_t(64) << 10;
+
+    explicit FrameArena(size_t blockSize = DefaultBlockSize);
+    FrameArena(const FrameArena &) = delete;
+    FrameArena &operator=(const FrameArena &) = delete;
+
+    // Распределитель текущего потока
+    static FrameArena &get();
+
+    void *allocate(size_t size, size_t alignment);
+    void deallocate(void *p, size_t size);
+    // Конец кадра: всё выделенное недействительно
+    void reset();
+
+    size_t get_used() const { return used; }
+    size_t get_frame_peak() const { return framePeak; }
+    size_t get_high_water() const { return highWater; }
+    size_t get_capacity() const;
+
+private:
+    struct Block {
+        std::unique_ptr<std::byte[]> memory;
+        size_t size;
+    };
+
+    std::vector<Block> blocks;
+    size_t current = 0; // блок, из которого идут выделения
+    size_t offset = 0;  // занято в текущем блоке
+    size_t used = 0;    // занято за кадр во всех блоках, с выравниванием
+    size_t framePeak = 0, highWater = 0;
+
+    void add_block(size_t minSize);
+};
+
+// Распределитель для контейнеров STL поверх FrameArena; контейнер должен умереть до reset
+template <class T>
+class FrameAllocator {
+public:
+    using value_type = T;
+
+    FrameAllocator(FrameArena &arena = FrameArena::get()) noexcept
+        : arena(&arena) {}
+    template <class U>
+    FrameAllocator(const FrameAllocator<U> &other) noexcept
+        : arena(other.arena) {}
+
+    T *allocate(size_t n) {
+        return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T *p, size_t n) noexcept {
+        arena->deallocate(p, n * sizeof(T));
+    }
+
+    template <class U>
+    bool operator==(const FrameAllocator<U> &other) const noexcept { return arena == other.arena; }
+
+private:
+    template <class U>
+    friend class FrameAllocator;
+    FrameArena *arena;
+};
+
+template <class T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
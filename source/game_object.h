@@ -1,5 +1,6 @@
 #pragma once
 #include "component.h"
+#include <cstdint>
 #include <memory>
 #include <unordered_map>
 #include <typeindex>
@@ -59,9 +60,15 @@ public:
         return world.lock().get();
     }
 
+    // unique within the world, assigned in World::create_object (stable key for Random)
+    uint32_t get_id() const {
+        return id;
+    }
+
 private:
     std::unordered_map<std::type_index, std::shared_ptr<Component>> components;
     std::weak_ptr<World> world;
+    uint32_t id = 0;
     friend class World;
 };
 
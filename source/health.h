@@ -1,17 +1,8 @@
 #pragma once
 
-#include "component.h"
+#include "vital_component.h"
 
-class Health : public Component {
+class Health : public VitalComponent {
 public:
-    int current;
-    int max;
-
-    Health(int maxHealth) : current(maxHealth), max(maxHealth) {}
-
-    void change(int delta) {
-        current += delta;
-        if (current > max) current = max;
-        if (current < 0) current = 0;
-    }
-};
\ No newline at end of file
+    Health(int maxHealth) : VitalComponent(VitalHealth, maxHealth) {}
+};
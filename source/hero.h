@@ -1,14 +1,17 @@
 #pragma once
 #include "game_object.h"
-#include "restrictor.h"
+#include "world.h"
+#include "walkability_grid.h"
 #include "stamina.h"
-#include <SDL3/SDL.h>
+#include "input_state.h"
 #include <algorithm>
 
 class Hero : public Component {
 private:
     float timeSinceLastMode = 0.f; // seconds between movement steps
     GameObjectPtr mainCamera;
+    std::shared_ptr<WalkabilityGrid> grid;
+    std::shared_ptr<InputState> input;
 
     void bind_camera_transform() {
         auto transform = get_owner()->get_component<Transform2D>();
@@ -27,23 +30,23 @@ public:
         : mainCamera(mainCamera) {}
 
     void on_create() override {
+        grid = get_owner()->get_world()->get_service<WalkabilityGrid>();
+        input = get_owner()->get_world()->get_service<InputState>();
         bind_camera_transform();
     }
 
     void on_update(float dt) override {
-        const bool* keys = SDL_GetKeyboardState(nullptr);
         auto transform = get_owner()->get_component<Transform2D>();
-        auto restrictor = get_owner()->get_component<IRestrictor>();
         auto stamina = get_owner()->get_component<Stamina>();
-        if (!transform || !restrictor || !stamina)
+        if (!transform || !grid || !stamina || !input)
             return;
         const float cellPerSecond = stamina->get_speed();
         int2 intDelta;
         bool moved = false;
-        if (keys[SDL_SCANCODE_W]) { intDelta.y -= 1; moved = true; }
-        if (keys[SDL_SCANCODE_S]) { intDelta.y += 1; moved = true; }
-        if (keys[SDL_SCANCODE_A]) { intDelta.x -= 1; moved = true; }
-        if (keys[SDL_SCANCODE_D]) { intDelta.x += 1; moved = true; }
+        if (input->is_pressed(InputKey::Up)) { intDelta.y -= 1; moved = true; }
+        if (input->is_pressed(InputKey::Down)) { intDelta.y += 1; moved = true; }
+        if (input->is_pressed(InputKey::Left)) { intDelta.x -= 1; moved = true; }
+        if (input->is_pressed(InputKey::Right)) { intDelta.x += 1; moved = true; }
         if (!moved)
             return;
         if (moved && (timeSinceLastMode < 1.f / cellPerSecond)) {
@@ -52,7 +55,7 @@ public:
         }
         timeSinceLastMode = 0.f;
         int2 newPos = int2((int)transform->x + intDelta.x, (int)transform->y + intDelta.y);
-        if (restrictor->can_pass(newPos)) {
+        if (grid->can_pass(newPos)) {
             transform->x += intDelta.x;
             transform->y += intDelta.y;
             bind_camera_transform();
@@ -0,0 +1,963 @@
+#include "hierarchical_pathfinder.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+
+static uint32_t manhattan(int2 a, int2 b)
+{
+    return uint32_t(std::abs(a.x - b.x) + std::abs(a.y - b.y));
+}
+
+static bool contains(const Room &room, int2 cell)
+{
+    return cell.x >= room.x && cell.y >= room.y && cell.x < room.x + room.w && cell.y < room.y + room.h;
+}
+
+static const int2 Neighbours[4] = { int2{1, 0}, int2{-1, 0}, int2{0, 1}, int2{0, -1} };
+
+static bool intersects(const Room &room, int x0, int y0, int x1, int y1)
+{
+    return room.x <= x1 && room.y <= y1 && room.x + room.w > x0 && room.y + room.h > y0;
+}
+
+HierarchicalPathfinder::HierarchicalPathfinder(std::shared_ptr<Dungeon> dungeon, int chunkSize)
+    : dungeon(dungeon), W(dungeon->getWidth()), H(dungeon->getHeight()), chunkSize(std::max(chunkSize, 1))
+{
+    rebuild();
+}
+
+// Каждая комната, пересекающая box, - ровно один раз: в корзине, где начинается пересечение
+template<typename Fn>
+void HierarchicalPathfinder::for_each_room_in(Box box, Fn &&fn) const
+{
+    box = Box{std::max(box.x0, 0), std::max(box.y0, 0), std::min(box.x1, W - 1), std::min(box.y1, H - 1)};
+    if (box.x0 > box.x1 || box.y0 > box.y1)
+        return;
+    for (int by = box.y0 / BucketSize; by <= box.y1 / BucketSize; by++) {
+        for (int bx = box.x0 / BucketSize; bx <= box.x1 / BucketSize; bx++) {
+            const uint32_t bucket = uint32_t(by) * bucketsX + bx;
+            for (uint32_t i = bucketStart[bucket]; i < bucketStart[bucket + 1]; i++) {
+                const Room &room = rooms[bucketRooms[i]];
+                if (intersects(room, box.x0, box.y0, box.x1, box.y1) &&
+                    std::max(room.x, box.x0) / BucketSize == bx && std::max(room.y, box.y0) / BucketSize == by)
+                    fn(int(bucketRooms[i]));
+            }
+        }
+    }
+}
+
+int HierarchicalPathfinder::room_at(int2 cell) const
+{
+    if (cell.x < 0 || cell.y < 0 || cell.x >= W || cell.y >= H)
+        return NoRoom;
+    const uint32_t bucket = uint32_t(cell.y / BucketSize) * bucketsX + cell.x / BucketSize;
+    for (uint32_t i = bucketStart[bucket]; i < bucketStart[bucket + 1]; i++) {
+        if (solid[bucketRooms[i]] && contains(rooms[bucketRooms[i]], cell))
+            return int(bucketRooms[i]);
+    }
+    return NoRoom;
+}
+
+bool HierarchicalPathfinder::is_room_solid(const Room &room) const
+{
+    if (room.w <= 0 || room.h <= 0 || room.x < 0 || room.y < 0 || room.x + room.w > W || room.y + room.h > H)
+        return false;
+    for (int y = room.y; y < room.y + room.h; y++)
+        for (int x = room.x; x < room.x + room.w; x++)
+            if (!dungeon->isFloor(x, y))
+                return false;
+    return true;
+}
+
+// Узел - клетка коридора рядом с комнатой (дверь) или с тремя и больше соседями по коридору (развилка)
+bool HierarchicalPathfinder::is_node_cell(int2 cell) const
+{
+    if (!is_corridor(cell))
+        return false;
+    int corridorNeighbours = 0;
+    for (int2 d : Neighbours) {
+        const int2 next{cell.x + d.x, cell.y + d.y};
+        if (!dungeon->isFloor(next.x, next.y))
+            continue;
+        if (room_at(next) != NoRoom)
+            return true;
+        corridorNeighbours++;
+    }
+    return corridorNeighbours >= 3;
+}
+
+int2 HierarchicalPathfinder::inside(int2 door, int room) const
+{
+    for (int2 d : Neighbours) {
+        const int2 cell{door.x + d.x, door.y + d.y};
+        if (contains(rooms[room], cell))
+            return cell;
+    }
+    return door;
+}
+
+void HierarchicalPathfinder::bfs_begin()
+{
+    bfsQueue.clear();
+    if (++bfsGeneration == 0) {
+        std::fill(bfsCells.begin(), bfsCells.end(), BfsCell{});
+        bfsGeneration = 1;
+    }
+}
+
+void HierarchicalPathfinder::bfs_seed(uint32_t cell)
+{
+    bfsCells[cell] = BfsCell{bfsGeneration, cell};
+    bfsQueue.push_back(QueueItem{cell, 0});
+}
+
+template<typename OnReach>
+void HierarchicalPathfinder::bfs_run(uint32_t target, OnReach &&onReach)
+{
+    for (size_t head = 0; head < bfsQueue.size(); head++) {
+        const QueueItem item = bfsQueue[head];
+        const int2 cell = to_cell(item.cell);
+        for (int2 d : Neighbours) {
+            const int2 next{cell.x + d.x, cell.y + d.y};
+            if (!is_corridor(next))
+                continue;
+            const uint32_t i = index(next);
+            if (bfsCells[i].generation == bfsGeneration)
+                continue;
+            bfsCells[i] = BfsCell{bfsGeneration, item.cell};
+            if (nodeAt[i] != NoNode || i == target) {
+                if (onReach(i, item.distance + 1))
+                    return;
+                continue;
+            }
+            bfsQueue.push_back(QueueItem{i, item.distance + 1});
+        }
+    }
+}
+
+template<typename OnReach>
+void HierarchicalPathfinder::corridor_bfs(int2 from, uint32_t target, OnReach &&onReach)
+{
+    bfs_begin();
+    bfs_seed(index(from));
+    bfs_run(target, onReach);
+}
+
+uint32_t HierarchicalPathfinder::add_node(int2 cell)
+{
+    const uint32_t node = uint32_t(nodeCell.size());
+    nodeAt[index(cell)] = node;
+    nodeCell.push_back(cell);
+    nodeChunk.push_back(chunk_of(cell));
+    portalOf.push_back(NoNode);
+    affectedMark.push_back(0);
+    edges.grow(nodeCell.size());
+    liveNodes++;
+    return node;
+}
+
+void HierarchicalPathfinder::remove_node(uint32_t node)
+{
+    nodeAt[index(nodeCell[node])] = NoNode;
+    nodeCell[node] = int2{-1, -1};
+    liveNodes--;
+}
+
+// Двери комнаты - узлы по её периметру снаружи
+void HierarchicalPathfinder::build_room_doors(int room)
+{
+    doorScratch.clear();
+    const Room &r = rooms[room];
+    auto addDoor = [&](int2 door, int2 in) {
+        if (door.x < 0 || door.y < 0 || door.x >= W || door.y >= H)
+            return;
+        const uint32_t node = nodeAt[index(door)];
+        if (node != NoNode && room_at(in) == room)
+            doorScratch.push_back(RoomDoor{node, in});
+    };
+    if (solid[room]) {
+        for (int x = r.x; x < r.x + r.w; x++) {
+            addDoor(int2{x, r.y - 1}, int2{x, r.y});
+            addDoor(int2{x, r.y + r.h}, int2{x, r.y + r.h - 1});
+        }
+        for (int y = r.y; y < r.y + r.h; y++) {
+            addDoor(int2{r.x - 1, y}, int2{r.x, y});
+            addDoor(int2{r.x + r.w, y}, int2{r.x + r.w - 1, y});
+        }
+    }
+    roomDoors.set(room, doorScratch);
+}
+
+// Рёбра узла: в другие двери его комнат (стоимость - манхэттен внутри прямоугольника) и по коридору до соседних узлов
+void HierarchicalPathfinder::build_node_edges(uint32_t node)
+{
+    edgeScratch.clear();
+    const int2 cell = nodeCell[node];
+    if (cell.x >= 0) {
+        for (int2 d : Neighbours) {
+            const int2 next{cell.x + d.x, cell.y + d.y};
+            const int room = room_at(next);
+            if (room == NoRoom)
+                continue;
+            for (const RoomDoor &door : roomDoors.get(room)) {
+                if (door.node != node)
+                    edgeScratch.push_back(Edge{door.node, manhattan(next, door.inside) + 2, room});
+            }
+        }
+        corridor_bfs(cell, NoNode, [&](uint32_t reached, uint32_t distance) {
+            edgeScratch.push_back(Edge{nodeAt[reached], distance, NoRoom});
+            return false;
+        });
+    }
+    edges.set(node, edgeScratch);
+}
+
+// Рёбра портала: переходы в соседний кусок как есть, внутри куска - Дейкстра по узлам куска
+void HierarchicalPathfinder::build_portal_edges(uint32_t portal)
+{
+    edgeScratch.clear();
+    const uint32_t node = portalNode[portal];
+    if (node != NoNode) {
+        const uint32_t chunk = nodeChunk[node];
+        for (const Edge &edge : edges.get(node)) {
+            if (nodeChunk[edge.to] != chunk)
+                edgeScratch.push_back(Edge{portalOf[edge.to], edge.cost, edge.room});
+        }
+        startEdges.assign(1, Edge{node, 0, NoRoom});
+        goalEdges.clear();
+        directCost = NoNode;
+        chunkFilter.assign(1, chunk);
+        search_nodes(nodeCell[node], nodeCell[node], false);
+        for (uint32_t other : chunkPortals.get(chunk)) {
+            const SearchNode &s = search[portalNode[other]];
+            // до порталов за другим порталом Дейкстра не дошла: такой путь - цепочка рёбер
+            if (other != portal && s.generation == generation && s.closed)
+                edgeScratch.push_back(Edge{other, s.g, InsideChunk});
+        }
+        chunkFilter.clear();
+    }
+    portalEdges.set(portal, edgeScratch);
+}
+
+// Поколения не сбрасываются: метки прошлых поисков меньше поколения следующего,
+// поэтому бывшие виртуальные старт и цель становятся обычными узлами без очистки
+void HierarchicalPathfinder::resize_search()
+{
+    // + виртуальные старт и цель
+    search.resize(nodeCell.size() + 2);
+    goalEdges.resize(nodeCell.size());
+    portalSearch.resize(portalNode.size() + 2);
+    portalGoalCost.resize(portalNode.size());
+}
+
+void HierarchicalPathfinder::update()
+{
+    if (built && builtRevision == dungeon->getRevision())
+        return;
+    if (!built || !apply_edits())
+        rebuild();
+}
+
+void HierarchicalPathfinder::rebuild()
+{
+    builtRevision = dungeon->getRevision();
+    built = true;
+
+    // Кластеры - только комнаты, целиком состоящие из пола; в корзины попадают все комнаты
+    // внутри карты, чтобы правка могла сделать комнату кластером снова
+    rooms = dungeon->getRooms();
+    solid.resize(rooms.size());
+    for (size_t r = 0; r < rooms.size(); r++)
+        solid[r] = is_room_solid(rooms[r]);
+    bucketsX = (W + BucketSize - 1) / BucketSize;
+    bucketsY = (H + BucketSize - 1) / BucketSize;
+    bucketStart.assign(size_t(bucketsX) * bucketsY + 1, 0);
+    auto inBounds = [&](const Room &room) {
+        return room.w > 0 && room.h > 0 && room.x >= 0 && room.y >= 0 && room.x + room.w <= W && room.y + room.h <= H;
+    };
+    auto forEachBucket = [&](const Room &room, auto &&fn) {
+        for (int by = room.y / BucketSize; by <= (room.y + room.h - 1) / BucketSize; by++)
+            for (int bx = room.x / BucketSize; bx <= (room.x + room.w - 1) / BucketSize; bx++)
+                fn(size_t(by) * bucketsX + bx);
+    };
+    for (const Room &room : rooms)
+        if (inBounds(room))
+            forEachBucket(room, [&](size_t bucket) { bucketStart[bucket + 1]++; });
+    for (size_t i = 1; i < bucketStart.size(); i++)
+        bucketStart[i] += bucketStart[i - 1];
+    bucketRooms.resize(bucketStart.back());
+    {
+        std::vector<uint32_t> fill(bucketStart.begin(), bucketStart.end() - 1);
+        for (uint32_t r = 0; r < rooms.size(); r++)
+            if (inBounds(rooms[r]))
+                forEachBucket(rooms[r], [&](size_t bucket) { bucketRooms[fill[bucket]++] = r; });
+    }
+
+    // Узлы: двери и развилки коридоров
+    chunksX = (W + chunkSize - 1) / chunkSize;
+    chunksY = (H + chunkSize - 1) / chunkSize;
+    nodeAt.assign(size_t(W) * H, NoNode);
+    bfsCells.assign(size_t(W) * H, BfsCell{});
+    bfsGeneration = 0;
+    nodeCell.clear();
+    nodeChunk.clear();
+    portalOf.clear();
+    affectedMark.clear();
+    edges.reset(0);
+    liveNodes = 0;
+    // Узлы (а за ними и порталы) нумеруются по кускам: поиск внутри куска и по порталам
+    // соседних кусков читает близкие адреса, а не строки через всю карту
+    for (int cy = 0; cy < chunksY; cy++) {
+        for (int cx = 0; cx < chunksX; cx++) {
+            const int x0 = cx * chunkSize, x1 = std::min(x0 + chunkSize, W);
+            for (int y = cy * chunkSize; y < std::min((cy + 1) * chunkSize, H); y++) {
+                const uint64_t *row = dungeon->getWalkableRow(y);
+                for (int w = x0 >> 6; w <= (x1 - 1) >> 6; w++) {
+                    const int lo = std::max(x0 - (w << 6), 0), hi = std::min(x1 - (w << 6), 64);
+                    const uint64_t mask = (hi == 64 ? ~0ull : (1ull << hi) - 1) & (~0ull << lo);
+                    for (uint64_t bits = row[w] & mask; bits; bits &= bits - 1) {
+                        const int2 cell{(w << 6) + std::countr_zero(bits), y};
+                        if (is_node_cell(cell))
+                            add_node(cell);
+                    }
+                }
+            }
+        }
+    }
+
+    roomDoors.reset(rooms.size());
+    for (int room = 0; room < int(rooms.size()); room++)
+        build_room_doors(room);
+    for (uint32_t node = 0; node < nodeCell.size(); node++)
+        build_node_edges(node);
+    resize_search();
+
+    // Портал - узел, из которого есть ребро в другой кусок
+    portalNode.clear();
+    for (uint32_t node = 0; node < nodeCell.size(); node++) {
+        for (const Edge &edge : edges.get(node)) {
+            if (nodeChunk[edge.to] != nodeChunk[node]) {
+                portalOf[node] = uint32_t(portalNode.size());
+                portalNode.push_back(node);
+                break;
+            }
+        }
+    }
+    livePortals = portalNode.size();
+    chunkPortals.reset(size_t(chunksX) * chunksY);
+    chunkScratch.assign(portalNode.size(), 0);
+    for (uint32_t portal = 0; portal < portalNode.size(); portal++)
+        chunkScratch[portal] = portal;
+    std::stable_sort(chunkScratch.begin(), chunkScratch.end(), [&](uint32_t a, uint32_t b) {
+        return nodeChunk[portalNode[a]] < nodeChunk[portalNode[b]];
+    });
+    for (size_t begin = 0, end = 0; begin < chunkScratch.size(); begin = end) {
+        const uint32_t chunk = nodeChunk[portalNode[chunkScratch[begin]]];
+        while (end < chunkScratch.size() && nodeChunk[portalNode[chunkScratch[end]]] == chunk)
+            end++;
+        chunkPortals.set(chunk, std::span<const uint32_t>(chunkScratch.data() + begin, end - begin));
+    }
+    resize_search();
+    portalEdges.reset(portalNode.size());
+    for (uint32_t portal = 0; portal < portalNode.size(); portal++)
+        build_portal_edges(portal);
+    build_landmarks();
+    expandedNodes = 0;
+}
+
+void HierarchicalPathfinder::mark_affected(uint32_t node)
+{
+    if (!affectedMark[node]) {
+        affectedMark[node] = 1;
+        affected.push_back(node);
+    }
+}
+
+// Применяет правки из журнала Dungeon. false - журнал не помнит правок или их слишком много, нужна полная перестройка
+bool HierarchicalPathfinder::apply_edits()
+{
+    edits.clear();
+    if (!dungeon->getEditsSince(builtRevision, edits))
+        return false;
+    builtRevision = dungeon->getRevision();
+    if (edits.empty())
+        return true;
+
+    // Прямоугольники, где мог смениться статус узла: клетка правки с соседями,
+    // а если правка сделала комнату кластером или перестала - вся комната с соседями
+    boxes.clear();
+    for (int2 cell : edits) {
+        boxes.push_back(Box{cell.x - 1, cell.y - 1, cell.x + 1, cell.y + 1});
+        for_each_room_in(Box{cell.x, cell.y, cell.x, cell.y}, [&](int room) {
+            const bool now = is_room_solid(rooms[room]);
+            if (now != bool(solid[room])) {
+                solid[room] = now;
+                const Room &r = rooms[room];
+                boxes.push_back(Box{r.x - 1, r.y - 1, r.x + r.w, r.y + r.h});
+            }
+        });
+    }
+    for (Box &box : boxes)
+        box = Box{std::max(box.x0, 0), std::max(box.y0, 0), std::min(box.x1, W - 1), std::min(box.y1, H - 1)};
+
+    affected.clear();
+    for (const Box &box : boxes) {
+        for (int y = box.y0; y <= box.y1; y++) {
+            for (int x = box.x0; x <= box.x1; x++) {
+                const int2 cell{x, y};
+                const uint32_t node = nodeAt[index(cell)];
+                const bool isNode = is_node_cell(cell);
+                if (isNode && node == NoNode)
+                    mark_affected(add_node(cell));
+                else if (!isNode && node != NoNode) {
+                    remove_node(node);
+                    mark_affected(node);
+                }
+            }
+        }
+    }
+
+    // Двери меняются у комнат рядом с клетками, где сменился статус узла; старые и новые двери - затронутые узлы
+    roomMark.assign(rooms.size(), 0);
+    dirtyRooms.clear();
+    for (const Box &box : boxes) {
+        for_each_room_in(Box{box.x0 - 1, box.y0 - 1, box.x1 + 1, box.y1 + 1}, [&](int room) {
+            if (!roomMark[room]) {
+                roomMark[room] = 1;
+                dirtyRooms.push_back(uint32_t(room));
+            }
+        });
+    }
+    for (uint32_t room : dirtyRooms) {
+        for (const RoomDoor &door : roomDoors.get(room))
+            mark_affected(door.node);
+        build_room_doors(int(room));
+        for (const RoomDoor &door : roomDoors.get(room))
+            mark_affected(door.node);
+    }
+
+    // Коридорные рёбра меняются у узлов, чей участок коридора касается прямоугольников правок:
+    // BFS от всех клеток коридора рядом с правками доходит ровно до них
+    bfs_begin();
+    for (const Box &box : boxes) {
+        for (int y = std::max(box.y0 - 1, 0); y <= std::min(box.y1 + 1, H - 1); y++) {
+            for (int x = std::max(box.x0 - 1, 0); x <= std::min(box.x1 + 1, W - 1); x++) {
+                const uint32_t i = index(int2{x, y});
+                if (nodeAt[i] != NoNode)
+                    mark_affected(nodeAt[i]);
+                else if (is_corridor(int2{x, y}) && bfsCells[i].generation != bfsGeneration)
+                    bfs_seed(i);
+            }
+        }
+    }
+    bfs_run(NoNode, [&](uint32_t cell, uint32_t) {
+        mark_affected(nodeAt[cell]);
+        return false;
+    });
+    for (uint32_t node : affected)
+        build_node_edges(node);
+    resize_search();
+
+    // Порталы: статус меняется только у затронутых узлов, рёбра портал-портал - во всех кусках с ними
+    newPortals.clear();
+    chunkMark.assign(size_t(chunksX) * chunksY, 0);
+    dirtyChunks.clear();
+    for (uint32_t node : affected) {
+        affectedMark[node] = 0;
+        bool portal = false;
+        for (const Edge &edge : edges.get(node))
+            portal = portal || nodeChunk[edge.to] != nodeChunk[node];
+        if (portal && portalOf[node] == NoNode) {
+            portalOf[node] = uint32_t(portalNode.size());
+            portalNode.push_back(node);
+            newPortals.push_back(portalOf[node]);
+            livePortals++;
+        } else if (!portal && portalOf[node] != NoNode) {
+            portalNode[portalOf[node]] = NoNode;
+            portalEdges.set(portalOf[node], {});
+            portalOf[node] = NoNode;
+            livePortals--;
+        }
+        if (!chunkMark[nodeChunk[node]]) {
+            chunkMark[nodeChunk[node]] = 1;
+            dirtyChunks.push_back(nodeChunk[node]);
+        }
+    }
+    portalEdges.grow(portalNode.size());
+    landmarkDistance.resize(portalNode.size() * landmarks, NoNode);
+    // Новые стены только удлиняют пути, и старые расстояния от ориентиров остаются оценкой снизу.
+    // Открытый проход может сократить путь - тогда ориентиры выключаются до перестройки
+    for (int2 cell : edits)
+        landmarksValid = landmarksValid && !dungeon->isFloor(cell.x, cell.y);
+    for (uint32_t chunk : dirtyChunks) {
+        chunkScratch.clear();
+        for (uint32_t portal : chunkPortals.get(chunk))
+            if (portalNode[portal] != NoNode)
+                chunkScratch.push_back(portal);
+        for (uint32_t portal : newPortals)
+            if (nodeChunk[portalNode[portal]] == chunk)
+                chunkScratch.push_back(portal);
+        chunkPortals.set(chunk, chunkScratch);
+    }
+    resize_search();
+    for (uint32_t chunk : dirtyChunks)
+        for (uint32_t portal : chunkPortals.get(chunk))
+            build_portal_edges(portal);
+
+    // удалённые узлы и порталы копятся, пока их не станет больше живых
+    return nodeCell.size() <= 2 * liveNodes + 1024 && portalNode.size() <= 2 * livePortals + 1024;
+}
+
+// Ориентиры выбираются "самый далёкий от уже выбранных": так они расходятся по краям карты
+void HierarchicalPathfinder::build_landmarks()
+{
+    const uint32_t portalCount = uint32_t(portalNode.size());
+    landmarks = std::min<int>(LandmarkCount, portalCount);
+    landmarksValid = true;
+    landmarkDistance.assign(size_t(portalCount) * landmarks, NoNode);
+    auto dijkstra = [&](uint32_t from) {
+        astar(portalSearch, portalGeneration, from, NoNode, [](uint32_t) { return 0u; },
+              [&](uint32_t portal, uint32_t g, auto &&open) {
+            for (const Edge &edge : portalEdges.get(portal))
+                open(edge.to, g + edge.cost, portal, edge.room);
+        });
+    };
+    std::vector<uint32_t> nearest(portalCount, NoNode);
+    uint32_t next = 0;
+    if (portalCount > 0) {
+        // первый ориентир - самый далёкий от произвольного портала
+        dijkstra(0);
+        for (uint32_t p = 0; p < portalCount; p++) {
+            const SearchNode &s = portalSearch[p];
+            if (s.generation == portalGeneration && s.g > portalSearch[next].g)
+                next = p;
+        }
+    }
+    for (int l = 0; l < landmarks; l++) {
+        dijkstra(next);
+        for (uint32_t p = 0; p < portalCount; p++) {
+            const SearchNode &s = portalSearch[p];
+            if (s.generation != portalGeneration)
+                continue;
+            landmarkDistance[size_t(p) * landmarks + l] = s.g;
+            nearest[p] = std::min(nearest[p], s.g);
+        }
+        // в другой области связности ориентир тоже пригодится, поэтому NoNode - самый далёкий
+        next = uint32_t(std::max_element(nearest.begin(), nearest.end()) - nearest.begin());
+    }
+}
+
+uint32_t HierarchicalPathfinder::landmark_heuristic(uint32_t portal) const
+{
+    uint32_t best = 0;
+    if (!landmarksValid)
+        return best;
+    const uint32_t *distance = &landmarkDistance[size_t(portal) * landmarks];
+    for (int l = 0; l < landmarks; l++) {
+        if (distance[l] == NoNode || goalLandmarkMin[l] == NoNode)
+            continue;
+        // d(n, p) >= |d(l, p) - d(l, n)| для каждого портала цели p
+        if (goalLandmarkMin[l] > distance[l])
+            best = std::max(best, goalLandmarkMin[l] - distance[l]);
+        if (distance[l] > goalLandmarkMax[l])
+            best = std::max(best, distance[l] - goalLandmarkMax[l]);
+    }
+    return best;
+}
+
+int2 HierarchicalPathfinder::node_position(uint32_t node, int2 from, int2 to) const
+{
+    if (node == nodeCell.size())
+        return from;
+    if (node == nodeCell.size() + 1)
+        return to;
+    return nodeCell[node];
+}
+
+template<typename Heuristic, typename Expand>
+bool HierarchicalPathfinder::astar(std::vector<SearchNode> &nodes, uint32_t &gen, uint32_t start, uint32_t goal,
+                                   Heuristic &&heuristic, Expand &&expand)
+{
+    heap.clear();
+    if (++gen == 0) {
+        std::fill(nodes.begin(), nodes.end(), SearchNode{});
+        gen = 1;
+    }
+    // при равном f первым раскрывается узел с большим g - тот, что ближе к цели: на сетке равных f
+    // много, и без этого A* перебирает их все
+    auto heapGreater = [](const HeapItem &a, const HeapItem &b) { return a.f > b.f || (a.f == b.f && a.g < b.g); };
+    auto open = [&](uint32_t node, uint32_t g, uint32_t parent, int via) {
+        SearchNode &s = nodes[node];
+        if (s.generation == gen && (s.closed || s.g <= g))
+            return;
+        s = SearchNode{gen, g, parent, via, false};
+        heap.push_back(HeapItem{g + heuristic(node), g, node});
+        std::push_heap(heap.begin(), heap.end(), heapGreater);
+    };
+    open(start, 0, start, NoRoom);
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), heapGreater);
+        const HeapItem item = heap.back();
+        heap.pop_back();
+        SearchNode &node = nodes[item.node];
+        if (node.closed || item.g != node.g)
+            continue;
+        node.closed = true;
+        expandedNodes++;
+        if (item.node == goal)
+            return true;
+        expand(item.node, item.g, open);
+    }
+    return false;
+}
+
+bool HierarchicalPathfinder::search_nodes(int2 from, int2 to, bool useHeuristic)
+{
+    const uint32_t startNode = uint32_t(nodeCell.size());
+    const uint32_t goalNode = startNode + 1;
+    auto heuristic = [&](uint32_t node) {
+        return useHeuristic ? manhattan(node_position(node, from, to), to) : 0;
+    };
+    // Дейкстра без цели нужна только ради расстояний до порталов. Сквозь портал не идём:
+    // всё, что за ним, достижимо по рёбрам самого портала
+    const bool stopAtPortals = !useHeuristic && goalEdges.empty() && !chunkFilter.empty();
+    return astar(search, generation, startNode, goalNode, heuristic, [&](uint32_t node, uint32_t g, auto &&open) {
+        if (node == startNode) {
+            for (const Edge &edge : startEdges)
+                open(edge.to, g + edge.cost, startNode, edge.room);
+            if (directCost != NoNode)
+                open(goalNode, g + directCost, startNode, NoRoom);
+            return;
+        }
+        // узлы за пределами разрешённых кусков открываются, но не раскрываются
+        if (!chunkFilter.empty() && std::find(chunkFilter.begin(), chunkFilter.end(), nodeChunk[node]) == chunkFilter.end())
+            return;
+        if (stopAtPortals && g > 0 && portalOf[node] != NoNode)
+            return;
+        for (const Edge &edge : edges.get(node))
+            open(edge.to, g + edge.cost, node, edge.room);
+        if (const Edge *goal = goalEdges.empty() ? nullptr : goalEdges.find(node))
+            open(goalNode, g + goal->cost, node, goal->room);
+    });
+}
+
+bool HierarchicalPathfinder::append_node_path(int2 from, int2 to, std::vector<int2> &path)
+{
+    const uint32_t startNode = uint32_t(nodeCell.size());
+    abstractPath.clear();
+    for (uint32_t node = startNode + 1; node != startNode; node = search[node].parent)
+        abstractPath.push_back(node);
+    abstractPath.push_back(startNode);
+    std::reverse(abstractPath.begin(), abstractPath.end());
+    for (size_t i = 1; i < abstractPath.size(); i++) {
+        const int2 a = node_position(abstractPath[i - 1], from, to);
+        const int2 b = node_position(abstractPath[i], from, to);
+        const int room = search[abstractPath[i]].via;
+        if (room != NoRoom)
+            walk_room(a, b, room, path);
+        else if (!walk_corridor(a, b, search[abstractPath[i]].g - search[abstractPath[i - 1]].g, path))
+            return false;
+    }
+    return true;
+}
+
+bool HierarchicalPathfinder::prepare(int2 from, int2 to)
+{
+    update();
+    expandedNodes = 0;
+    if (!dungeon->isFloor(from.x, from.y) || !dungeon->isFloor(to.x, to.y))
+        return false;
+    return dungeon->getRegions().same_region(from, to);
+}
+
+void HierarchicalPathfinder::restore_goal_edges()
+{
+    const uint32_t goalNode = uint32_t(nodeCell.size()) + 1;
+    goalEdges.clear();
+    for (const Edge &edge : savedGoalEdges)
+        goalEdges.add(edge.to, Edge{goalNode, edge.cost, edge.room});
+}
+
+// Подключает старт и цель к графу узлов
+void HierarchicalPathfinder::connect(int2 from, int2 to)
+{
+    const int startRoom = room_at(from);
+    const int goalRoom = room_at(to);
+    const uint32_t goalNode = uint32_t(nodeCell.size()) + 1;
+    startEdges.clear();
+    goalEdges.clear();
+    directCost = NoNode;
+    chunkFilter.clear();
+    if (startRoom != NoRoom) {
+        for (const RoomDoor &door : roomDoors.get(startRoom))
+            startEdges.push_back(Edge{door.node, manhattan(from, door.inside) + 1, startRoom});
+    } else if (nodeAt[index(from)] != NoNode) {
+        startEdges.push_back(Edge{nodeAt[index(from)], 0, NoRoom});
+    } else {
+        corridor_bfs(from, index(to), [&](uint32_t cell, uint32_t distance) {
+            if (cell == index(to))
+                directCost = distance;
+            if (nodeAt[cell] != NoNode)
+                startEdges.push_back(Edge{nodeAt[cell], distance, NoRoom});
+            return false;
+        });
+    }
+    auto addGoalEdge = [&](uint32_t node, uint32_t cost, int room) {
+        goalEdges.add(node, Edge{goalNode, cost, room});
+    };
+    if (goalRoom != NoRoom) {
+        for (const RoomDoor &door : roomDoors.get(goalRoom))
+            addGoalEdge(door.node, manhattan(door.inside, to) + 1, goalRoom);
+    } else if (nodeAt[index(to)] != NoNode) {
+        addGoalEdge(nodeAt[index(to)], 0, NoRoom);
+    } else {
+        corridor_bfs(to, NoNode, [&](uint32_t cell, uint32_t distance) {
+            addGoalEdge(nodeAt[cell], distance, NoRoom);
+            return false;
+        });
+    }
+}
+
+// Старт и цель подключены к узлам разных, не соседних кусков - имеет смысл искать по порталам
+bool HierarchicalPathfinder::far_apart()
+{
+    auto collect = [&](std::vector<uint32_t> &chunks, uint32_t node) {
+        if (std::find(chunks.begin(), chunks.end(), nodeChunk[node]) == chunks.end())
+            chunks.push_back(nodeChunk[node]);
+    };
+    startChunks.clear();
+    goalChunks.clear();
+    for (const Edge &edge : startEdges)
+        collect(startChunks, edge.to);
+    for (uint32_t node : goalEdges.keys)
+        collect(goalChunks, node);
+    if (directCost != NoNode || startChunks.empty() || goalChunks.empty())
+        return false;
+    for (uint32_t a : startChunks) {
+        for (uint32_t b : goalChunks) {
+            const int dx = std::abs(int(a % chunksX) - int(b % chunksX));
+            const int dy = std::abs(int(a / chunksX) - int(b / chunksX));
+            if (std::max(dx, dy) <= 1)
+                return false;
+        }
+    }
+    return true;
+}
+
+// A* по порталам. Старт и цель подключаются Дейкстрой по узлам своих кусков
+bool HierarchicalPathfinder::plan(int2 from, int2 to)
+{
+    savedStartEdges = startEdges;
+    savedGoalEdges.clear();
+    for (uint32_t node : goalEdges.keys)
+        savedGoalEdges.push_back(Edge{node, goalEdges.find(node)->cost, goalEdges.find(node)->room});
+    const uint32_t portalCount = uint32_t(portalNode.size());
+    const uint32_t startPortal = portalCount;
+    const uint32_t goalPortal = portalCount + 1;
+    auto reachedPortals = [&](const std::vector<uint32_t> &chunks, auto &&add) {
+        for (uint32_t chunk : chunks) {
+            for (uint32_t portal : chunkPortals.get(chunk)) {
+                const SearchNode &s = search[portalNode[portal]];
+                if (s.generation == generation && s.closed)
+                    add(portal, s.g);
+            }
+        }
+    };
+
+    goalEdges.clear();
+    chunkFilter = startChunks;
+    search_nodes(from, from, false);
+    portalStartEdges.clear();
+    reachedPortals(startChunks, [&](uint32_t portal, uint32_t g) {
+        portalStartEdges.push_back(Edge{portal, g, InsideChunk});
+    });
+
+    // граф неориентированный, поэтому расстояния до цели - Дейкстра от цели
+    startEdges.clear();
+    startEdges = savedGoalEdges;
+    chunkFilter = goalChunks;
+    search_nodes(to, to, false);
+    portalGoalCost.clear();
+    reachedPortals(goalChunks, [&](uint32_t portal, uint32_t g) {
+        portalGoalCost.add(portal, Edge{goalPortal, g, InsideChunk});
+    });
+
+    for (int l = 0; landmarksValid && l < landmarks; l++) {
+        goalLandmarkMin[l] = NoNode;
+        goalLandmarkMax[l] = 0;
+        for (uint32_t portal : portalGoalCost.keys) {
+            const uint32_t cost = portalGoalCost.find(portal)->cost;
+            const uint32_t d = landmarkDistance[size_t(portal) * landmarks + l];
+            if (d == NoNode)
+                continue;
+            goalLandmarkMin[l] = std::min(goalLandmarkMin[l], d + cost);
+            goalLandmarkMax[l] = std::max(goalLandmarkMax[l], d > cost ? d - cost : 0);
+        }
+    }
+    auto heuristic = [&](uint32_t portal) {
+        if (portal >= portalCount)
+            return portal == startPortal ? manhattan(from, to) : 0;
+        return std::max(manhattan(nodeCell[portalNode[portal]], to), landmark_heuristic(portal));
+    };
+    const bool found = astar(portalSearch, portalGeneration, startPortal, goalPortal, heuristic,
+                             [&](uint32_t portal, uint32_t g, auto &&open) {
+        if (portal == startPortal) {
+            for (const Edge &edge : portalStartEdges)
+                open(edge.to, g + edge.cost, startPortal, InsideChunk);
+            return;
+        }
+        for (const Edge &edge : portalEdges.get(portal))
+            open(edge.to, g + edge.cost, portal, edge.room);
+        if (const Edge *goal = portalGoalCost.find(portal))
+            open(goalPortal, g + goal->cost, portal, InsideChunk);
+    });
+    startEdges = savedStartEdges;
+    restore_goal_edges();
+    chunkFilter.clear();
+    if (!found)
+        return false;
+    portalPath.clear();
+    for (uint32_t portal = goalPortal; portal != startPortal; portal = portalSearch[portal].parent)
+        portalPath.push_back(portal);
+    portalPath.push_back(startPortal);
+    std::reverse(portalPath.begin(), portalPath.end());
+    return true;
+}
+
+bool HierarchicalPathfinder::find_path(int2 from, int2 to, std::vector<int2> &path)
+{
+    path.clear();
+    if (!prepare(from, to))
+        return false;
+    if (from.x == to.x && from.y == to.y)
+        return true;
+    const int startRoom = room_at(from);
+    if (startRoom != NoRoom && startRoom == room_at(to)) {
+        walk_room(from, to, startRoom, path);
+        return true;
+    }
+
+    connect(from, to);
+    if (!far_apart() || !plan(from, to)) {
+        if (!search_nodes(from, to, true))
+            return false;
+        return append_node_path(from, to, path);
+    }
+
+    // Уточняем каждый отрезок пути по порталам
+    const uint32_t portalCount = uint32_t(portalNode.size());
+    const uint32_t goalNode = uint32_t(nodeCell.size()) + 1;
+    for (size_t i = 1; i < portalPath.size(); i++) {
+        const uint32_t a = portalPath[i - 1];
+        const uint32_t b = portalPath[i];
+        const int2 cellA = a < portalCount ? nodeCell[portalNode[a]] : from;
+        const int2 cellB = b < portalCount ? nodeCell[portalNode[b]] : to;
+        const int via = portalSearch[b].via;
+        if (via != InsideChunk) {
+            if (via != NoRoom)
+                walk_room(cellA, cellB, via, path);
+            else if (!walk_corridor(cellA, cellB, portalSearch[b].g - portalSearch[a].g, path))
+                return false;
+            continue;
+        }
+        startEdges.clear();
+        goalEdges.clear();
+        if (a < portalCount) {
+            startEdges.push_back(Edge{portalNode[a], 0, NoRoom});
+            chunkFilter.assign(1, nodeChunk[portalNode[a]]);
+        } else {
+            startEdges = savedStartEdges;
+            chunkFilter = startChunks;
+        }
+        if (b < portalCount) {
+            goalEdges.add(portalNode[b], Edge{goalNode, 0, NoRoom});
+        } else {
+            restore_goal_edges();
+            chunkFilter = goalChunks;
+        }
+        if (!search_nodes(cellA, cellB, true) || !append_node_path(cellA, cellB, path))
+            return false;
+    }
+    chunkFilter.clear();
+    return true;
+}
+
+bool HierarchicalPathfinder::find_waypoints(int2 from, int2 to, std::vector<int2> &waypoints)
+{
+    waypoints.clear();
+    if (!prepare(from, to))
+        return false;
+    const int startRoom = room_at(from);
+    if (!(from.x == to.x && from.y == to.y) && (startRoom == NoRoom || startRoom != room_at(to))) {
+        connect(from, to);
+        if (far_apart() && plan(from, to)) {
+            for (size_t i = 1; i + 1 < portalPath.size(); i++)
+                waypoints.push_back(nodeCell[portalNode[portalPath[i]]]);
+        }
+    }
+    waypoints.push_back(to);
+    return true;
+}
+
+// L-путь через прямоугольник комнаты; концы - клетки комнаты или двери рядом с ней
+void HierarchicalPathfinder::walk_room(int2 from, int2 to, int room, std::vector<int2> &path) const
+{
+    const int2 a = contains(rooms[room], from) ? from : inside(from, room);
+    const int2 b = contains(rooms[room], to) ? to : inside(to, room);
+    int2 cell = from;
+    if (a.x != from.x || a.y != from.y)
+        path.push_back(cell = a);
+    while (cell.x != b.x) {
+        cell.x += b.x > cell.x ? 1 : -1;
+        path.push_back(cell);
+    }
+    while (cell.y != b.y) {
+        cell.y += b.y > cell.y ? 1 : -1;
+        path.push_back(cell);
+    }
+    if (b.x != to.x || b.y != to.y)
+        path.push_back(to);
+}
+
+// Коридор между узлами - цепочка клеток без развилок (развилка сама была бы узлом), и все соседи-пол
+// у такой клетки - тоже коридор. Поэтому вместо BFS ветки из from проходятся по одной не дальше length
+// (цены ребра): первая дошедшая до to и есть отрезок пути. Ветки в сторону to пробуются раньше
+bool HierarchicalPathfinder::walk_corridor(int2 from, int2 to, uint32_t length, std::vector<int2> &path) const
+{
+    if (from.x == to.x && from.y == to.y)
+        return true;
+    int2 first[4];
+    int branches = 0;
+    for (int2 d : Neighbours) {
+        const int2 cell{from.x + d.x, from.y + d.y};
+        if (is_corridor(cell))
+            first[branches++] = cell;
+    }
+    std::sort(first, first + branches, [&](int2 a, int2 b) { return manhattan(a, to) < manhattan(b, to); });
+    const size_t begin = path.size();
+    for (int b = 0; b < branches; b++) {
+        int2 prev = from, cell = first[b];
+        for (uint32_t step = 1; step <= length; step++) {
+            path.push_back(cell);
+            if (cell.x == to.x && cell.y == to.y)
+                return true;
+            if (nodeAt[index(cell)] != NoNode)
+                break;
+            int2 next = prev;
+            for (int2 d : Neighbours) {
+                const int2 n{cell.x + d.x, cell.y + d.y};
+                if ((n.x != prev.x || n.y != prev.y) && dungeon->isFloor(n.x, n.y)) {
+                    next = n;
+                    break;
+                }
+            }
+            if (next.x == prev.x && next.y == prev.y)
+                break;
+            prev = cell;
+            cell = next;
+        }
+        path.resize(begin);
+    }
+    return false;
+}
@@ -0,0 +1,283 @@
+#pragma once
+
+#include "dungeon_generator.h"
+#include "math2d.h"
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+// Иерархический поиск пути (HPA*) с комнатами Dungeon в роли кластеров.
+// Узлы абстрактного графа - двери (клетки коридора рядом с комнатой) и развилки коридоров.
+// Комната - прямоугольник сплошного пола, поэтому стоимость дверь-дверь внутри неё считается
+// манхэттеном и кэшируется при построении; рёбра по коридорам находятся BFS между соседними узлами.
+// Запрос: старт и цель подключаются к графу, A* идёт по графу, затем каждый отрезок
+// разворачивается в клетки локально (L-путь через комнату или проход по цепочке клеток коридора).
+//
+// Над этим графом есть второй уровень - квадратные куски карты по chunkSize клеток.
+// Порталы - узлы, у которых есть ребро в соседний кусок; для каждого куска заранее
+// посчитаны расстояния портал-портал внутри него. Дальний запрос сначала ищется по порталам,
+// а потом каждый отрезок уточняется поиском по узлам, ограниченным одним куском.
+// Поиск по порталам направляют ориентиры (ALT): расстояния от нескольких далёких порталов
+// до всех остальных дают по неравенству треугольника оценку намного точнее манхэттена.
+//
+// Правки карты (setTile) применяются по журналу Dungeon::getEditsSince: пересчитываются узлы
+// рядом с правкой, узлы на границах задетых ею коридоров, двери задетых комнат и порталы
+// их кусков. Всё состояние запроса - плоские массивы с поколениями, как в Pathfinder:
+// в установившемся режиме запрос не выделяет память. Один экземпляр - на один поток
+class HierarchicalPathfinder {
+public:
+    explicit HierarchicalPathfinder(std::shared_ptr<Dungeon> dungeon, int chunkSize = 64);
+
+    // Полная перестройка графа
+    void rebuild();
+    // Подтягивает правки карты; find_path и find_waypoints зовут его сами
+    void update();
+
+    // Путь без стартовой клетки, как у Pathfinder::find_path
+    bool find_path(int2 from, int2 to, std::vector<int2> &path);
+
+    // Только план по порталам: клетки, через которые пройдёт кратчайший путь, последняя - to.
+    // Агент может уточнять путь по мере движения, вызывая find_path до очередной точки
+    bool find_waypoints(int2 from, int2 to, std::vector<int2> &waypoints);
+
+    size_t get_node_count() const { return liveNodes; }
+    size_t get_edge_count() const { return edges.live; }
+    size_t get_portal_count() const { return livePortals; }
+    size_t get_portal_edge_count() const { return portalEdges.live; }
+    // узлов абстрактного графа, раскрытых последним запросом
+    size_t get_expanded_nodes() const { return expandedNodes; }
+
+private:
+    static constexpr uint32_t NoNode = 0xFFFFFFFF;
+    static constexpr int NoRoom = -1;
+    static constexpr int BucketSize = 16;
+    // ребро между порталами одного куска, путь уточняется поиском внутри куска
+    static constexpr int InsideChunk = -2;
+    static constexpr int LandmarkCount = 16;
+
+    struct Edge {
+        uint32_t to;
+        uint32_t cost;
+        int room; // через какую комнату идёт ребро, NoRoom - по коридору
+    };
+    struct RoomDoor {
+        uint32_t node;
+        int2 inside; // клетка комнаты рядом с дверью
+    };
+    struct SearchNode {
+        uint32_t generation = 0;
+        uint32_t g = 0;
+        uint32_t parent = 0;
+        int via = NoRoom;
+        bool closed = false;
+    };
+    struct HeapItem {
+        uint32_t f, g;
+        uint32_t node;
+    };
+
+    // Списки по номерам (рёбра узла, двери комнаты, порталы куска) в одном массиве.
+    // Переписанный список дописывается в конец, старое место остаётся мусором,
+    // пока мусора не станет больше живого - тогда массив уплотняется
+    template <class T>
+    struct Lists {
+        std::vector<uint32_t> start, count;
+        std::vector<T> items;
+        size_t live = 0;
+
+        void reset(size_t n) {
+            start.assign(n, 0);
+            count.assign(n, 0);
+            items.clear();
+            live = 0;
+        }
+        void grow(size_t n) {
+            start.resize(n, 0);
+            count.resize(n, 0);
+        }
+        std::span<const T> get(uint32_t i) const { return { items.data() + start[i], count[i] }; }
+        // list не должен указывать в items
+        void set(uint32_t i, std::span<const T> list) {
+            live = live - count[i] + list.size();
+            if (items.size() > 2 * live + 1024)
+                compact();
+            start[i] = uint32_t(items.size());
+            count[i] = uint32_t(list.size());
+            items.insert(items.end(), list.begin(), list.end());
+        }
+        void compact() {
+            std::vector<T> packed;
+            packed.reserve(live + live / 2);
+            for (size_t i = 0; i < start.size(); i++) {
+                const uint32_t from = start[i];
+                start[i] = uint32_t(packed.size());
+                packed.insert(packed.end(), items.begin() + from, items.begin() + from + count[i]);
+            }
+            items.swap(packed);
+        }
+    };
+
+    // Стоимости до цели по номеру узла или портала: плоский массив с поколением,
+    // очистка - смена поколения, keys - заданные номера для перебора
+    struct GoalCosts {
+        std::vector<uint32_t> stamp;
+        std::vector<Edge> edge;
+        std::vector<uint32_t> keys;
+        uint32_t generation = 1;
+
+        void resize(size_t n) {
+            stamp.resize(n, 0);
+            edge.resize(n);
+            keys.clear();
+        }
+        void clear() {
+            keys.clear();
+            if (++generation == 0) {
+                std::fill(stamp.begin(), stamp.end(), 0);
+                generation = 1;
+            }
+        }
+        bool empty() const { return keys.empty(); }
+        const Edge *find(uint32_t key) const { return stamp[key] == generation ? &edge[key] : nullptr; }
+        // из нескольких стоимостей для одного номера остаётся меньшая
+        void add(uint32_t key, Edge value) {
+            if (stamp[key] != generation) {
+                stamp[key] = generation;
+                edge[key] = value;
+                keys.push_back(key);
+            } else if (value.cost < edge[key].cost) {
+                edge[key] = value;
+            }
+        }
+    };
+
+    std::shared_ptr<Dungeon> dungeon;
+    int W, H;
+    uint32_t builtRevision = 0;
+    bool built = false;
+
+    // все комнаты Dungeon; правки карты могут испортить прямоугольник - такая комната
+    // не кластер (solid == 0), её клетки считаются коридором
+    std::vector<Room> rooms;
+    std::vector<uint8_t> solid;
+    Lists<RoomDoor> roomDoors;
+    int bucketsX = 0, bucketsY = 0;
+    std::vector<uint32_t> bucketStart, bucketRooms;
+
+    // абстрактный граф; удалённый правкой узел остаётся с nodeCell {-1, -1} и без рёбер
+    std::vector<int2> nodeCell;
+    Lists<Edge> edges;
+    std::vector<uint32_t> nodeAt; // для каждой клетки, NoNode - не узел
+    std::vector<uint32_t> nodeChunk;
+    size_t liveNodes = 0;
+
+    // граф порталов, ребро с room == InsideChunk идёт внутри куска; удалённый портал - portalNode == NoNode
+    int chunkSize, chunksX = 0, chunksY = 0;
+    std::vector<uint32_t> portalNode;  // портал -> узел
+    std::vector<uint32_t> portalOf;    // узел -> портал или NoNode
+    Lists<uint32_t> chunkPortals;
+    Lists<Edge> portalEdges;
+    size_t livePortals = 0;
+    // расстояние от ориентира l до портала p: landmarkDistance[p * landmarks + l], NoNode - недостижим.
+    // После правки, открывшей проход, старые расстояния могут дать недопустимую оценку, поэтому оценка
+    // по ориентирам выключается до полной перестройки, остаётся манхэттен
+    int landmarks = 0;
+    bool landmarksValid = false;
+    std::vector<uint32_t> landmarkDistance;
+    // для текущей цели: min(d(l, p) + цена p->цель) и max(d(l, p) - цена p->цель) по порталам цели
+    uint32_t goalLandmarkMin[LandmarkCount], goalLandmarkMax[LandmarkCount];
+
+    // состояние поиска, переживает запросы (как в Pathfinder)
+    std::vector<SearchNode> search, portalSearch;
+    std::vector<HeapItem> heap;
+    uint32_t generation = 0, portalGeneration = 0;
+    size_t expandedNodes = 0;
+    std::vector<Edge> startEdges;          // виртуальный старт -> узлы
+    GoalCosts goalEdges;                   // узел -> виртуальная цель
+    uint32_t directCost = NoNode;          // старт и цель в одном коридоре без узлов между ними
+    std::vector<uint32_t> chunkFilter;     // раскрываются только узлы этих кусков, пусто - все
+    std::vector<uint32_t> abstractPath;
+
+    // запрос по порталам: подключение старта и цели, найденный путь по порталам
+    std::vector<Edge> savedStartEdges;
+    std::vector<Edge> savedGoalEdges;      // to - узел, от которого ребро ведёт в цель
+    std::vector<uint32_t> startChunks, goalChunks;
+    std::vector<Edge> portalStartEdges;
+    GoalCosts portalGoalCost;              // портал -> цель
+    std::vector<uint32_t> portalPath;
+
+    // BFS по коридору: родитель клетки действителен, если её поколение совпадает с bfsGeneration
+    struct QueueItem {
+        uint32_t cell, distance;
+    };
+    struct BfsCell {
+        uint32_t generation = 0;
+        uint32_t parent = 0;
+    };
+    std::vector<BfsCell> bfsCells;
+    uint32_t bfsGeneration = 0;
+    std::vector<QueueItem> bfsQueue;
+
+    // сборка и обновление графа: прямоугольники клеток (включительно), где мог смениться статус узла,
+    // и затронутые правками узлы, комнаты и куски
+    struct Box {
+        int x0, y0, x1, y1;
+    };
+    std::vector<int2> edits;
+    std::vector<Box> boxes;
+    std::vector<Edge> edgeScratch;
+    std::vector<RoomDoor> doorScratch;
+    std::vector<uint32_t> affected, dirtyRooms, dirtyChunks, newPortals, chunkScratch;
+    std::vector<uint8_t> affectedMark, roomMark, chunkMark;
+
+    uint32_t index(int2 cell) const { return uint32_t(cell.y) * W + cell.x; }
+    int2 to_cell(uint32_t i) const { return int2(int(i % W), int(i / W)); }
+
+    int room_at(int2 cell) const;
+    template<typename Fn>
+    void for_each_room_in(Box box, Fn &&fn) const;
+    bool is_corridor(int2 cell) const { return dungeon->isFloor(cell.x, cell.y) && room_at(cell) == NoRoom; }
+    bool is_node_cell(int2 cell) const;
+    bool is_room_solid(const Room &room) const;
+    int2 inside(int2 door, int room) const;
+
+    // Коридорный BFS от начальных клеток до ближайших узлов (сквозь узлы не идёт), target - дополнительная цель.
+    // onReach(cell, distance) возвращает true, чтобы остановить поиск
+    void bfs_begin();
+    void bfs_seed(uint32_t cell);
+    template<typename OnReach>
+    void bfs_run(uint32_t target, OnReach &&onReach);
+    template<typename OnReach>
+    void corridor_bfs(int2 from, uint32_t target, OnReach &&onReach);
+    int2 node_position(uint32_t node, int2 from, int2 to) const;
+    uint32_t chunk_of(int2 cell) const { return uint32_t(cell.y / chunkSize) * chunksX + cell.x / chunkSize; }
+
+    uint32_t add_node(int2 cell);
+    void remove_node(uint32_t node);
+    void build_room_doors(int room);
+    void build_node_edges(uint32_t node);
+    void build_portal_edges(uint32_t portal);
+    void build_landmarks();
+    void resize_search();
+    bool apply_edits();
+    void mark_affected(uint32_t node);
+    uint32_t landmark_heuristic(uint32_t portal) const;
+    bool prepare(int2 from, int2 to);
+    void connect(int2 from, int2 to);
+    void restore_goal_edges();
+    bool far_apart();
+    bool plan(int2 from, int2 to);
+
+    template<typename Heuristic, typename Expand>
+    bool astar(std::vector<SearchNode> &nodes, uint32_t &gen, uint32_t start, uint32_t goal,
+               Heuristic &&heuristic, Expand &&expand);
+    // Поиск по узлам от startEdges до goalEdges с учётом chunkFilter
+    bool search_nodes(int2 from, int2 to, bool useHeuristic);
+    // Разворачивает найденный search_nodes путь в клетки
+    bool append_node_path(int2 from, int2 to, std::vector<int2> &path);
+
+    void walk_room(int2 from, int2 to, int room, std::vector<int2> &path) const;
+    // length - цена ребра между from и to
+    bool walk_corridor(int2 from, int2 to, uint32_t length, std::vector<int2> &path) const;
+};
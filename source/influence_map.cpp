@@ -0,0 +1,221 @@
+#include "influence_map.h"
+
+#include "simd.h"
+#include <algorithm>
+
+static constexpr int MinRowsPerThread = 64;
+
+InfluenceMap::InfluenceMap(std::shared_ptr<Dungeon> dungeon, std::shared_ptr<WorkerPool> pool, float decay, float spread)
+    : dungeon(dungeon), pool(std::move(pool)), W(dungeon->getWidth()), H(dungeon->getHeight()), decay(decay), spread(spread),
+      dungeonRevision(dungeon->getRevision())
+{
+    value.assign(size_t(W) * H, 0.f);
+    next.assign(size_t(W) * H, 0.f);
+    rowActive.assign(H, 0);
+    nextRowActive.assign(H, 0);
+    rebuild_walkable();
+}
+
+void InfluenceMap::rebuild_walkable()
+{
+    walkable.resize(size_t(W) * H);
+    for (int y = 0; y < H; y++)
+        for (int x = 0; x < W; x++)
+            walkable[size_t(y) * W + x] = dungeon->isFloor(x, y) ? 1.f : 0.f;
+}
+
+void InfluenceMap::stamp(int2 cell, float v)
+{
+    if (unsigned(cell.x) < unsigned(W) && unsigned(cell.y) < unsigned(H))
+        stamps.push_back({ cell, v });
+}
+
+#if defined(SIMD_X86)
+// Середина строки для blur_row по 8 клеток; возвращает первую непосчитанную x
+SIMD_AVX2 static int blur_row_avx2(const float *src, float *dst, int W, float side, float center)
+{
+    const __m256 s = _mm256_set1_ps(side), c = _mm256_set1_ps(center);
+    int x = 1;
+    for (; x + 8 < W; x += 8) {
+        const __m256 sides = _mm256_add_ps(_mm256_loadu_ps(src + x - 1), _mm256_loadu_ps(src + x + 1));
+        _mm256_storeu_ps(dst + x, _mm256_add_ps(_mm256_mul_ps(c, _mm256_loadu_ps(src + x)), _mm256_mul_ps(s, sides)));
+    }
+    return x;
+}
+
+// Вертикальное размытие трёх строк, затухание и стены по 8 клеток с начала строки;
+// возвращает первую непосчитанную x, any - есть ли в посчитанном ненулевые
+SIMD_AVX2 static int combine_rows_avx2(const float *up, const float *mid, const float *down, const float *mask, float *out, int W,
+                                       float vs, float vc, bool &any)
+{
+    const __m256 s = _mm256_set1_ps(vs), c = _mm256_set1_ps(vc), eps = _mm256_set1_ps(InfluenceMap::Epsilon);
+    __m256 anyMask = _mm256_setzero_ps();
+    int x = 0;
+    for (; x + 8 <= W; x += 8) {
+        __m256 v = _mm256_add_ps(_mm256_mul_ps(c, _mm256_loadu_ps(mid + x)),
+                                 _mm256_mul_ps(s, _mm256_add_ps(_mm256_loadu_ps(up + x), _mm256_loadu_ps(down + x))));
+        v = _mm256_mul_ps(v, _mm256_loadu_ps(mask + x));
+        const __m256 keep = _mm256_cmp_ps(v, eps, _CMP_GE_OQ);
+        v = _mm256_and_ps(v, keep);
+        anyMask = _mm256_or_ps(anyMask, keep);
+        _mm256_storeu_ps(out + x, v);
+    }
+    any = _mm256_movemask_ps(anyMask) != 0;
+    return x;
+}
+
+// То же по 4 клетки на SSE2
+static int blur_row_sse2(const float *src, float *dst, int W, float side, float center)
+{
+    const __m128 s = _mm_set1_ps(side), c = _mm_set1_ps(center);
+    int x = 1;
+    for (; x + 4 < W; x += 4) {
+        const __m128 sides = _mm_add_ps(_mm_loadu_ps(src + x - 1), _mm_loadu_ps(src + x + 1));
+        _mm_storeu_ps(dst + x, _mm_add_ps(_mm_mul_ps(c, _mm_loadu_ps(src + x)), _mm_mul_ps(s, sides)));
+    }
+    return x;
+}
+
+static int combine_rows_sse2(const float *up, const float *mid, const float *down, const float *mask, float *out, int W,
+                             float vs, float vc, bool &any)
+{
+    const __m128 s = _mm_set1_ps(vs), c = _mm_set1_ps(vc), eps = _mm_set1_ps(InfluenceMap::Epsilon);
+    __m128 anyMask = _mm_setzero_ps();
+    int x = 0;
+    for (; x + 4 <= W; x += 4) {
+        __m128 v = _mm_add_ps(_mm_mul_ps(c, _mm_loadu_ps(mid + x)), _mm_mul_ps(s, _mm_add_ps(_mm_loadu_ps(up + x), _mm_loadu_ps(down + x))));
+        v = _mm_mul_ps(v, _mm_loadu_ps(mask + x));
+        const __m128 keep = _mm_cmpge_ps(v, eps);
+        v = _mm_and_ps(v, keep);
+        anyMask = _mm_or_ps(anyMask, keep);
+        _mm_storeu_ps(out + x, v);
+    }
+    any = _mm_movemask_ps(anyMask) != 0;
+    return x;
+}
+#endif
+
+// Размытие строки src по горизонтали в dst
+static void blur_row(const float *src, float *dst, int W, float side, float center, SimdLevel simd)
+{
+    if (W == 1) {
+        dst[0] = center * src[0];
+        return;
+    }
+    dst[0] = center * src[0] + side * src[1];
+    int x = 1;
+#if defined(SIMD_X86)
+    if (simd == SimdLevel::Avx2)
+        x = blur_row_avx2(src, dst, W, side, center);
+    else if (simd == SimdLevel::Sse2)
+        x = blur_row_sse2(src, dst, W, side, center);
+#endif
+    for (; x + 1 < W; x++)
+        dst[x] = center * src[x] + side * (src[x - 1] + src[x + 1]);
+    dst[W - 1] = center * src[W - 1] + side * src[W - 2];
+}
+
+void InfluenceMap::update_rows(int yBegin, int yEnd, std::span<float> scratch)
+{
+    // три размытых по горизонтали строки: y - 1, y, y + 1 (scratch на 3 * W)
+    std::fill(scratch.begin(), scratch.end(), 0.f);
+    float *rows[3] = { scratch.data(), scratch.data() + W, scratch.data() + 2 * W };
+    int rowsReady = -2; // номер строки в rows[1], если она посчитана для текущего y
+    const float side = spread, center = 1.f - 2.f * spread;
+    const SimdLevel simd = get_simd_level();
+    auto horizontal = [&](int y, float *dst) {
+        if (y < 0 || y >= H || !rowActive[y])
+            std::fill(dst, dst + W, 0.f);
+        else
+            blur_row(value.data() + size_t(y) * W, dst, W, side, center, simd);
+    };
+    for (int y = yBegin; y < yEnd; y++) {
+        float *out = next.data() + size_t(y) * W;
+        const bool needed = (y > 0 && rowActive[y - 1]) || rowActive[y] || (y + 1 < H && rowActive[y + 1]);
+        if (!needed) {
+            // строка в next могла остаться с позапрошлого тика
+            if (nextRowActive[y])
+                std::fill(out, out + W, 0.f);
+            nextRowActive[y] = 0;
+            continue;
+        }
+        if (rowsReady == y - 1) {
+            std::rotate(rows, rows + 1, rows + 3);
+            horizontal(y + 1, rows[2]);
+        } else {
+            horizontal(y - 1, rows[0]);
+            horizontal(y, rows[1]);
+            horizontal(y + 1, rows[2]);
+        }
+        rowsReady = y;
+
+        const float *up = rows[0], *mid = rows[1], *down = rows[2];
+        const float *mask = walkable.data() + size_t(y) * W;
+        const float vs = decay * side, vc = decay * center;
+        int x = 0;
+        bool any = false;
+#if defined(SIMD_X86)
+        if (simd == SimdLevel::Avx2)
+            x = combine_rows_avx2(up, mid, down, mask, out, W, vs, vc, any);
+        else if (simd == SimdLevel::Sse2)
+            x = combine_rows_sse2(up, mid, down, mask, out, W, vs, vc, any);
+#endif
+        for (; x < W; x++) {
+            float v = (vc * mid[x] + vs * (up[x] + down[x])) * mask[x];
+            v = v >= Epsilon ? v : 0.f;
+            any |= v != 0.f;
+            out[x] = v;
+        }
+        nextRowActive[y] = any;
+    }
+}
+
+void InfluenceMap::update()
+{
+    if (dungeon->getRevision() != dungeonRevision) {
+        dungeonRevision = dungeon->getRevision();
+        rebuild_walkable();
+    }
+
+    const int threads = std::clamp(pool ? pool->get_thread_count() : 1, 1, std::max(1, H / MinRowsPerThread));
+    if (scratch.size() < size_t(threads))
+        scratch.resize(threads, std::vector<float>(size_t(W) * 3));
+    if (threads == 1) {
+        update_rows(0, H, scratch[0]);
+    } else {
+        // строки next пишет только свой поток, value и rowActive только читаются
+        pool->run(threads, [&](int t) { update_rows(H * t / threads, H * (t + 1) / threads, scratch[t]); });
+    }
+    value.swap(next);
+    rowActive.swap(nextRowActive);
+
+    for (const Stamp &s : stamps) {
+        float &v = value[size_t(s.cell.y) * W + s.cell.x];
+        v = std::max(v, s.value);
+        rowActive[s.cell.y] |= v != 0.f;
+    }
+    stamps.clear();
+}
+
+int2 InfluenceMap::step_down(int2 cell) const
+{
+    static constexpr int2 Steps[4] = { int2{-1, 0}, int2{1, 0}, int2{0, -1}, int2{0, 1} };
+    float best = get(cell);
+    int2 step{};
+    for (int2 d : Steps) {
+        const int2 n{cell.x + d.x, cell.y + d.y};
+        if (unsigned(n.x) >= unsigned(W) || unsigned(n.y) >= unsigned(H) || walkable[size_t(n.y) * W + n.x] == 0.f)
+            continue;
+        const float v = value[size_t(n.y) * W + n.x];
+        if (v < best) {
+            best = v;
+            step = d;
+        }
+    }
+    return step;
+}
+
+size_t InfluenceMap::get_active_row_count() const
+{
+    return size_t(std::count(rowActive.begin(), rowActive.end(), uint8_t(1)));
+}
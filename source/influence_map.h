@@ -0,0 +1,64 @@
+#pragma once
+
+#include "dungeon_generator.h"
+#include "math2d.h"
+#include "worker_pool.h"
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+// Карта влияния (опасности) по сетке Dungeon. Источники (хищники) каждый тик ставят
+// в свою клетку значение stamp(), а update() размывает карту сепарабельным ядром
+// [spread, 1 - 2*spread, spread] по строкам и по столбцам и умножает на decay:
+// опасность расплывается от источника и гаснет, когда он ушёл. Стены обнуляют значение.
+// Агент узнаёт опасность в клетке одним чтением, без поиска по хищникам.
+// Обновляются только строки рядом с ненулевыми; значения меньше Epsilon обнуляются,
+// так что пустые области карты ничего не стоят. Строки считаются параллельно на потоках pool
+// (без него - на вызывающем), по 8 клеток на AVX2 и по 4 на SSE2 (см. simd.h)
+class InfluenceMap {
+public:
+    static constexpr float Epsilon = 1.f / 1024;
+
+    explicit InfluenceMap(std::shared_ptr<Dungeon> dungeon, std::shared_ptr<WorkerPool> pool = nullptr,
+                          float decay = 0.9f, float spread = 0.25f);
+
+    // Значение в клетке после следующего update() не меньше value
+    void stamp(int2 cell, float value);
+    // Один шаг распространения и затухания, затем применяются накопленные stamp()
+    void update();
+
+    float get(int2 cell) const {
+        if (unsigned(cell.x) >= unsigned(W) || unsigned(cell.y) >= unsigned(H))
+            return 0.f;
+        return value[size_t(cell.y) * W + cell.x];
+    }
+
+    // Шаг в соседнюю клетку с наименьшим значением, {0, 0} - ни один сосед не ниже текущей
+    int2 step_down(int2 cell) const;
+
+    // строк с ненулевыми значениями
+    size_t get_active_row_count() const;
+
+private:
+    std::shared_ptr<Dungeon> dungeon;
+    std::shared_ptr<WorkerPool> pool;
+    int W, H;
+    float decay, spread;
+    uint32_t dungeonRevision;
+
+    std::vector<float> value, next;
+    std::vector<uint8_t> rowActive, nextRowActive;
+    std::vector<float> walkable; // 1 - пол, 0 - стена
+    struct Stamp {
+        int2 cell;
+        float value;
+    };
+    std::vector<Stamp> stamps;
+    // три строки промежуточного размытия на поток; потоки пула живут всю игру,
+    // поэтому буферы свои, а не из FrameArena (её у рабочих никто не сбрасывает)
+    std::vector<std::vector<float>> scratch;
+
+    void rebuild_walkable();
+    void update_rows(int yBegin, int yEnd, std::span<float> scratch);
+};
@@ -5,19 +5,34 @@
 #include "transform2d.h"
 #include "sprite.h"
 #include "hero.h"
-#include "enemy.h"
 #include "world.h"
 #include "camera2d.h"
-#include "dungeon_restrictor.h"
+#include "camera_zoom.h"
+#include "input_state.h"
+#include "walkability_grid.h"
 #include "tileset.h"
 #include "food_generator.h"
+#include "food.h"
 #include "health.h"
 #include "stamina.h"
 #include "food_consumer.h"
-#include "starvation_system.h"
-#include "tiredness_system.h"
-#include "background_tag.h"
+#include "vitals_system.h"
+#include "timer_system.h"
+#include "background_cache.h"
+#include "dungeon_overview.h"
+#include "scene_index.h"
 #include "predator.h"
+#include "level_file.h"
+#include "flow_field_system.h"
+#include "path_follower.h"
+#include "path_request_system.h"
+#include "behaviour_system.h"
+#include "ai_lod_system.h"
+#include "interaction_system.h"
+#include "random.h"
+#include "worker_pool.h"
+#include <algorithm>
+#include <thread>
 
 const int LevelWidth = 120;
 const int LevelHeight = 50;
@@ -25,14 +40,29 @@ const int RoomAttempts = 100;
 const int BotPopulationCount = 100;
 const float PredatorProbability = 0.2f;
 const int InitialFoodAmount = 100;
+// seconds until uneaten food spoils
+const float FoodLifetime = 60.f;
+// at most one food per this many room cells
+const float FoodPerRoomCell = 1.f / 20;
+const size_t PathNodeBudgetPerFrame = 5000;
+// path requests at least this far apart (manhattan) go through the hierarchical pathfinder
+const int HierarchicalPathDistance = 256;
+// NPC behaviours from the behaviour trees instead of the FSMs, the result is the same
+const bool UseBehaviourTrees = false;
+// NPCs farther than AiNearCells * SpatialIndex::CellSize cells from the camera and the hero update every AiFarPeriod ticks
+const int AiNearCells = 2;
+const uint32_t AiFarPeriod = 8;
+// starvation and tiredness are spread over this many frames instead of hitting one frame per second
+const int VitalsSlices = 4;
 
-std::vector<std::unique_ptr<IFoodFabrique>> create_food_fabriques(World &world, TileSet &tileset);
-
-void init_world( SDL_Renderer* renderer, World& world)
+void init_world( SDL_Renderer* renderer, World& world, const char* levelPath, uint64_t seed)
 {
+    // keys are sampled by the main thread, before the components that read them are created
+    world.add_service(std::make_shared<InputState>());
 
     auto camera = world.create_object();
     camera->add_component<Camera2D>(32.f);
+    camera->add_component<CameraZoom>();
     camera->add_component<Transform2D>(0, 0);
 
 
@@ -60,59 +90,99 @@ void init_world( SDL_Renderer* renderer, World& world)
         ));
     }
 
-    auto dungeon = std::make_shared<Dungeon>(LevelWidth, LevelHeight, RoomAttempts);
-    const auto &grid = dungeon->getGrid();
-    for (int i = 0; i < LevelHeight; ++i)
-        for (int j = 0; j < LevelWidth; ++j)
-        {
-            const char * spriteName = nullptr;
-            if (grid[i][j] == Dungeon::FLOOR) {
-                spriteName = rand() % 2 == 0 ? "floor1" : "floor2";
-            } else if (grid[i][j] == Dungeon::WALL) {
-                spriteName = "wall";
-            }
-            if (spriteName) {
-                auto newCell = world.create_object();
-                newCell->add_component<Sprite>(tileset.get_tile(spriteName));
-                newCell->add_component<Transform2D>(j, i);
-                newCell->add_component<BackGroundTag>();
-            }
-        }
+    std::shared_ptr<Dungeon> dungeon = levelPath ? load_level(levelPath) : nullptr;
+    if (!dungeon)
+        dungeon = std::make_shared<Dungeon>(LevelWidth, LevelHeight, RoomAttempts, uint32_t(seed ^ (seed >> 32)));
+    // tiles are drawn from the dungeon itself, only the part in view
+    auto tiles = world.add_service(std::make_shared<DungeonTiles>());
+    tiles->dungeon = dungeon;
+    tiles->floor[0] = tileset.get_tile("floor1");
+    tiles->floor[1] = tileset.get_tile("floor2");
+    tiles->wall = tileset.get_tile("wall");
+    // the static layer is drawn once into chunk textures and redrawn only on map edits or zoom changes
+    world.add_service(std::make_shared<BackgroundCache>(tiles, ChunkTextures::is_supported(renderer)));
+    // zoomed far out the whole map is drawn from a downsampled overview instead
+    world.add_service(std::make_shared<DungeonOverview>(tiles));
+
+    auto random = world.add_service(std::make_shared<Random>(seed));
+    auto randomFloor = [&](GameObjectPtr obj) {
+        return dungeon->getFloorPosition(random->get_int(uint32_t(dungeon->getFloorCount()), obj->get_id(),
+                                                         world.get_tick(), SpawnPosition));
+    };
+    auto grid = world.add_service(std::make_shared<WalkabilityGrid>(dungeon));
+    // threads for the parallel parts of a tick, created once
+    auto workers = world.add_service(std::make_shared<WorkerPool>());
+    auto flowFields = world.add_service(std::make_shared<FlowFields>(dungeon, workers));
+    auto food = world.add_service(std::make_shared<FoodStorage>(flowFields));
+    add_food_kinds(*food, *world.add_service(std::make_shared<FoodSprites>()), tileset);
+    auto danger = world.add_service(std::make_shared<InfluenceMap>(dungeon, workers));
+    // one core is left for the simulation thread, without spare cores paths are found inside update()
+    const int pathWorkers = std::clamp(int(std::thread::hardware_concurrency()) - 1, 0, 4);
+    auto pathRequests = world.add_service(std::make_shared<PathRequestService>(
+        dungeon, pathWorkers, PathNodeBudgetPerFrame, 256, HierarchicalPathDistance));
+    auto aiLod = world.add_service(std::make_shared<AiLod>(AiNearCells, AiFarPeriod));
+    // food spawning, spoilage and vitals run on timers fired at the start of every tick
+    auto timers = world.add_service(std::make_shared<TimerWheel>());
+    world.create_object()->add_component<TimerSystem>(timers);
 
-    auto heroPos = dungeon->getRandomFloorPosition();
     auto hero = world.create_object();
+    auto heroPos = randomFloor(hero);
     hero->add_component<Sprite>(tileset.get_tile("knight"));
     hero->add_component<Transform2D>(heroPos.x, heroPos.y);
     hero->add_component<Hero>(camera);
-    hero->add_component<IRestrictor>((IRestrictor *)(new DungeonRestrictor(dungeon)));
     hero->add_component<Health>(100);
     hero->add_component<Stamina>(100);
     hero->add_component<FoodConsumer>();
 
+    // updated before the AI systems so they see this tick's camera and hero
+    auto aiLodSystem = world.create_object()->add_component<AiLodSystem>(aiLod);
+    aiLodSystem->add_watcher(camera);
+    aiLodSystem->add_watcher(hero);
+
+    BehaviourProgram herbivoreProgram, predatorProgram;
+    const bool compiled = UseBehaviourTrees
+        ? compile_behaviour_tree(make_herbivore_tree(), herbivoreProgram) && compile_behaviour_tree(make_predator_tree(), predatorProgram)
+        : compile_fsm(make_herbivore_fsm(), herbivoreProgram) && compile_fsm(make_predator_fsm(), predatorProgram);
+    if (!compiled)
+    {
+        std::cerr << "Failed to compile NPC behaviours\n";
+        return;
+    }
+    auto herbivoreBehaviour = world.create_object()->add_component<BehaviourSystem>(std::move(herbivoreProgram));
+    auto predatorBehaviour = world.create_object()->add_component<BehaviourSystem>(std::move(predatorProgram));
+
     for (int e = 0; e < BotPopulationCount; ++e) {
-        const bool isPredator = (rand() % 100) < int(PredatorProbability * 100.f);
-        auto enemyPos = dungeon->getRandomFloorPosition();
         auto enemy = world.create_object();
+        const bool isPredator = random->get_float(enemy->get_id(), world.get_tick(), SpawnKind) < PredatorProbability;
+        auto enemyPos = randomFloor(enemy);
         enemy->add_component<Sprite>(isPredator ? tileset.get_tile("ghost") : tileset.get_tile("peasant"));
         enemy->add_component<Transform2D>(enemyPos.x, enemyPos.y);
-        enemy->add_component<Enemy>();
-        enemy->add_component<IRestrictor>((IRestrictor *)(new DungeonRestrictor(dungeon)));
         enemy->add_component<Health>(100);
         enemy->add_component<Stamina>(100);
-        if (isPredator)
-             enemy->add_component<Predator>();
-        else
+        if (isPredator) {
+            enemy->add_component<Predator>();
+            predatorBehaviour->add(enemy);
+        } else {
+            enemy->add_component<PathFollower>();
             enemy->add_component<FoodConsumer>();
+            herbivoreBehaviour->add(enemy);
+        }
     }
 
-    auto foodFabriques = create_food_fabriques(world, tileset);
-
     auto foodGenerator = world.create_object();
-    auto generatorComp = foodGenerator->add_component<FoodGenerator>(dungeon, std::move(foodFabriques), 2.f / RoomAttempts);
+    auto generatorComp = foodGenerator->add_component<FoodGenerator>(dungeon, food, 2.f / RoomAttempts, FoodLifetime, FoodPerRoomCell);
     for (int i = 0; i < InitialFoodAmount; i++)
         generatorComp->generate_random_food();
-    auto starvation = world.create_object();
-    starvation->add_component<StarvationSystem>();
-    auto tiredness = world.create_object();
-    tiredness->add_component<TirednessSystem>();
+    // after the hero and the NPCs have moved
+    auto interactions = world.create_object();
+    interactions->add_component<InteractionSystem>();
+    auto vitals = world.create_object();
+    vitals->add_component<VitalsSystem>(VitalsSlices);
+    auto flowFieldSystem = world.create_object();
+    flowFieldSystem->add_component<FlowFieldSystem>(flowFields, danger);
+    auto pathRequestSystem = world.create_object();
+    pathRequestSystem->add_component<PathRequestSystem>(pathRequests);
+    // last, so build_render_frame sees where everything ended up this tick
+    auto scene = world.add_service(std::make_shared<SceneIndex>(dungeon->getWidth(), dungeon->getHeight()));
+    world.create_object()->add_component<SceneIndexSystem>(scene);
 }
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Клавиши, которые читает симуляция
+enum class InputKey : uint32_t {
+    Up,
+    Down,
+    Left,
+    Right,
+    ZoomIn,
+    ZoomOut,
+};
+
+// Состояние клавиатуры для потока симуляции, сервис мира. SDL_GetKeyboardState можно
+// читать только в главном потоке, где SDL_PollEvent его меняет, поэтому главный поток
+// после опроса событий кладёт сюда снимок нужных клавиш, а симуляция читает его
+// (как размер окна в RenderFrames)
+class InputState {
+public:
+    void set_pressed(uint32_t mask) { pressed.store(mask, std::memory_order_relaxed); }
+    bool is_pressed(InputKey key) const {
+        return (pressed.load(std::memory_order_relaxed) >> uint32_t(key)) & 1;
+    }
+
+    static constexpr uint32_t bit(InputKey key) { return 1u << uint32_t(key); }
+
+private:
+    std::atomic<uint32_t> pressed = 0;
+};
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "component.h"
+#include "game_object.h"
+#include "world.h"
+#include "food_storage.h"
+#include "food_consumer.h"
+#include "health.h"
+#include "interactions.h"
+#include "predator.h"
+#include "random.h"
+#include "transform2d.h"
+#include "vital_component.h"
+#include "worker_pool.h"
+#include <algorithm>
+
+// Who eats whom, once per tick after everybody has moved: predators eat food consumers
+// in their cell, then the consumers that survived eat food. Pairs are gathered and
+// conflicts resolved by InteractionResolver, effects are applied in one batch afterwards,
+// so the outcome does not depend on the order objects are updated in.
+// Gathering and resolving run on the WorkerPool service when there is one
+class InteractionSystem : public Component {
+    static constexpr size_t MinObjectsPerThread = 4096;
+
+    // one slice of the world's objects, scanned by one thread
+    struct GatherSlice {
+        std::vector<GameObjectPtr> predators, consumers;
+        std::vector<InteractionActor> predatorActors, consumerActors;
+    };
+
+    InteractionResolver resolver;
+    std::shared_ptr<WorkerPool> pool;
+    std::shared_ptr<Random> random;
+    std::shared_ptr<FoodStorage> food;
+    std::shared_ptr<Vitals> vitals;
+
+    std::vector<GameObjectPtr> predators, consumers;
+    std::vector<InteractionActor> predatorActors, consumerActors, foodActors, survivorActors;
+    std::vector<uint32_t> survivors; // consumer index of every survivorActors entry
+    std::vector<Interaction> hunts, meals;
+    std::vector<uint8_t> eaten;
+    std::vector<uint32_t> mealFoods, mealRows;
+    std::vector<GatherSlice> slices;
+
+    InteractionActor make_actor(const GameObjectPtr &obj, const Transform2D &transform, uint32_t tick) const {
+        const uint32_t id = obj->get_id();
+        // a fresh random priority every tick, so no one always wins a shared cell
+        const uint32_t priority = random ? random->get_uint(id, tick, InteractionPriority) : id;
+        return InteractionActor{ int2((int)transform.x, (int)transform.y), id, priority };
+    }
+
+    // component lookups only read the objects, so slices of the object list are scanned in parallel
+    // and joined in slice order, which keeps the lists in world order
+    void gather(uint32_t tick) {
+        const auto &objects = get_owner()->get_world()->get_objects();
+        const int threads = int(std::clamp<size_t>(pool ? pool->get_thread_count() : 1, 1,
+                                                   std::max<size_t>(1, objects.size() / MinObjectsPerThread)));
+        slices.resize(threads);
+        auto scan = [&](int t) {
+            GatherSlice &slice = slices[t];
+            slice.predators.clear(); slice.consumers.clear();
+            slice.predatorActors.clear(); slice.consumerActors.clear();
+            const size_t end = objects.size() * (t + 1) / threads;
+            for (size_t i = objects.size() * t / threads; i < end; i++) {
+                const GameObjectPtr &obj = objects[i];
+                auto transform = obj->get_component<Transform2D>();
+                if (!transform)
+                    continue;
+                if (obj->get_component<Predator>()) {
+                    slice.predators.push_back(obj);
+                    slice.predatorActors.push_back(make_actor(obj, *transform, tick));
+                }
+                if (obj->get_component<FoodConsumer>()) {
+                    slice.consumers.push_back(obj);
+                    slice.consumerActors.push_back(make_actor(obj, *transform, tick));
+                }
+            }
+        };
+        if (threads == 1)
+            scan(0);
+        else
+            pool->run(threads, scan);
+        predators.clear(); consumers.clear();
+        predatorActors.clear(); consumerActors.clear(); foodActors.clear();
+        for (const GatherSlice &slice : slices) {
+            predators.insert(predators.end(), slice.predators.begin(), slice.predators.end());
+            consumers.insert(consumers.end(), slice.consumers.begin(), slice.consumers.end());
+            predatorActors.insert(predatorActors.end(), slice.predatorActors.begin(), slice.predatorActors.end());
+            consumerActors.insert(consumerActors.end(), slice.consumerActors.begin(), slice.consumerActors.end());
+        }
+        // food is not a world object, its slot stands in for the id; targets are taken
+        // in id order and never by priority, so food gets none
+        if (food) {
+            for (size_t i = 0; i < food->size(); i++)
+                foodActors.push_back(InteractionActor{ food->cells[i], food->slotOf[i], 0 });
+        }
+    }
+
+public:
+    void on_create() override {
+        pool = get_owner()->get_world()->get_service<WorkerPool>();
+        resolver = InteractionResolver(pool);
+        random = get_owner()->get_world()->get_service<Random>();
+        food = get_owner()->get_world()->get_service<FoodStorage>();
+        vitals = get_vitals(*get_owner()->get_world());
+    }
+
+    void on_update(float dt) override {
+        World *world = get_owner()->get_world();
+        gather(world->get_tick());
+
+        // a predator heals by the victim's health
+        resolver.resolve(predatorActors, consumerActors, hunts);
+        eaten.assign(consumers.size(), 0);
+        for (const Interaction &hunt : hunts) {
+            auto predatorHp = predators[hunt.actor]->get_component<Health>();
+            auto victimHp = consumers[hunt.target]->get_component<Health>();
+            if (!predatorHp || !victimHp)
+                continue;
+            predatorHp->change(victimHp->get());
+            world->destroy_object(consumers[hunt.target]);
+            eaten[hunt.target] = 1;
+        }
+
+        survivorActors.clear();
+        survivors.clear();
+        for (uint32_t i = 0; i < consumers.size(); i++) {
+            if (eaten[i])
+                continue;
+            survivorActors.push_back(consumerActors[i]);
+            survivors.push_back(i);
+        }
+        if (!food)
+            return;
+        resolver.resolve(survivorActors, foodActors, meals);
+        mealFoods.clear();
+        mealRows.clear();
+        for (const Interaction &meal : meals) {
+            mealFoods.push_back(meal.target);
+            mealRows.push_back(vitals->find(consumers[survivors[meal.actor]]->get_id()));
+        }
+        food->consume(mealFoods, mealRows, *vitals);
+    }
+};
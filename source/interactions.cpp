@@ -0,0 +1,108 @@
+#include "interactions.h"
+
+#include "frame_arena.h"
+
+#include <algorithm>
+
+static constexpr size_t MinActorsPerThread = 16384;
+
+// клетка в старших 32 битах ключа; координаты карты помещаются в 16 бит
+static uint64_t cell_key(int2 cell)
+{
+    return (uint64_t(uint16_t(cell.y)) << 48) | (uint64_t(uint16_t(cell.x)) << 32);
+}
+
+void InteractionResolver::resolve(std::span<const InteractionActor> actors, std::span<const InteractionActor> targets,
+                                  std::vector<Interaction> &result)
+{
+    result.clear();
+    if (actors.empty() || targets.empty())
+        return;
+
+    actorsByCell.resize(actors.size());
+    for (uint32_t a = 0; a < actors.size(); a++)
+        actorsByCell[a] = { cell_key(actors[a].cell) | actors[a].priority, actors[a].id, a };
+    targetsByCell.resize(targets.size());
+    for (uint32_t t = 0; t < targets.size(); t++)
+        targetsByCell[t] = { cell_key(targets[t].cell), targets[t].id, t };
+    sort_entries(actorsByCell, true);
+    sort_entries(targetsByCell, false);
+
+    // клетки независимы: куски актёров по границам клеток сливаются с целями в разных потоках
+    const int threads = int(std::clamp<size_t>(pool ? pool->get_thread_count() : 1, 1,
+                                               std::max<size_t>(1, actors.size() / MinActorsPerThread)));
+    if (threads == 1) {
+        match(0, actorsByCell.size(), result);
+        return;
+    }
+    FrameVector<size_t> bounds(threads + 1, actorsByCell.size());
+    bounds[0] = 0;
+    for (int t = 1; t < threads; t++) {
+        size_t b = std::max(actorsByCell.size() * t / threads, bounds[t - 1]);
+        const uint64_t cell = actorsByCell[b].key >> 32;
+        while (b > bounds[t - 1] && actorsByCell[b - 1].key >> 32 == cell)
+            b--;
+        bounds[t] = b;
+    }
+    chunkResults.resize(threads);
+    pool->run(threads, [&](int t) { match(bounds[t], bounds[t + 1], chunkResults[t]); });
+    for (const auto &chunk : chunkResults)
+        result.insert(result.end(), chunk.begin(), chunk.end());
+}
+
+void InteractionResolver::sort_entries(std::vector<SortEntry> &entries, bool sortKeyLow)
+{
+    if (entries.size() < 1024) {
+        std::sort(entries.begin(), entries.end());
+        return;
+    }
+    // поразрядная сортировка по 16 бит, от младших к старшим: id, затем ключ.
+    // У целей младшая половина ключа нулевая, её проходы пропускаются
+    sortScratch.resize(entries.size());
+    auto pass = [&](auto digit) {
+        FrameVector<uint32_t> offsets(65537, 0);
+        for (const SortEntry &entry : entries)
+            offsets[digit(entry) + 1]++;
+        for (size_t d = 1; d < offsets.size(); d++)
+            offsets[d] += offsets[d - 1];
+        for (const SortEntry &entry : entries)
+            sortScratch[offsets[digit(entry)]++] = entry;
+        entries.swap(sortScratch);
+    };
+    pass([](const SortEntry &e) { return e.id & 0xFFFF; });
+    pass([](const SortEntry &e) { return e.id >> 16; });
+    if (sortKeyLow) {
+        pass([](const SortEntry &e) { return uint32_t(e.key) & 0xFFFF; });
+        pass([](const SortEntry &e) { return uint32_t(e.key) >> 16; });
+    }
+    pass([](const SortEntry &e) { return uint32_t(e.key >> 32) & 0xFFFF; });
+    pass([](const SortEntry &e) { return uint32_t(e.key >> 48); });
+}
+
+void InteractionResolver::match(size_t actorBegin, size_t actorEnd, std::vector<Interaction> &result) const
+{
+    result.clear();
+    if (actorBegin == actorEnd)
+        return;
+    auto target = std::lower_bound(targetsByCell.begin(), targetsByCell.end(), actorsByCell[actorBegin].key >> 32,
+                                   [](const SortEntry &entry, uint64_t cell) { return (entry.key >> 32) < cell; });
+    size_t a = actorBegin;
+    while (a < actorEnd && target != targetsByCell.end()) {
+        const uint64_t actorCell = actorsByCell[a].key >> 32;
+        const uint64_t targetCell = target->key >> 32;
+        if (actorCell < targetCell) {
+            a++;
+        } else if (targetCell < actorCell) {
+            ++target;
+        } else {
+            // k-й по приоритету актёр клетки получает k-ю по id цель
+            result.push_back({ actorsByCell[a].index, target->index });
+            a++;
+            ++target;
+            if (a < actorEnd && actorsByCell[a].key >> 32 != actorCell) {
+                while (target != targetsByCell.end() && target->key >> 32 == actorCell)
+                    ++target;
+            }
+        }
+    }
+}
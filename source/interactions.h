@@ -0,0 +1,51 @@
+#pragma once
+
+#include "math2d.h"
+#include "worker_pool.h"
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+// Участник взаимодействия: хищник или жертва, едок или еда
+struct InteractionActor {
+    int2 cell;
+    uint32_t id;       // GameObject::get_id(), разбивает ничьи
+    uint32_t priority; // кто раньше выбирает цель: меньше - раньше
+};
+
+// Номера в массивах actors и targets, переданных в resolve()
+struct Interaction {
+    uint32_t actor, target;
+};
+
+// Взаимодействия в одной клетке за один тик, без зависимости от порядка обновления объектов.
+// Актёры и цели сортируются по клетке, затем клетки обходятся слиянием (параллельно по кускам):
+// в клетке актёры по возрастанию (priority, id) забирают цели по возрастанию id,
+// так что каждый актёр берёт не больше одной цели и каждая цель достаётся одному актёру.
+// Результат одинаков при любом порядке входных массивов и любом числе потоков.
+// Куски сливаются на потоках pool; без него - на вызывающем потоке
+class InteractionResolver {
+public:
+    explicit InteractionResolver(std::shared_ptr<WorkerPool> pool = nullptr)
+        : pool(std::move(pool)) {}
+
+    void resolve(std::span<const InteractionActor> actors, std::span<const InteractionActor> targets,
+                 std::vector<Interaction> &result);
+
+private:
+    struct SortEntry {
+        uint64_t key; // клетка в старших битах
+        uint32_t id;
+        uint32_t index;
+        bool operator<(const SortEntry &other) const {
+            return key != other.key ? key < other.key : id < other.id;
+        }
+    };
+    std::shared_ptr<WorkerPool> pool;
+    std::vector<SortEntry> actorsByCell, targetsByCell, sortScratch;
+    std::vector<std::vector<Interaction>> chunkResults;
+
+    void sort_entries(std::vector<SortEntry> &entries, bool sortKeyLow);
+    void match(size_t actorBegin, size_t actorEnd, std::vector<Interaction> &result) const;
+};
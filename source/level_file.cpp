@@ -0,0 +1,213 @@
+#include "level_file.h"
+#include "dungeon_generator.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(Room) == 4 * sizeof(int32_t), "Room is written to the level file as is");
+
+static uint64_t align_section(uint64_t offset)
+{
+    return (offset + 63) & ~uint64_t(63);
+}
+
+namespace {
+
+class MappedFile {
+public:
+    ~MappedFile()
+    {
+#ifdef _WIN32
+        if (view)
+            UnmapViewOfFile(view);
+        if (mapping)
+            CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE)
+            CloseHandle(file);
+#else
+        if (view)
+            munmap(view, size);
+        if (fd >= 0)
+            close(fd);
+#endif
+    }
+
+    bool open(const char *path)
+    {
+#ifdef _WIN32
+        file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+            return false;
+        size = size_t(fileSize.QuadPart);
+        mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+        if (!mapping)
+            return false;
+        view = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+        return view != nullptr;
+#else
+        fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0)
+            return false;
+        size = size_t(st.st_size);
+        void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (ptr == MAP_FAILED)
+            return false;
+        view = ptr;
+        return true;
+#endif
+    }
+
+    uint8_t *data() const { return static_cast<uint8_t *>(view); }
+    size_t get_size() const { return size; }
+
+private:
+    void *view = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+};
+
+} // namespace
+
+// То, на что полагается остальной код: биты за width равны нулю (getFloorPosition, обход по словам),
+// варианты - номера спрайтов floor[], комнаты лежат внутри карты (FoodSpawner, HPA)
+static bool validate_level_data(const LevelFileHeader &header, const uint64_t *walkable, const uint8_t *variants, const Room *rooms)
+{
+    const int width = header.width, height = header.height;
+    const uint64_t lastWordMask = width % 64 ? (uint64_t(1) << (width % 64)) - 1 : ~uint64_t(0);
+    for (int y = 0; y < height; y++) {
+        const uint64_t *row = walkable + size_t(y) * header.wordsPerRow;
+        if (row[header.wordsPerRow - 1] & ~lastWordMask)
+            return false;
+    }
+    // один проход по всем клеткам сразу, он векторизуется
+    uint8_t maxVariant = 0;
+    for (size_t i = 0, n = size_t(width) * height; i < n; i++)
+        maxVariant = std::max(maxVariant, variants[i]);
+    if (maxVariant >= Dungeon::FloorVariants)
+        return false;
+    for (uint32_t i = 0; i < header.roomCount; i++) {
+        const Room &room = rooms[i];
+        if (room.x < 0 || room.y < 0 || room.w <= 0 || room.h <= 0 ||
+            int64_t(room.x) + room.w > width || int64_t(room.y) + room.h > height)
+            return false;
+    }
+    return true;
+}
+
+bool save_level(const Dungeon &dungeon, const char *path)
+{
+    const auto &rooms = dungeon.getRooms();
+    LevelFileHeader header{};
+    std::memcpy(header.magic, LevelFileMagic, sizeof(header.magic));
+    header.version = LevelFileVersion;
+    header.width = dungeon.getWidth();
+    header.height = dungeon.getHeight();
+    header.wordsPerRow = dungeon.getWordsPerRow();
+    header.roomCount = uint32_t(rooms.size());
+
+    const uint64_t walkableSize = uint64_t(header.wordsPerRow) * header.height * sizeof(uint64_t);
+    const uint64_t variantsSize = uint64_t(header.width) * header.height;
+    header.walkableOffset = align_section(sizeof(LevelFileHeader));
+    header.variantsOffset = align_section(header.walkableOffset + walkableSize);
+    header.roomsOffset = align_section(header.variantsOffset + variantsSize);
+    header.fileSize = header.roomsOffset + rooms.size() * sizeof(Room);
+
+    FILE *file = std::fopen(path, "wb");
+    if (!file) {
+        std::cerr << "Failed to open level file for writing: " << path << std::endl;
+        return false;
+    }
+    uint64_t written = 0;
+    auto write = [&](const void *data, uint64_t offset, uint64_t size) {
+        static const uint8_t zeros[64] = {};
+        while (written < offset)
+            written += std::fwrite(zeros, 1, size_t(std::min<uint64_t>(offset - written, sizeof(zeros))), file);
+        written += std::fwrite(data, 1, size_t(size), file);
+    };
+    write(&header, 0, sizeof(header));
+    write(dungeon.getWalkableBits(), header.walkableOffset, walkableSize);
+    write(dungeon.getVariants(), header.variantsOffset, variantsSize);
+    write(rooms.data(), header.roomsOffset, rooms.size() * sizeof(Room));
+    const bool ok = std::fclose(file) == 0 && written == header.fileSize;
+    if (!ok)
+        std::cerr << "Failed to write level file: " << path << std::endl;
+    return ok;
+}
+
+std::shared_ptr<Dungeon> load_level(const char *path)
+{
+    auto file = std::make_shared<MappedFile>();
+    if (!file->open(path)) {
+        std::cerr << "Failed to map level file: " << path << std::endl;
+        return nullptr;
+    }
+    const size_t size = file->get_size();
+    uint8_t *data = file->data();
+    if (size < sizeof(LevelFileHeader)) {
+        std::cerr << "Level file is truncated: " << path << std::endl;
+        return nullptr;
+    }
+    const LevelFileHeader &header = *reinterpret_cast<const LevelFileHeader *>(data);
+    if (std::memcmp(header.magic, LevelFileMagic, sizeof(header.magic)) != 0 || header.version != LevelFileVersion) {
+        std::cerr << "Unsupported level file: " << path << std::endl;
+        return nullptr;
+    }
+    // Секции внутри файла; offset + sectionSize может переполниться, поэтому вычитаем
+    auto fits = [&](uint64_t offset, uint64_t sectionSize) {
+        return offset <= size && sectionSize <= size - offset;
+    };
+    // размеры ограничены, чтобы произведения ниже и индексы Dungeon (int) не переполнялись
+    const bool validSize = header.width > 0 && header.height > 0 &&
+                           header.width <= LevelMaxSide && header.height <= LevelMaxSide &&
+                           header.wordsPerRow == uint32_t((header.width + 63) / 64);
+    const uint64_t walkableSize = uint64_t(header.wordsPerRow) * uint64_t(header.height) * sizeof(uint64_t);
+    const uint64_t variantsSize = uint64_t(header.width) * uint64_t(header.height);
+    const bool valid = validSize &&
+                       header.fileSize == size &&
+                       header.walkableOffset % alignof(uint64_t) == 0 &&
+                       fits(header.walkableOffset, walkableSize) &&
+                       fits(header.variantsOffset, variantsSize) &&
+                       header.roomsOffset % alignof(Room) == 0 &&
+                       fits(header.roomsOffset, uint64_t(header.roomCount) * sizeof(Room));
+    if (!valid) {
+        std::cerr << "Corrupted level file: " << path << std::endl;
+        return nullptr;
+    }
+    const uint64_t *walkable = reinterpret_cast<const uint64_t *>(data + header.walkableOffset);
+    const uint8_t *variants = data + header.variantsOffset;
+    const Room *rooms = reinterpret_cast<const Room *>(data + header.roomsOffset);
+    if (!validate_level_data(header, walkable, variants, rooms)) {
+        std::cerr << "Corrupted level file: " << path << std::endl;
+        return nullptr;
+    }
+    return std::make_shared<Dungeon>(
+        header.width, header.height,
+        reinterpret_cast<uint64_t *>(data + header.walkableOffset),
+        data + header.variantsOffset,
+        std::vector<Room>(rooms, rooms + header.roomCount),
+        std::move(file));
+}
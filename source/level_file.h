@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+class Dungeon;
+
+// Бинарный формат уровня (.lvl):
+//   LevelFileHeader
+//   uint64_t walkable[height * wordsPerRow] - та же битовая маска, что и в Dungeon
+//   uint8_t  variants[width * height]       - вариант спрайта для каждой клетки
+//   Room     rooms[roomCount]
+// Все секции выровнены на 64 байта, поэтому после mmap данные используются на месте, без разбора.
+// Порядок байт - little-endian (x86/ARM)
+struct LevelFileHeader {
+    char magic[4];
+    uint32_t version;
+    int32_t width;
+    int32_t height;
+    uint32_t wordsPerRow;
+    uint32_t roomCount;
+    uint64_t walkableOffset;
+    uint64_t variantsOffset;
+    uint64_t roomsOffset;
+    uint64_t fileSize;
+};
+
+constexpr char LevelFileMagic[4] = {'A', 'P', 'L', 'V'};
+constexpr uint32_t LevelFileVersion = 1;
+// Больше сторона карты не бывает, файлы с такими размерами отвергаются
+constexpr int32_t LevelMaxSide = 1 << 15;
+
+bool save_level(const Dungeon &dungeon, const char *path);
+
+// Отображает файл в память (copy-on-write, так что уровень можно редактировать, не трогая файл).
+// Повреждённый или несогласованный файл (секции за концом, мусор в битах за width, варианты
+// не меньше Dungeon::FloorVariants, комнаты за картой) - nullptr
+std::shared_ptr<Dungeon> load_level(const char *path);
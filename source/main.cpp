@@ -6,10 +6,42 @@
 #include <stacktrace>
 #include <optional>
 #include <thread>
+#include <cstring>
+#include <random>
 #include "network.h"
-
-void init_world(SDL_Renderer* renderer, World& world);
-void render_world(SDL_Window* window, SDL_Renderer* renderer, World& world);
+#include "render_frame.h"
+#include "frame_arena.h"
+#include "input_state.h"
+#include <atomic>
+
+void init_world(SDL_Renderer* renderer, World& world, const char* levelPath, uint64_t seed);
+void build_render_frame(World& world, int screenW, int screenH, RenderFrame& frame);
+void draw_render_frame(SDL_Renderer* renderer, const RenderFrame& frame, ChunkTextures& chunkTextures,
+                       OverviewTextures& overviewTextures, SpriteBatch& batch);
+
+// Frees this thread's per-frame scratch memory; the peaks go to the profiler
+static void reset_frame_arena()
+{
+    OPTICK_EVENT("frameArena.reset");
+    FrameArena& arena = FrameArena::get();
+    OPTICK_TAG("framePeakBytes", uint64_t(arena.get_frame_peak()));
+    OPTICK_TAG("highWaterBytes", uint64_t(arena.get_high_water()));
+    arena.reset();
+}
+
+// SDL_GetKeyboardState belongs to the thread that polls events; the simulation gets a copy of the keys it needs
+static uint32_t sample_keys()
+{
+    const bool* keys = SDL_GetKeyboardState(nullptr);
+    uint32_t mask = 0;
+    if (keys[SDL_SCANCODE_W]) mask |= InputState::bit(InputKey::Up);
+    if (keys[SDL_SCANCODE_S]) mask |= InputState::bit(InputKey::Down);
+    if (keys[SDL_SCANCODE_A]) mask |= InputState::bit(InputKey::Left);
+    if (keys[SDL_SCANCODE_D]) mask |= InputState::bit(InputKey::Right);
+    if (keys[SDL_SCANCODE_EQUALS]) mask |= InputState::bit(InputKey::ZoomIn);
+    if (keys[SDL_SCANCODE_MINUS]) mask |= InputState::bit(InputKey::ZoomOut);
+    return mask;
+}
 
 int main(int argc, char* argv[])
 {
@@ -43,8 +75,16 @@ int main(int argc, char* argv[])
     PlayerId playerId = PlayerId::Invalid;
     PlayerId teammateId = PlayerId::Invalid;
     int userID = -1;
+    const char* levelPath = nullptr;
+    unsigned long long seed = std::random_device{}();
     for (int i = 1; i < argc; i++) {
         int value;
+        if (sscanf(argv[i], "--seed=%llu", &seed) == 1)
+            std::cout << "--seed=" << seed << std::endl;
+        if (strncmp(argv[i], "--level=", 8) == 0) {
+            levelPath = argv[i] + 8;
+            std::cout << "--level=" << levelPath << std::endl;
+        }
         if (sscanf(argv[i], "--player_id=%d", &value) == 1) {
             std::cout << "--player_id=" << value << std::endl;
             if (value == 1)
@@ -110,40 +150,78 @@ int main(int argc, char* argv[])
 
         {
             OPTICK_EVENT("world.init");
-            init_world(renderer, *world);
+            init_world(renderer, *world, levelPath, seed);
         }
 
-        bool quit = false;
-        SDL_Event e;
-        Uint64 lastTicks = SDL_GetTicks();
-
-        while (!quit) {
-
-	        OPTICK_FRAME("MainThread");
-            while (SDL_PollEvent(&e)) {
-                if (e.type == SDL_EVENT_QUIT) {
-                    quit = true;
+        // The simulation runs on its own thread and hands finished frames over through RenderFrames.
+        // SDL wants events and rendering on the main thread, so this one owns the renderer:
+        // presenting frame N and its vsync wait overlap with simulating frame N+1
+        RenderFrames frames;
+        std::atomic<bool> quit = false;
+        int screenW, screenH;
+        SDL_GetWindowSize(window, &screenW, &screenH);
+        frames.set_screen_size(screenW, screenH);
+        auto input = world->get_service<InputState>();
+
+        std::thread simulation([&]() {
+            OPTICK_THREAD("Simulation");
+            Uint64 lastTicks = SDL_GetTicks();
+            while (!quit) {
+                Uint64 now = SDL_GetTicks();
+                float deltaTime = (now - lastTicks) / 1000.0f;
+                lastTicks = now;
+                {
+                    OPTICK_EVENT("world.update");
+                    world->update(deltaTime);
                 }
+                {
+                    OPTICK_EVENT("world.render");
+                    build_render_frame(*world, frames.get_screen_width(), frames.get_screen_height(), frames.get_writing());
+                }
+                frames.publish();
+                reset_frame_arena();
             }
-            Uint64 now = SDL_GetTicks();
-            float deltaTime = (now - lastTicks) / 1000.0f;
-            lastTicks = now;
-            {
-                OPTICK_EVENT("world.update");
-                world->update(deltaTime);
-            }
+        });
 
-            // Теперь сразу цвет внутри Clear
-            SDL_SetRenderDrawColor(renderer, 50, 50, 150, 255);
-            SDL_RenderClear(renderer);
-            {
-                OPTICK_EVENT("world.render");
-                // Отрисовка всех игровых объектов
-                render_world(window, renderer, *world);
-            }
+        {
+            // render-side state, released before the renderer
+            ChunkTextures chunkTextures;
+            OverviewTextures overviewTextures;
+            SpriteBatch batch;
+            SDL_Event e;
+            while (!quit) {
+
+                OPTICK_FRAME("MainThread");
+                while (SDL_PollEvent(&e)) {
+                    if (e.type == SDL_EVENT_QUIT) {
+                        quit = true;
+                    }
+                }
+                SDL_GetWindowSize(window, &screenW, &screenH);
+                frames.set_screen_size(screenW, screenH);
+                if (input)
+                    input->set_pressed(sample_keys());
+
+                // wait a little for the simulation, but keep polling events
+                const RenderFrame* frame = frames.acquire(std::chrono::milliseconds(10));
+                if (!frame)
+                    continue;
+
+                // Теперь сразу цвет внутри Clear
+                SDL_SetRenderDrawColor(renderer, 50, 50, 150, 255);
+                SDL_RenderClear(renderer);
+                {
+                    OPTICK_EVENT("frame.draw");
+                    // Отрисовка всех игровых объектов
+                    draw_render_frame(renderer, *frame, chunkTextures, overviewTextures, batch);
+                }
 
-            SDL_RenderPresent(renderer);
+                SDL_RenderPresent(renderer);
+                reset_frame_arena();
+            }
         }
+        frames.stop();
+        simulation.join();
     }
     network.reset();
 
@@ -2,10 +2,10 @@
 
 struct int2 {
     int x, y;
-    int2(int x=0, int y=0) : x(x), y(y) {}
+    constexpr int2(int x=0, int y=0) : x(x), y(y) {}
 };
 
 struct float2 {
     float x, y;
-    float2(float x=0, float y=0) : x(x), y(y) {}
+    constexpr float2(float x=0, float y=0) : x(x), y(y) {}
 };
\ No newline at end of file
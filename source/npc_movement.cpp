@@ -0,0 +1,171 @@
+#include "npc_movement.h"
+
+#include "simd.h"
+#include <algorithm>
+#include <cstring>
+
+template <typename T>
+static void reorder_values(std::vector<T> &values, std::span<const uint32_t> from)
+{
+    std::vector<T> sorted(from.size());
+    for (size_t k = 0; k < from.size(); k++)
+        sorted[k] = values[from[k]];
+    values.swap(sorted);
+}
+
+void NpcMovementArrays::reorder(std::span<const uint32_t> from)
+{
+    reorder_values(x, from);
+    reorder_values(y, from);
+    reorder_values(speed, from);
+    reorder_values(accumulator, from);
+    reorder_values(rng, from);
+    reorder_values(step, from);
+}
+
+static uint32_t xorshift32(uint32_t s)
+{
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    return s;
+}
+
+// Агенты [from, end): то же, что и векторный путь, по одному
+static void move_range(NpcMovementArrays &npcs, const WalkabilityGrid &grid, float dt, size_t begin, size_t from,
+                       size_t end, std::span<uint64_t> moved)
+{
+    for (size_t i = from; i < end; i++) {
+        float accumulator = npcs.accumulator[i] + dt * npcs.speed[i];
+        if (accumulator < 1.f) {
+            npcs.accumulator[i] = accumulator;
+            continue;
+        }
+        npcs.accumulator[i] = accumulator - 1.f;
+        uint32_t direction = uint32_t(npcs.step[i]);
+        // ГПСЧ продвигается только у тех, кто шагает наугад; старшие два бита - направление
+        if (npcs.step[i] == NpcStep::Random)
+            direction = (npcs.rng[i] = xorshift32(npcs.rng[i])) >> 30;
+        if (direction == uint32_t(NpcStep::None))
+            continue;
+        const int32_t dx = int32_t(direction == 0) - int32_t(direction == 1);
+        const int32_t dy = int32_t(direction == 2) - int32_t(direction == 3);
+        const int2 next{npcs.x[i] + dx, npcs.y[i] + dy};
+        if (grid.can_pass(next)) {
+            npcs.x[i] = next.x;
+            npcs.y[i] = next.y;
+            moved[(i - begin) >> 6] |= uint64_t(1) << ((i - begin) & 63);
+        }
+    }
+}
+
+#if defined(SIMD_X86)
+// Агенты с begin по 8; возвращает первого непосчитанного
+SIMD_AVX2 static size_t move_npcs_avx2(NpcMovementArrays &npcs, const WalkabilityGrid &grid, float dt, size_t begin,
+                                       size_t end, std::span<uint64_t> moved)
+{
+    size_t i = begin;
+    const __m256 step = _mm256_set1_ps(dt);
+    const __m256 one = _mm256_set1_ps(1.f);
+    const __m256i zero = _mm256_setzero_si256();
+    for (; i + 8 <= end; i += 8) {
+        __m256 accumulator = _mm256_loadu_ps(&npcs.accumulator[i]);
+        accumulator = _mm256_add_ps(accumulator, _mm256_mul_ps(step, _mm256_loadu_ps(&npcs.speed[i])));
+        const __m256 due = _mm256_cmp_ps(accumulator, one, _CMP_GE_OQ);
+        _mm256_storeu_ps(&npcs.accumulator[i], _mm256_sub_ps(accumulator, _mm256_and_ps(due, one)));
+        if (!_mm256_movemask_ps(due))
+            continue;
+        const __m256i dueLanes = _mm256_castps_si256(due);
+
+        // ГПСЧ продвигается только у тех, кто шагает наугад, как и в скалярном варианте
+        const __m256i steps = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(&npcs.step[i])));
+        const __m256i random = _mm256_and_si256(_mm256_cmpeq_epi32(steps, _mm256_set1_epi32(int(NpcStep::Random))), dueLanes);
+        __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&npcs.rng[i]));
+        __m256i next = _mm256_xor_si256(s, _mm256_slli_epi32(s, 13));
+        next = _mm256_xor_si256(next, _mm256_srli_epi32(next, 17));
+        next = _mm256_xor_si256(next, _mm256_slli_epi32(next, 5));
+        s = _mm256_blendv_epi8(s, next, random);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(&npcs.rng[i]), s);
+        const __m256i direction = _mm256_blendv_epi8(steps, _mm256_srli_epi32(s, 30), random);
+        const __m256i go = _mm256_andnot_si256(_mm256_cmpeq_epi32(direction, _mm256_set1_epi32(int(NpcStep::None))), dueLanes);
+
+        // dx = (d == 0) - (d == 1), dy = (d == 2) - (d == 3); сравнение даёт -1, поэтому вычитаем наоборот
+        const __m256i dx = _mm256_sub_epi32(_mm256_cmpeq_epi32(direction, _mm256_set1_epi32(1)),
+                                            _mm256_cmpeq_epi32(direction, zero));
+        const __m256i dy = _mm256_sub_epi32(_mm256_cmpeq_epi32(direction, _mm256_set1_epi32(3)),
+                                            _mm256_cmpeq_epi32(direction, _mm256_set1_epi32(2)));
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&npcs.x[i]));
+        const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&npcs.y[i]));
+        const __m256i nextX = _mm256_add_epi32(x, dx);
+        const __m256i nextY = _mm256_add_epi32(y, dy);
+        const __m256i pass = _mm256_and_si256(grid.can_pass8(nextX, nextY), go);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(&npcs.x[i]), _mm256_blendv_epi8(x, nextX, pass));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(&npcs.y[i]), _mm256_blendv_epi8(y, nextY, pass));
+        moved[(i - begin) >> 6] |= uint64_t(unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(pass)))) << ((i - begin) & 63);
+    }
+    return i;
+}
+
+// То же по 4 агента; вместо blendv - and/andnot/or
+static size_t move_npcs_sse2(NpcMovementArrays &npcs, const WalkabilityGrid &grid, float dt, size_t begin,
+                             size_t end, std::span<uint64_t> moved)
+{
+    auto select = [](__m128i mask, __m128i a, __m128i b) { return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b)); };
+    size_t i = begin;
+    const __m128 step = _mm_set1_ps(dt);
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i laneBits = _mm_setr_epi32(1, 2, 4, 8);
+    for (; i + 4 <= end; i += 4) {
+        __m128 accumulator = _mm_loadu_ps(&npcs.accumulator[i]);
+        accumulator = _mm_add_ps(accumulator, _mm_mul_ps(step, _mm_loadu_ps(&npcs.speed[i])));
+        const __m128 due = _mm_cmpge_ps(accumulator, one);
+        _mm_storeu_ps(&npcs.accumulator[i], _mm_sub_ps(accumulator, _mm_and_ps(due, one)));
+        if (!_mm_movemask_ps(due))
+            continue;
+        const __m128i dueLanes = _mm_castps_si128(due);
+
+        int packedSteps;
+        std::memcpy(&packedSteps, &npcs.step[i], sizeof(packedSteps));
+        const __m128i steps = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packedSteps), zero), zero);
+        const __m128i random = _mm_and_si128(_mm_cmpeq_epi32(steps, _mm_set1_epi32(int(NpcStep::Random))), dueLanes);
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&npcs.rng[i]));
+        __m128i next = _mm_xor_si128(s, _mm_slli_epi32(s, 13));
+        next = _mm_xor_si128(next, _mm_srli_epi32(next, 17));
+        next = _mm_xor_si128(next, _mm_slli_epi32(next, 5));
+        s = select(random, next, s);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(&npcs.rng[i]), s);
+        const __m128i direction = select(random, _mm_srli_epi32(s, 30), steps);
+        const __m128i go = _mm_andnot_si128(_mm_cmpeq_epi32(direction, _mm_set1_epi32(int(NpcStep::None))), dueLanes);
+
+        const __m128i dx = _mm_sub_epi32(_mm_cmpeq_epi32(direction, _mm_set1_epi32(1)), _mm_cmpeq_epi32(direction, zero));
+        const __m128i dy = _mm_sub_epi32(_mm_cmpeq_epi32(direction, _mm_set1_epi32(3)),
+                                         _mm_cmpeq_epi32(direction, _mm_set1_epi32(2)));
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&npcs.x[i]));
+        const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&npcs.y[i]));
+        const __m128i nextX = _mm_add_epi32(x, dx);
+        const __m128i nextY = _mm_add_epi32(y, dy);
+        // маска из can_pass4 разворачивается обратно в линии
+        const int passMask = grid.can_pass4(nextX, nextY) & _mm_movemask_ps(_mm_castsi128_ps(go));
+        const __m128i pass = _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(passMask), laneBits), laneBits);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(&npcs.x[i]), select(pass, nextX, x));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(&npcs.y[i]), select(pass, nextY, y));
+        moved[(i - begin) >> 6] |= uint64_t(unsigned(passMask)) << ((i - begin) & 63);
+    }
+    return i;
+}
+#endif
+
+void move_npcs(NpcMovementArrays &npcs, const WalkabilityGrid &grid, float dt, size_t begin, size_t end,
+               std::span<uint64_t> moved)
+{
+    std::fill(moved.begin(), moved.begin() + (end - begin + 63) / 64, 0);
+    size_t i = begin;
+#if defined(SIMD_X86)
+    if (get_simd_level() == SimdLevel::Avx2)
+        i = move_npcs_avx2(npcs, grid, dt, begin, end, moved);
+    else if (get_simd_level() == SimdLevel::Sse2)
+        i = move_npcs_sse2(npcs, grid, dt, begin, end, moved);
+#endif
+    move_range(npcs, grid, dt, begin, i, end, moved);
+}
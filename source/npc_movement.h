@@ -0,0 +1,84 @@
+#pragma once
+
+#include "math2d.h"
+#include "walkability_grid.h"
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+// Куда агент шагнёт, когда накопит время на шаг. Первые четыре совпадают с направлениями случайного шага
+enum class NpcStep : uint8_t {
+    PlusX,
+    MinusX,
+    PlusY,
+    MinusY,
+    Random, // в случайную сторону по ГПСЧ агента
+    None,   // стоять: шаг всё равно тратится
+};
+
+inline NpcStep to_npc_step(int2 delta)
+{
+    if (delta.x)
+        return delta.x > 0 ? NpcStep::PlusX : NpcStep::MinusX;
+    if (delta.y)
+        return delta.y > 0 ? NpcStep::PlusY : NpcStep::MinusY;
+    return NpcStep::None;
+}
+
+// Движение NPC в виде отдельных массивов (SoA), чтобы шаг считался сразу для 4-8 агентов.
+// Агент копит время со скоростью speed клеток в секунду и, накопив 1, делает шаг step[i],
+// если клетка проходима. BehaviourSystem хранит так позиции своих агентов: действия выбирают step,
+// а шаг делает ядро; случайное блуждание (хищники, загнанные в угол беглецы) целиком в ядре
+struct NpcMovementArrays {
+    std::vector<int32_t> x, y;
+    std::vector<float> speed;       // клеток в секунду
+    std::vector<float> accumulator; // накопленная доля шага
+    std::vector<uint32_t> rng;      // состояние xorshift32, не ноль
+    std::vector<NpcStep> step;
+
+    size_t size() const { return x.size(); }
+
+    void add(int2 position, float cellsPerSecond, uint32_t seed) {
+        x.push_back(position.x);
+        y.push_back(position.y);
+        speed.push_back(cellsPerSecond);
+        accumulator.push_back(0.f);
+        rng.push_back(seed ? seed : 0x9E3779B9u);
+        step.push_back(NpcStep::Random);
+    }
+
+    // удаление перестановкой последнего агента на место i
+    void remove(size_t i) {
+        x[i] = x.back(); x.pop_back();
+        y[i] = y.back(); y.pop_back();
+        speed[i] = speed.back(); speed.pop_back();
+        accumulator[i] = accumulator.back(); accumulator.pop_back();
+        rng[i] = rng.back(); rng.pop_back();
+        step[i] = step.back(); step.pop_back();
+    }
+
+    void swap(size_t a, size_t b) {
+        std::swap(x[a], x[b]);
+        std::swap(y[a], y[b]);
+        std::swap(speed[a], speed[b]);
+        std::swap(accumulator[a], accumulator[b]);
+        std::swap(rng[a], rng[b]);
+        std::swap(step[a], step[b]);
+    }
+
+    // новый агент k - это прежний from[k]
+    void reorder(std::span<const uint32_t> from);
+};
+
+// Один тик для агентов [begin, end): каждый копит dt * speed, и кто накопил 1, делает один шаг.
+// Бит k в moved - агент begin + k сдвинулся; в moved должно быть не меньше (end - begin + 63) / 64 слов.
+// dt = 0 - время накопил вызывающий. По 8 агентов за итерацию на AVX2 и по 4 на SSE2 (см. simd.h),
+// результат на всех наборах команд совпадает бит в бит
+void move_npcs(NpcMovementArrays &npcs, const WalkabilityGrid &grid, float dt, size_t begin, size_t end,
+               std::span<uint64_t> moved);
+
+inline void move_npcs(NpcMovementArrays &npcs, const WalkabilityGrid &grid, float dt, std::span<uint64_t> moved)
+{
+    move_npcs(npcs, grid, dt, 0, npcs.size(), moved);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "component.h"
+#include "game_object.h"
+#include "world.h"
+#include "path_request_service.h"
+#include "random.h"
+#include <cstdlib>
+
+// Path to a target, requested from PathRequestService and delivered by PathRequestSystem.
+// BehaviourSystem takes steps from it; the path is dropped as soon as the owner leaves it
+class PathFollower : public Component {
+public:
+    void on_create() override {
+        service = get_owner()->get_world()->get_service<PathRequestService>();
+        random = get_owner()->get_world()->get_service<Random>();
+    }
+
+    void on_destroy() override {
+        if (service && ticket != PathRequestService::NoTicket)
+            service->cancel(ticket);
+    }
+
+    bool is_waiting() const { return ticket != PathRequestService::NoTicket; }
+
+    void request(int2 from, int2 to) {
+        if (!service)
+            return;
+        if (is_waiting())
+            service->cancel(ticket);
+        path.reset();
+        next = 0;
+        ticket = service->request(from, to);
+    }
+
+    // head for a random floor cell
+    void wander(int2 from) {
+        if (!service || !random)
+            return;
+        auto owner = get_owner();
+        const auto &dungeon = service->get_dungeon();
+        const uint32_t index = random->get_int(uint32_t(dungeon->getFloorCount()), owner->get_id(),
+                                               owner->get_world()->get_tick(), WanderTarget);
+        request(from, dungeon->getFloorPosition(index));
+    }
+
+    // called by PathRequestSystem once per frame
+    void receive() {
+        if (!is_waiting())
+            return;
+        PathRequestService::Path result;
+        const auto status = service->poll(ticket, result);
+        if (status == PathRequestService::Status::Pending)
+            return;
+        ticket = PathRequestService::NoTicket;
+        path = status == PathRequestService::Status::Ready ? result : nullptr;
+        next = 0;
+    }
+
+    // step from pos along the path, false if there is no path or pos is not on it
+    bool next_step(int2 pos, int2 &step) {
+        if (!path || next >= path->size())
+            return false;
+        const int2 cell = (*path)[next];
+        step = int2(cell.x - pos.x, cell.y - pos.y);
+        if (std::abs(step.x) + std::abs(step.y) != 1) {
+            path.reset();
+            return false;
+        }
+        next++;
+        return true;
+    }
+
+private:
+    std::shared_ptr<PathRequestService> service;
+    std::shared_ptr<Random> random;
+    PathRequestService::Ticket ticket = PathRequestService::NoTicket;
+    PathRequestService::Path path;
+    size_t next = 0;
+};
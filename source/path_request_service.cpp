@@ -0,0 +1,277 @@
+#include "path_request_service.h"
+
+#include "hierarchical_pathfinder.h"
+#include "pathfinder.h"
+#include <algorithm>
+#include <cstdlib>
+
+PathRequestService::Solver::~Solver() = default;
+
+bool PathRequestService::is_hierarchical(const Job &job) const
+{
+    const int distance = std::abs(job.from.x - job.to.x) + std::abs(job.from.y - job.to.y);
+    return hierarchicalDistance > 0 && distance >= hierarchicalDistance;
+}
+
+size_t PathRequestService::reserve(const Solver &solver) const
+{
+    if (frameNodes >= nodeBudget)
+        return 0;
+    const size_t left = nodeBudget - frameNodes;
+    if (solver.suspended)
+        return std::min(left, sliceNodes);
+    if (queue.empty())
+        return 0;
+    if (!is_hierarchical(*queue.front()))
+        return std::min(left, sliceNodes);
+    // HPA* не прерывается: занимаем его оценку целиком
+    return hierarchicalEstimate <= left || frameNodes == 0 ? hierarchicalEstimate : 0;
+}
+
+// JPS даёт тот же путь, что и A*, но раскрывает на порядок меньше узлов;
+// через всю большую карту быстрее HPA* по порталам
+size_t PathRequestService::solve(Solver &solver, const JobPtr &job, size_t maxNodes, bool &solved) const
+{
+    solved = true;
+    if (solver.suspended != job && is_hierarchical(*job)) {
+        if (!solver.hierarchical)
+            solver.hierarchical = std::make_unique<HierarchicalPathfinder>(dungeon);
+        job->found = solver.hierarchical->find_path(job->from, job->to, job->result);
+        return std::max<size_t>(solver.hierarchical->get_expanded_nodes(), 1);
+    }
+    if (!solver.grid)
+        solver.grid = std::make_unique<Pathfinder>(dungeon);
+    using SearchStatus = Pathfinder::SearchStatus;
+    SearchStatus status = SearchStatus::Running;
+    if (solver.suspended != job)
+        status = solver.grid->start_path_jps(job->from, job->to, job->result);
+    if (status == SearchStatus::Running)
+        status = solver.grid->resume_path_jps(maxNodes, job->result);
+    if (status == SearchStatus::Running) {
+        solver.suspended = job;
+        solved = false;
+    } else {
+        solver.suspended.reset();
+        job->found = status == SearchStatus::Found;
+    }
+    return std::max<size_t>(solver.grid->get_expanded_nodes(), 1);
+}
+
+PathRequestService::PathRequestService(std::shared_ptr<Dungeon> dungeon, int workerCount,
+                                       size_t nodeBudgetPerFrame, size_t cacheSize, int hierarchicalDistance)
+    : dungeon(dungeon), nodeBudget(std::max<size_t>(nodeBudgetPerFrame, 1)),
+      sliceNodes(std::max<size_t>(nodeBudget / std::max(2 * workerCount, 1), 1)), cacheSize(cacheSize),
+      hierarchicalDistance(hierarchicalDistance), cacheRevision(dungeon->getRevision()),
+      hierarchicalEstimate(std::max<size_t>(nodeBudget / 4, 1))
+{
+    for (int i = 0; i < workerCount; i++)
+        workers.emplace_back(&PathRequestService::worker_loop, this);
+    // без рабочих потоков поисковики создаются сразу: массивы узлов и граф порталов строятся не в кадре
+    if (workerCount == 0) {
+        inlineSolver.grid = std::make_unique<Pathfinder>(dungeon);
+        if (hierarchicalDistance > 0)
+            inlineSolver.hierarchical = std::make_unique<HierarchicalPathfinder>(dungeon);
+    }
+}
+
+PathRequestService::~PathRequestService()
+{
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &worker : workers)
+        worker.join();
+}
+
+PathRequestService::Ticket PathRequestService::request(int2 from, int2 to)
+{
+    const uint64_t key = make_key(from, to);
+    JobPtr job;
+    if (Path cached = find_cached(key)) {
+        job = std::make_shared<Job>();
+        job->status = Status::Ready;
+        job->path = cached;
+        cacheHits++;
+    } else if (auto it = pendingByKey.find(key); it != pendingByKey.end()) {
+        job = it->second;
+        mergedRequests++;
+    } else {
+        job = std::make_shared<Job>();
+        job->from = from;
+        job->to = to;
+        job->key = key;
+        pendingByKey[key] = job;
+        incoming.push_back(job);
+    }
+    job->waiters++;
+    if (nextTicket == NoTicket)
+        nextTicket++;
+    const Ticket ticket = nextTicket++;
+    tickets[ticket] = job;
+    return ticket;
+}
+
+PathRequestService::Status PathRequestService::poll(Ticket ticket, Path &path)
+{
+    auto it = tickets.find(ticket);
+    if (it == tickets.end())
+        return Status::Failed;
+    const JobPtr &job = it->second;
+    if (job->status == Status::Pending)
+        return Status::Pending;
+    const Status status = job->status;
+    path = job->path;
+    job->waiters--;
+    tickets.erase(it);
+    return status;
+}
+
+void PathRequestService::cancel(Ticket ticket)
+{
+    auto it = tickets.find(ticket);
+    if (it == tickets.end())
+        return;
+    // задача без ожидающих выкидывается из очереди в update(), если её ещё не начали
+    it->second->waiters--;
+    tickets.erase(it);
+}
+
+void PathRequestService::update()
+{
+    // карта изменилась - старые пути могут вести сквозь стены
+    const uint32_t revision = dungeon->getRevision();
+    const bool mapChanged = revision != cacheRevision;
+    if (mapChanged) {
+        cache.clear();
+        cacheIndex.clear();
+        cacheRevision = revision;
+    }
+    {
+        std::lock_guard lock(mutex);
+        finished.swap(done);
+        // ещё не начатые задачи решатся уже на новой карте
+        if (mapChanged)
+            for (JobPtr &job : queue)
+                job->revision = revision;
+        lastFrameNodes = frameNodes;
+        frameNodes = 0;
+        frame++;
+        std::erase_if(queue, [&](const JobPtr &job) {
+            if (job->waiters > 0)
+                return false;
+            pendingByKey.erase(job->key);
+            return true;
+        });
+        for (JobPtr &job : incoming) {
+            job->revision = revision;
+            queue.push_back(std::move(job));
+        }
+        incoming.clear();
+        queuedCount = queue.size();
+    }
+
+    if (workers.empty()) {
+        // без рабочих потоков бюджет тратится здесь же, и результат готов в этом кадре
+        for (size_t reserved; (reserved = reserve(inlineSolver)) > 0;) {
+            JobPtr job = inlineSolver.suspended;
+            if (!job) {
+                job = std::move(queue.front());
+                queue.pop_front();
+            }
+            bool solved;
+            const size_t nodes = solve(inlineSolver, job, reserved, solved);
+            frameNodes += nodes;
+            if (is_hierarchical(*job))
+                hierarchicalEstimate = (hierarchicalEstimate * 3 + nodes) / 4;
+            if (solved)
+                finished.push_back(std::move(job));
+        }
+        lastFrameNodes = frameNodes;
+        frameNodes = 0;
+        queuedCount = queue.size();
+    } else {
+        wake.notify_all();
+    }
+
+    for (const JobPtr &job : finished)
+        complete(job);
+    finished.clear();
+}
+
+void PathRequestService::worker_loop()
+{
+    Solver solver;
+    std::unique_lock lock(mutex);
+    for (;;) {
+        size_t reserved = 0;
+        wake.wait(lock, [&] { return stopping || (reserved = reserve(solver)) > 0; });
+        if (stopping)
+            return;
+        JobPtr job = solver.suspended;
+        if (!job) {
+            job = std::move(queue.front());
+            queue.pop_front();
+        }
+        // узлы занимаются до начала работы, чтобы другие потоки не вышли за бюджет вместе с этим
+        frameNodes += reserved;
+        const uint32_t reservedFrame = frame;
+        lock.unlock();
+        bool solved;
+        const size_t nodes = solve(solver, job, reserved, solved);
+        lock.lock();
+        // занятое, но не потраченное возвращается; если кадр уже сменился, перерасход идёт в новый
+        if (frame == reservedFrame)
+            frameNodes = frameNodes - reserved + nodes;
+        else if (nodes > reserved)
+            frameNodes += nodes - reserved;
+        if (is_hierarchical(*job))
+            hierarchicalEstimate = (hierarchicalEstimate * 3 + nodes) / 4;
+        if (solved)
+            done.push_back(std::move(job));
+    }
+}
+
+void PathRequestService::complete(const JobPtr &job)
+{
+    if (job->revision != dungeon->getRevision()) {
+        job->result.clear();
+        if (job->waiters > 0)
+            incoming.push_back(job);
+        else
+            pendingByKey.erase(job->key);
+        return;
+    }
+    pendingByKey.erase(job->key);
+    job->status = job->found ? Status::Ready : Status::Failed;
+    job->path = std::make_shared<const std::vector<int2>>(std::move(job->result));
+    if (job->found)
+        add_to_cache(job->key, job->path);
+}
+
+PathRequestService::Path PathRequestService::find_cached(uint64_t key)
+{
+    auto it = cacheIndex.find(key);
+    if (it == cacheIndex.end())
+        return nullptr;
+    cache.splice(cache.begin(), cache, it->second);
+    return it->second->second;
+}
+
+void PathRequestService::add_to_cache(uint64_t key, const Path &path)
+{
+    if (cacheSize == 0)
+        return;
+    if (auto it = cacheIndex.find(key); it != cacheIndex.end()) {
+        it->second->second = path;
+        cache.splice(cache.begin(), cache, it->second);
+        return;
+    }
+    cache.emplace_front(key, path);
+    cacheIndex[key] = cache.begin();
+    if (cache.size() > cacheSize) {
+        cacheIndex.erase(cache.back().first);
+        cache.pop_back();
+    }
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "dungeon_generator.h"
+#include "math2d.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class Pathfinder;
+class HierarchicalPathfinder;
+
+// Очередь запросов пути для множества агентов.
+// Агент получает билет и забирает готовый путь в одном из следующих кадров.
+// Запросы решают рабочие потоки (у каждого свой Pathfinder), но только пока не исчерпан
+// бюджет кадра в раскрытых узлах: узлы занимаются до начала работы, а JPS идёт кусками
+// и, упёршись в свою долю, откладывается до следующего кадра с тем же открытым списком.
+// Так цена поиска за кадр ограничена при любом числе агентов и любой длине пути.
+// Одинаковые запросы (тот же старт и цель) решаются один раз, недавние пути берутся из LRU-кэша.
+// Дальние запросы (манхэттен не меньше hierarchicalDistance) решает HierarchicalPathfinder:
+// граф порталов у каждого рабочего свой, строится при первом дальнем запросе и потом
+// обновляется по правкам карты. Для них бюджет считается в узлах абстрактного графа;
+// такой поиск не делится на куски, поэтому под него занимается средняя цена прошлых дальних
+// запросов, и он начинается, только если она помещается в остаток кадра (или кадр ещё пуст).
+// Все методы, кроме рабочих потоков, вызываются из потока симуляции.
+class PathRequestService {
+public:
+    using Ticket = uint32_t;
+    static constexpr Ticket NoTicket = 0;
+    // Путь без стартовой клетки, как у Pathfinder::find_path; общий для всех, кто его ждал
+    using Path = std::shared_ptr<const std::vector<int2>>;
+    enum class Status { Pending, Ready, Failed };
+
+    // workerCount == 0 - запросы решаются прямо в update() в пределах того же бюджета.
+    // hierarchicalDistance == 0 - все запросы решает JPS
+    PathRequestService(std::shared_ptr<Dungeon> dungeon, int workerCount,
+                       size_t nodeBudgetPerFrame = 5000, size_t cacheSize = 256, int hierarchicalDistance = 0);
+    ~PathRequestService();
+
+    Ticket request(int2 from, int2 to);
+    // Ready и Failed отдают результат один раз, после этого билет недействителен
+    Status poll(Ticket ticket, Path &path);
+    void cancel(Ticket ticket);
+
+    // Раз в кадр: забирает готовые пути, отдаёт рабочим новые запросы и обновляет бюджет
+    void update();
+
+    std::shared_ptr<Dungeon> get_dungeon() const { return dungeon; }
+    size_t get_queued_count() const { return queuedCount; }
+    // раскрыто узлов за прошлый кадр
+    size_t get_frame_nodes() const { return lastFrameNodes; }
+    size_t get_cache_hits() const { return cacheHits; }
+    size_t get_merged_requests() const { return mergedRequests; }
+
+private:
+    struct Job {
+        int2 from, to;
+        uint64_t key;
+        // ревизия карты, на которой задача отдана рабочим; если к концу поиска карта изменилась,
+        // путь мог пройти сквозь новую стену - задача решается заново
+        uint32_t revision = 0;
+        // поля ниже принадлежат потоку симуляции
+        uint32_t waiters = 0;
+        Status status = Status::Pending;
+        Path path;
+        // результат рабочего потока, читается после того, как задача попала в done
+        std::vector<int2> result;
+        bool found = false;
+    };
+    using JobPtr = std::shared_ptr<Job>;
+    // поисковики одного потока, создаются при первом запросе своего вида
+    struct Solver {
+        std::unique_ptr<Pathfinder> grid;
+        std::unique_ptr<HierarchicalPathfinder> hierarchical;
+        // JPS, прерванный на бюджете кадра: его открытый список - в grid, продолжает этот же поток
+        JobPtr suspended;
+        ~Solver();
+    };
+
+    std::shared_ptr<Dungeon> dungeon;
+    size_t nodeBudget;
+    size_t sliceNodes; // доля бюджета на один кусок JPS, чтобы кадр делился между рабочими
+    size_t cacheSize;
+    int hierarchicalDistance;
+
+    // только поток симуляции
+    Ticket nextTicket = 1;
+    std::unordered_map<Ticket, JobPtr> tickets;
+    std::unordered_map<uint64_t, JobPtr> pendingByKey;
+    std::vector<JobPtr> incoming, finished;
+    std::list<std::pair<uint64_t, Path>> cache; // в начале - самые свежие
+    std::unordered_map<uint64_t, std::list<std::pair<uint64_t, Path>>::iterator> cacheIndex;
+    uint32_t cacheRevision;
+    size_t queuedCount = 0, lastFrameNodes = 0, cacheHits = 0, mergedRequests = 0;
+
+    // общее с рабочими потоками, под mutex
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<JobPtr> queue;
+    std::vector<JobPtr> done;
+    size_t frameNodes = 0;          // раскрыто и занято под начатые куски в этом кадре
+    uint32_t frame = 0;
+    size_t hierarchicalEstimate;    // средняя цена дальнего запроса
+    bool stopping = false;
+    std::vector<std::thread> workers;
+    Solver inlineSolver; // когда рабочих потоков нет
+
+    static uint64_t make_key(int2 from, int2 to) {
+        return (uint64_t(uint16_t(from.x)) << 48) | (uint64_t(uint16_t(from.y)) << 32) |
+               (uint64_t(uint16_t(to.x)) << 16) | uint64_t(uint16_t(to.y));
+    }
+
+    void worker_loop();
+    bool is_hierarchical(const Job &job) const;
+    // Сколько узлов занять под следующий кусок работы решателя, 0 - в этом кадре он уже не помещается.
+    // Под mutex (или без рабочих потоков)
+    size_t reserve(const Solver &solver) const;
+    // Кусок работы не больше maxNodes узлов JPS; возвращает раскрытые узлы.
+    // Недорешённая задача остаётся в solver.suspended, решённая возвращает true в solved
+    size_t solve(Solver &solver, const JobPtr &job, size_t maxNodes, bool &solved) const;
+    // результат, найденный на старой карте, выбрасывается, а задача снова встаёт в очередь
+    void complete(const JobPtr &job);
+    Path find_cached(uint64_t key);
+    void add_to_cache(uint64_t key, const Path &path);
+};
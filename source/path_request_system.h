@@ -0,0 +1,22 @@
+#pragma once
+
+#include "component.h"
+#include "world.h"
+#include "path_follower.h"
+#include "path_request_service.h"
+
+// Runs the path request service once per frame and hands finished paths to PathFollowers
+class PathRequestSystem : public Component {
+    std::shared_ptr<PathRequestService> service;
+public:
+    PathRequestSystem(std::shared_ptr<PathRequestService> service)
+        : service(service) {}
+
+    void on_update(float dt) override {
+        service->update();
+        for (auto& obj : get_owner()->get_world()->get_objects()) {
+            if (auto follower = obj->get_component<PathFollower>())
+                follower->receive();
+        }
+    }
+};
@@ -0,0 +1,291 @@
+#pragma once
+
+#include "dungeon_generator.h"
+#include "math2d.h"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+// A* по сетке Dungeon (4-связность, целочисленная стоимость шага).
+// Узлы и куча живут между запросами: узел считается пустым, если его generation не совпадает с текущим,
+// поэтому очищать массивы перед каждым поиском не нужно и в установившемся режиме нет аллокаций.
+// Один Pathfinder - на один поток.
+class Pathfinder {
+public:
+    static constexpr uint32_t StepCost = 1;
+
+    // Фильтр по умолчанию пропускает все клетки пола
+    struct NoFilter {
+        bool operator()(int2) const { return true; }
+    };
+
+    explicit Pathfinder(std::shared_ptr<Dungeon> dungeon)
+        : dungeon(dungeon), W(dungeon->getWidth()), H(dungeon->getHeight()),
+          nodes(size_t(W) * H) {}
+
+    // Путь без стартовой клетки: path[0] - первый шаг, path.back() - цель.
+    // filter(cell) == false запрещает заходить в клетку (например, где стоит хищник)
+    template<typename Filter = NoFilter>
+    bool find_path(int2 from, int2 to, std::vector<int2> &path, Filter &&filter = {}) {
+        path.clear();
+        expandedNodes = 0;
+        if (!dungeon->isFloor(from.x, from.y) || !dungeon->isFloor(to.x, to.y))
+            return false;
+        // разные области связности - пути нет, искать незачем
+        if (!dungeon->getRegions().same_region(from, to))
+            return false;
+        if (from.x == to.x && from.y == to.y)
+            return true;
+        if (!filter(to))
+            return false;
+
+        begin_search();
+        const uint32_t start = index(from);
+        const uint32_t goal = index(to);
+        open(start, 0, heuristic(from, to), start);
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), HeapGreater{});
+            const HeapItem item = heap.back();
+            heap.pop_back();
+            Node &node = nodes[item.cell];
+            if (node.closed || item.g != node.g)
+                continue; // устаревшая запись, узел уже улучшен
+            node.closed = true;
+            expandedNodes++;
+            if (item.cell == goal) {
+                build_path(start, goal, path);
+                return true;
+            }
+            const int2 cell = to_cell(item.cell);
+            const int2 neighbours[4] = { int2{cell.x + 1, cell.y}, int2{cell.x - 1, cell.y},
+                                         int2{cell.x, cell.y + 1}, int2{cell.x, cell.y - 1} };
+            for (int2 next : neighbours) {
+                if (!dungeon->isFloor(next.x, next.y) || !filter(next))
+                    continue;
+                open(index(next), item.g + StepCost, heuristic(next, to), item.cell);
+            }
+        }
+        return false;
+    }
+
+    enum class SearchStatus { Found, NotFound, Running };
+
+    // Jump Point Search для 4-связной сетки с одинаковой стоимостью шага: тот же результат, что у find_path,
+    // но в кучу попадают только точки поворота. Горизонтальный прыжок ищет ближайшую стену/поворот/цель
+    // сразу по 64 клетки через countr_zero/countl_zero битовой маски проходимости.
+    // Канонический путь может свернуть с вертикали в любой клетке, а с горизонтали - только там,
+    // где сбоку открывается проход (forced neighbour). Фильтр клеток не поддерживается - используйте find_path
+    bool find_path_jps(int2 from, int2 to, std::vector<int2> &path) {
+        SearchStatus status = start_path_jps(from, to, path);
+        if (status == SearchStatus::Running)
+            status = resume_path_jps(SIZE_MAX, path);
+        return status == SearchStatus::Found;
+    }
+
+    // Тот же JPS по частям, чтобы один длинный поиск не занимал весь кадр: start_path_jps готовит поиск
+    // (простые случаи решаются сразу), resume_path_jps раскрывает не больше maxNodes узлов и возвращает
+    // Running, если путь ещё не найден. Открытый список живёт в Pathfinder до следующего start
+    SearchStatus start_path_jps(int2 from, int2 to, std::vector<int2> &path) {
+        path.clear();
+        expandedNodes = 0;
+        if (!dungeon->isFloor(from.x, from.y) || !dungeon->isFloor(to.x, to.y))
+            return SearchStatus::NotFound;
+        if (!dungeon->getRegions().same_region(from, to))
+            return SearchStatus::NotFound;
+        if (from.x == to.x && from.y == to.y)
+            return SearchStatus::Found;
+
+        begin_search();
+        searchStart = index(from);
+        searchGoal = to;
+        open(searchStart, 0, heuristic(from, to), searchStart);
+        return SearchStatus::Running;
+    }
+
+    SearchStatus resume_path_jps(size_t maxNodes, std::vector<int2> &path) {
+        const uint32_t start = searchStart;
+        const int2 to = searchGoal;
+        const uint32_t goal = index(to);
+        expandedNodes = 0;
+        while (!heap.empty()) {
+            if (expandedNodes >= maxNodes)
+                return SearchStatus::Running;
+            std::pop_heap(heap.begin(), heap.end(), HeapGreater{});
+            const HeapItem item = heap.back();
+            heap.pop_back();
+            Node &node = nodes[item.cell];
+            if (node.closed || item.g != node.g)
+                continue;
+            node.closed = true;
+            expandedNodes++;
+            if (item.cell == goal) {
+                build_jump_path(start, goal, path);
+                return SearchStatus::Found;
+            }
+            const int2 cell = to_cell(item.cell);
+            const int2 parent = to_cell(node.parent);
+            auto jumpTo = [&](int2 jumpPoint) {
+                if (jumpPoint.x < 0)
+                    return;
+                const uint32_t dist = std::abs(jumpPoint.x - cell.x) + std::abs(jumpPoint.y - cell.y);
+                open(index(jumpPoint), item.g + dist * StepCost, heuristic(jumpPoint, to), item.cell);
+            };
+            if (item.cell == start) {
+                for (int d : {1, -1}) {
+                    jumpTo(jump_horizontal(cell, d, to));
+                    jumpTo(jump_vertical(cell, d, to));
+                }
+            } else if (parent.y == cell.y) {
+                // пришли по горизонтали: дальше прямо, вертикаль - только там, где она открылась
+                const int dx = cell.x > parent.x ? 1 : -1;
+                jumpTo(jump_horizontal(cell, dx, to));
+                for (int dy : {1, -1}) {
+                    if (dungeon->isFloor(cell.x, cell.y + dy) && !dungeon->isFloor(cell.x - dx, cell.y + dy))
+                        jumpTo(jump_vertical(cell, dy, to));
+                }
+            } else {
+                // пришли по вертикали: дальше прямо и в обе стороны по горизонтали
+                const int dy = cell.y > parent.y ? 1 : -1;
+                jumpTo(jump_vertical(cell, dy, to));
+                jumpTo(jump_horizontal(cell, 1, to));
+                jumpTo(jump_horizontal(cell, -1, to));
+            }
+        }
+        return SearchStatus::NotFound;
+    }
+
+    // Сколько узлов раскрыл последний запрос (у поиска по частям - последний resume_path_jps)
+    size_t get_expanded_nodes() const { return expandedNodes; }
+
+private:
+    struct Node {
+        uint32_t generation = 0;
+        uint32_t g = 0;
+        uint32_t parent = 0;
+        bool closed = false;
+    };
+    struct HeapItem {
+        uint32_t f, h, g;
+        uint32_t cell;
+    };
+    // std::*_heap строят max-кучу, поэтому сравнение перевёрнуто.
+    // При равном f раньше раскрывается узел ближе к цели
+    struct HeapGreater {
+        bool operator()(const HeapItem &a, const HeapItem &b) const {
+            return a.f != b.f ? a.f > b.f : a.h > b.h;
+        }
+    };
+
+    std::shared_ptr<Dungeon> dungeon;
+    int W, H;
+    std::vector<Node> nodes;
+    std::vector<HeapItem> heap;
+    uint32_t generation = 0;
+    size_t expandedNodes = 0;
+    // поиск по частям
+    uint32_t searchStart = 0;
+    int2 searchGoal{};
+
+    uint32_t index(int2 cell) const { return uint32_t(cell.y) * W + cell.x; }
+    int2 to_cell(uint32_t i) const { return int2(int(i % W), int(i / W)); }
+    static uint32_t heuristic(int2 a, int2 b) { return StepCost * (std::abs(a.x - b.x) + std::abs(a.y - b.y)); }
+
+    void begin_search() {
+        heap.clear();
+        if (++generation == 0) {
+            // счётчик переполнился - один раз за 4 млрд запросов чистим честно
+            std::fill(nodes.begin(), nodes.end(), Node{});
+            generation = 1;
+        }
+    }
+
+    void open(uint32_t cell, uint32_t g, uint32_t h, uint32_t parent) {
+        Node &node = nodes[cell];
+        if (node.generation == generation && (node.closed || node.g <= g))
+            return;
+        node = Node{generation, g, parent, false};
+        heap.push_back(HeapItem{g + h, h, g, cell});
+        std::push_heap(heap.begin(), heap.end(), HeapGreater{});
+    }
+
+    // Слово строки y со "стоп-битами" для горизонтального прыжка в сторону dx:
+    // стена, клетка цели, или клетка, над/под которой проход открылся (а позади был закрыт)
+    uint64_t jump_stop_word(int y, int w, int dx, int2 goal) const {
+        const int wordsPerRow = dungeon->getWordsPerRow();
+        uint64_t stop = ~dungeon->getWalkableRow(y)[w];
+        for (int sideY : {y - 1, y + 1}) {
+            if (sideY < 0 || sideY >= H)
+                continue;
+            const uint64_t *side = dungeon->getWalkableRow(sideY);
+            const uint64_t behind = dx > 0 ? (side[w] << 1) | (w > 0 ? side[w - 1] >> 63 : 0)
+                                           : (side[w] >> 1) | (w + 1 < wordsPerRow ? side[w + 1] << 63 : 0);
+            stop |= side[w] & ~behind;
+        }
+        if (goal.y == y && (goal.x >> 6) == w)
+            stop |= uint64_t(1) << (goal.x & 63);
+        return stop;
+    }
+
+    // Ближайшая точка прыжка по горизонтали или {-1, -1}, если упёрлись в стену
+    int2 jump_horizontal(int2 from, int dx, int2 goal) const {
+        const int wordsPerRow = dungeon->getWordsPerRow();
+        const int y = from.y;
+        const int first = from.x + dx;
+        if (first < 0 || first >= W)
+            return int2{-1, -1};
+        int w = first >> 6;
+        int x;
+        if (dx > 0) {
+            uint64_t bits = jump_stop_word(y, w, dx, goal) & (~uint64_t(0) << (first & 63));
+            while (!bits) {
+                if (++w >= wordsPerRow)
+                    return int2{-1, -1};
+                bits = jump_stop_word(y, w, dx, goal);
+            }
+            x = (w << 6) + std::countr_zero(bits);
+        } else {
+            uint64_t bits = jump_stop_word(y, w, dx, goal) & (~uint64_t(0) >> (63 - (first & 63)));
+            while (!bits) {
+                if (--w < 0)
+                    return int2{-1, -1};
+                bits = jump_stop_word(y, w, dx, goal);
+            }
+            x = (w << 6) + 63 - std::countl_zero(bits);
+        }
+        return dungeon->isFloor(x, y) ? int2{x, y} : int2{-1, -1};
+    }
+
+    // Вертикаль останавливается в клетке, из которой горизонтальный прыжок что-то находит
+    int2 jump_vertical(int2 from, int dy, int2 goal) const {
+        for (int y = from.y + dy;; y += dy) {
+            const int2 cell{from.x, y};
+            if (!dungeon->isFloor(cell.x, cell.y))
+                return int2{-1, -1};
+            if (cell.x == goal.x && cell.y == goal.y)
+                return cell;
+            if (jump_horizontal(cell, 1, goal).x >= 0 || jump_horizontal(cell, -1, goal).x >= 0)
+                return cell;
+        }
+    }
+
+    // Между точками прыжка - прямые отрезки, разворачиваем их в клетки
+    void build_jump_path(uint32_t start, uint32_t goal, std::vector<int2> &path) const {
+        for (uint32_t cell = goal; cell != start; cell = nodes[cell].parent) {
+            const int2 to = to_cell(cell);
+            const int2 from = to_cell(nodes[cell].parent);
+            const int2 step{to.x > from.x ? -1 : to.x < from.x ? 1 : 0, to.y > from.y ? -1 : to.y < from.y ? 1 : 0};
+            for (int2 c = to; c.x != from.x || c.y != from.y; c = int2{c.x + step.x, c.y + step.y})
+                path.push_back(c);
+        }
+        std::reverse(path.begin(), path.end());
+    }
+
+    void build_path(uint32_t start, uint32_t goal, std::vector<int2> &path) const {
+        for (uint32_t cell = goal; cell != start; cell = nodes[cell].parent)
+            path.push_back(to_cell(cell));
+        std::reverse(path.begin(), path.end());
+    }
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// Независимые потоки случайных чисел для каждой сущности мира.
+enum RandomStream : uint32_t {
+    WanderStep,
+    WanderTarget,
+    SpawnPosition,
+    SpawnKind,
+    FoodPosition,
+    FoodKind,
+    InteractionPriority,
+};
+
+// Счётчиковый генератор Philox4x32-10: число - чистая функция от (seed, entity, tick, stream, index),
+// общего состояния нет. Поэтому выбор агента не зависит от того, кто обновился раньше,
+// и одинаков при обновлении в любом порядке и на любом потоке.
+// entity - GameObject::get_id(), tick - World::get_tick(), index - если одной сущности
+// нужно несколько чисел одного потока за тик
+class Random {
+public:
+    explicit Random(uint64_t seed)
+        : key0(uint32_t(seed)), key1(uint32_t(seed >> 32)) {}
+
+    // Четыре независимых 32-битных числа
+    std::array<uint32_t, 4> generate(uint32_t entity, uint32_t tick, uint32_t stream, uint32_t index = 0) const {
+        std::array<uint32_t, 4> c = { entity, tick, stream, index };
+        uint32_t k0 = key0, k1 = key1;
+        for (int round = 0; round < 10; round++) {
+            if (round > 0) {
+                k0 += 0x9E3779B9u;
+                k1 += 0xBB67AE85u;
+            }
+            const uint64_t p0 = uint64_t(0xD2511F53u) * c[0];
+            const uint64_t p1 = uint64_t(0xCD9E8D57u) * c[2];
+            c = { uint32_t(p1 >> 32) ^ c[1] ^ k0, uint32_t(p1), uint32_t(p0 >> 32) ^ c[3] ^ k1, uint32_t(p0) };
+        }
+        return c;
+    }
+
+    uint32_t get_uint(uint32_t entity, uint32_t tick, uint32_t stream, uint32_t index = 0) const {
+        return generate(entity, tick, stream, index)[0];
+    }
+
+    // [0, n): умножение вместо %, смещение порядка n / 2^32 - для игры неважно
+    uint32_t get_int(uint32_t n, uint32_t entity, uint32_t tick, uint32_t stream, uint32_t index = 0) const {
+        return uint32_t((uint64_t(get_uint(entity, tick, stream, index)) * n) >> 32);
+    }
+
+    // [0, 1)
+    float get_float(uint32_t entity, uint32_t tick, uint32_t stream, uint32_t index = 0) const {
+        return float(get_uint(entity, tick, stream, index) >> 8) * (1.f / 16777216.f);
+    }
+
+private:
+    uint32_t key0, key1;
+};
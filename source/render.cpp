@@ -4,13 +4,44 @@
 #include "sprite.h"
 #include "health.h"
 #include "stamina.h"
-#include "background_tag.h"
+#include "food.h"
+#include "background_cache.h"
+#include "dungeon_overview.h"
+#include "scene_index.h"
+#include "sprite_batch.h"
+#include "render_frame.h"
+#include "frame_arena.h"
+#include <algorithm>
+#include <cmath>
 #include <SDL3/SDL_render.h>
 
-void render_world(SDL_Window* window, SDL_Renderer* renderer, World& world)
+// everything of the frame goes through one RenderQueue sorted by layer, texture and y,
+// then into a SpriteBatch: one SDL_RenderGeometry call per layer and texture
+enum RenderLayer : uint8_t {
+    LayerTiles,
+    LayerFood,
+    LayerSprites,
+    LayerBars,
+};
+
+// below this zoom a tile is a few pixels: the map is drawn from DungeonOverview
+// and entities become density dots, so the frame costs about the same at any zoom
+const float LodPixelsPerMeter = 8.f;
+// smallest density dot on screen, in pixels
+const float DotPixels = 4.f;
+// dots are brightest from this many entities on
+const uint32_t DotFullCount = 8;
+
+template <class ToScreen>
+static bool collect_overview(RenderFrame& frame, World& world, int2 viewMin, int2 viewMax, float ppm, const ToScreen& to_screen);
+
+static void collect_sprites(RenderFrame& frame, const Camera2D& camera, const Transform2D& cameraTransform,
+                            int screenW, int screenH, World& world);
+
+// Simulation thread: gathers the frame from the world, nothing here touches SDL_Renderer
+void build_render_frame(World& world, int screenW, int screenH, RenderFrame& frame)
 {
-    int screenW, screenH;
-    SDL_GetWindowSize(window, &screenW, &screenH);
+    frame.clear();
     // search of camera component
     std::shared_ptr<Camera2D> camera2d = nullptr;
     std::shared_ptr<Transform2D> camera_transform = nullptr;
@@ -22,84 +53,196 @@ void render_world(SDL_Window* window, SDL_Renderer* renderer, World& world)
     }
     if (!camera2d || !camera_transform)
         return;
+    collect_sprites(frame, *camera2d, *camera_transform, screenW, screenH, world);
+    frame.queue.sort();
+}
 
-    // Draw background sprites
-    for (const auto& object : world.get_objects()) {
-        auto sprite = object->get_component<Sprite>();
-        auto transform = object->get_component<Transform2D>();
-        auto bgTag = object->get_component<BackGroundTag>();
-        if (!bgTag)
-            continue;
-        if (!sprite || !transform)
-            continue;
-        SDL_FRect dst = to_camera_space(*transform, *camera_transform, *camera2d);
+// Render thread: redraws background chunks and draws the frame, the world is not touched
+void draw_render_frame(SDL_Renderer* renderer, const RenderFrame& frame, ChunkTextures& chunkTextures,
+                       OverviewTextures& overviewTextures, SpriteBatch& batch)
+{
+    chunkTextures.apply(renderer, frame.background);
+    overviewTextures.apply(renderer, frame.overview);
+    frame.queue.submit(batch, RenderQueue::OwnedTextures{ chunkTextures.get(), overviewTextures.get() });
+    batch.flush(renderer);
+}
+
+static void collect_sprites(RenderFrame& frame, const Camera2D& camera, const Transform2D& cameraTransform,
+                            int screenW, int screenH, World& world)
+{
+    RenderQueue& queue = frame.queue;
+    // Visible cells: everything drawn at x covers [x, x + size) meters, the screen center is the camera
+    const float ppm = camera.pixelsPerMeter;
+    const double viewMinX = cameraTransform.x - screenW / 2 / ppm, viewMaxX = cameraTransform.x + screenW / 2 / ppm;
+    const double viewMinY = cameraTransform.y - screenH / 2 / ppm, viewMaxY = cameraTransform.y + screenH / 2 / ppm;
+    const int2 viewMin(int(std::floor(viewMinX)), int(std::floor(viewMinY)));
+    const int2 viewMax(int(std::floor(viewMaxX)), int(std::floor(viewMaxY)));
+    auto is_visible = [&](const Transform2D &transform) {
+        return transform.x + transform.sizeX > viewMinX && transform.x < viewMaxX &&
+               transform.y + transform.sizeY > viewMinY && transform.y < viewMaxY;
+    };
+    auto to_screen = [&](const Transform2D &transform) {
+        SDL_FRect dst = to_camera_space(transform, cameraTransform, camera);
         dst.x += screenW / 2;
         dst.y += screenH / 2;
-        DrawSprite(renderer, *sprite, dst);
+        return dst;
+    };
+    if (ppm < LodPixelsPerMeter && collect_overview(frame, world, viewMin, viewMax, ppm, to_screen))
+        return;
+
+    // Draw background: prerendered chunks, or tiles of the visible cell range if render targets are unavailable
+    auto background = world.get_service<BackgroundCache>();
+    if (background && background->update(viewMin, viewMax, ppm, frame.background)) {
+        for (const auto &chunk : background->get_visible())
+            queue.push_chunk(LayerTiles, 0.f, chunk.chunk, chunk.src, to_screen(Transform2D(chunk.cell.x, chunk.cell.y, chunk.cells.x, chunk.cells.y)));
+    } else if (auto tiles = world.get_service<DungeonTiles>()) {
+        const Dungeon &dungeon = *tiles->dungeon;
+        const int x0 = std::max(viewMin.x, 0), x1 = std::min(viewMax.x, dungeon.getWidth() - 1);
+        const int y0 = std::max(viewMin.y, 0), y1 = std::min(viewMax.y, dungeon.getHeight() - 1);
+        for (int y = y0; y <= y1; y++)
+            for (int x = x0; x <= x1; x++) {
+                const Sprite &sprite = dungeon.isFloor(x, y) ? tiles->floor[dungeon.getVariant(x, y)] : tiles->wall;
+                queue.push(LayerTiles, 0.f, sprite, to_screen(Transform2D(x, y)));
+            }
+    }
+
+    // Entities and food near the view, one cell of margin for sprites sticking into it
+    auto scene = world.get_service<SceneIndex>();
+    if (!scene)
+        return;
+    FrameVector<uint32_t> nearby;
+    const int2 queryMin(viewMin.x - 1, viewMin.y - 1);
+
+    // Draw food, it lives in FoodStorage rather than in objects
+    auto food = world.get_service<FoodStorage>();
+    auto foodSprites = world.get_service<FoodSprites>();
+    if (food && foodSprites) {
+        scene->query_food(queryMin, viewMax, nearby);
+        for (uint32_t i : nearby) {
+            // food eaten after the index was built this tick is gone from the storage
+            if (i >= food->size())
+                continue;
+            const Transform2D transform(food->cells[i].x, food->cells[i].y);
+            if (is_visible(transform))
+                queue.push(LayerFood, float(transform.y), foodSprites->byKind[food->kindOf[i]], to_screen(transform));
+        }
     }
 
     // Draw foreground sprites
-    for (const auto& object : world.get_objects()) {
-        auto sprite = object->get_component<Sprite>();
-        auto transform = object->get_component<Transform2D>();
-        auto bgTag = object->get_component<BackGroundTag>();
-        if (bgTag)
-            continue;
-        if (!sprite || !transform)
-            continue;
-        SDL_FRect dst = to_camera_space(*transform, *camera_transform, *camera2d);
-        dst.x += screenW / 2;
-        dst.y += screenH / 2;
-        DrawSprite(renderer, *sprite, dst);
+    nearby.clear();
+    scene->query_entities(queryMin, viewMax, nearby);
+    std::erase_if(nearby, [&](uint32_t i) { return !is_visible(*scene->entries[i].transform); });
+    for (uint32_t i : nearby) {
+        const auto &entry = scene->entries[i];
+        if (entry.sprite)
+            queue.push(LayerSprites, float(entry.transform->y), *entry.sprite, to_screen(*entry.transform));
     }
-    // Draw bars without textures and without OOP
-    float grayColor[4] = {0.2f, 0.2f, 0.2f, 1.f};
-    float healthColor[4] = {0.91f, 0.27f, 0.22f, 1.f};
-    float staminaColor[4] = {0.f, 0.6f, 0.86f, 1.f};
-
-    std::vector<SDL_FRect> backBars;
-    std::vector<SDL_FRect> healthBars;
-    std::vector<SDL_FRect> staminaBars;
-    for (const auto& object : world.get_objects()) {
-        auto transform = object->get_component<Transform2D>();
-        auto health = object->get_component<Health>();
-        auto stamina = object->get_component<Stamina>();
-        if (!transform)
-            continue;
+    // Draw bars as untextured quads of the same queue
+    const SDL_FColor grayColor = {0.2f, 0.2f, 0.2f, 1.f};
+    const SDL_FColor healthColor = {0.91f, 0.27f, 0.22f, 1.f};
+    const SDL_FColor staminaColor = {0.f, 0.6f, 0.86f, 1.f};
+
+    for (uint32_t i : nearby) {
+        const auto &transform = scene->entries[i].transform;
+        const auto &health = scene->entries[i].health;
+        const auto &stamina = scene->entries[i].stamina;
         if (health)
         {
             Transform2D barTransform = *transform;
             barTransform.sizeX *= 0.1f;
-            SDL_FRect dst = to_camera_space(barTransform, *camera_transform, *camera2d);
-            dst.x += screenW / 2;
-            dst.y += screenH / 2;
-            backBars.push_back(dst);
-            const float value = float(health->current) / float(health->max);
+            SDL_FRect dst = to_screen(barTransform);
+            queue.push_rect(LayerBars, float(transform->y), dst, grayColor);
+            const float value = float(health->get()) / float(health->get_max());
             dst.y += (1.f - value) * dst.h;
             dst.h *= value;
-            healthBars.push_back(dst);
+            queue.push_rect(LayerBars, float(transform->y), dst, healthColor);
         }
         if (stamina)
         {
             Transform2D barTransform = *transform;
             barTransform.x += barTransform.sizeX * 0.9f;
             barTransform.sizeX *= 0.1f;
-            SDL_FRect dst = to_camera_space(barTransform, *camera_transform, *camera2d);
-            dst.x += screenW / 2;
-            dst.y += screenH / 2;
-            backBars.push_back(dst);
-            const float value = float(stamina->current) / float(stamina->max);
+            SDL_FRect dst = to_screen(barTransform);
+            queue.push_rect(LayerBars, float(transform->y), dst, grayColor);
+            const float value = float(stamina->get()) / float(stamina->get_max());
             dst.y += (1.f - value) * dst.h;
             dst.h *= value;
-            staminaBars.push_back(dst);
+            queue.push_rect(LayerBars, float(transform->y), dst, staminaColor);
         }
     }
+}
+// Zoomed-out frame: one quad of the overview for the whole map and a dot per group of entities.
+// false if there is no overview, then the frame is drawn as usual
+template <class ToScreen>
+static bool collect_overview(RenderFrame& frame, World& world, int2 viewMin, int2 viewMax, float ppm, const ToScreen& to_screen)
+{
+    auto overview = world.get_service<DungeonOverview>();
+    auto tiles = world.get_service<DungeonTiles>();
+    if (!overview || !tiles || !tiles->dungeon)
+        return false;
+    RenderQueue& queue = frame.queue;
+    const Dungeon& dungeon = *tiles->dungeon;
+    const int x0 = std::max(viewMin.x, 0), x1 = std::min(viewMax.x, dungeon.getWidth() - 1);
+    const int y0 = std::max(viewMin.y, 0), y1 = std::min(viewMax.y, dungeon.getHeight() - 1);
+    if (x0 > x1 || y0 > y1)
+        return true;
+
+    // Draw the visible part of the overview level, a texel covers block x block cells
+    const uint32_t level = overview->choose_level(ppm);
+    overview->prepare(level, frame.overview);
+    const float block = float(DungeonOverview::get_block(level));
+    const SDL_FRect src = {x0 / block, y0 / block, (x1 - x0 + 1) / block, (y1 - y0 + 1) / block};
+    queue.push_overview(LayerTiles, 0.f, level, src, to_screen(Transform2D(x0, y0, x1 - x0 + 1, y1 - y0 + 1)));
 
-    SDL_SetRenderDrawColorFloat(renderer, grayColor[0], grayColor[1], grayColor[2], grayColor[3]);
-    SDL_RenderFillRects(renderer, backBars.data(), int(backBars.size()));
-    SDL_SetRenderDrawColorFloat(renderer, healthColor[0], healthColor[1], healthColor[2], healthColor[3]);
-    SDL_RenderFillRects(renderer, healthBars.data(), int(healthBars.size()));
-    SDL_SetRenderDrawColorFloat(renderer, staminaColor[0], staminaColor[1], staminaColor[2], staminaColor[3]);
-    SDL_RenderFillRects(renderer, staminaBars.data(), int(staminaBars.size()));
+    auto scene = world.get_service<SceneIndex>();
+    if (!scene)
+        return true;
+    // Count entities on a grid of dotCells x dotCells cells aligned to the map, so the dots
+    // do not flicker while the camera pans; a power of two lines it up with the index buckets
+    int dotCells = 1;
+    while (dotCells * ppm < DotPixels)
+        dotCells *= 2;
+    const int gx0 = x0 / dotCells, gy0 = y0 / dotCells;
+    const int columns = x1 / dotCells - gx0 + 1, rows = y1 / dotCells - gy0 + 1;
+    FrameVector<uint32_t> counts;
+    counts.assign(size_t(columns) * rows, 0);
+    const SpatialIndex& index = scene->get_entity_index();
+    if (dotCells >= SpatialIndex::CellSize) {
+        // a dot covers whole buckets of the index, their sizes are enough
+        const int bx1 = std::min(x1 / SpatialIndex::CellSize, index.get_columns() - 1);
+        const int by1 = std::min(y1 / SpatialIndex::CellSize, index.get_rows() - 1);
+        for (int by = y0 / SpatialIndex::CellSize; by <= by1; by++)
+            for (int bx = x0 / SpatialIndex::CellSize; bx <= bx1; bx++) {
+                const int gx = bx * SpatialIndex::CellSize / dotCells - gx0, gy = by * SpatialIndex::CellSize / dotCells - gy0;
+                counts[size_t(gy) * columns + gx] += index.get_count(bx, by);
+            }
+    } else {
+        FrameVector<uint32_t> nearby;
+        scene->query_entities(int2(x0, y0), int2(x1, y1), nearby);
+        for (uint32_t i : nearby) {
+            // the cells the index was built from, no pointer chasing per entity
+            const int2 cell = scene->get_entity_cell(i);
+            const int gx = cell.x / dotCells - gx0, gy = cell.y / dotCells - gy0;
+            if (cell.x >= 0 && cell.y >= 0 && gx >= 0 && gx < columns && gy >= 0 && gy < rows)
+                counts[size_t(gy) * columns + gx]++;
+        }
+    }
 
-}
\ No newline at end of file
+    // Draw a dot per non-empty cell of the grid, brighter where there are more entities
+    const SDL_FColor dimColor = {0.55f, 0.45f, 0.2f, 1.f};
+    const SDL_FColor fullColor = {1.f, 0.92f, 0.35f, 1.f};
+    for (int gy = 0; gy < rows; gy++)
+        for (int gx = 0; gx < columns; gx++) {
+            const uint32_t count = counts[size_t(gy) * columns + gx];
+            if (!count)
+                continue;
+            const float t = float(std::min(count, DotFullCount) - 1) / float(DotFullCount - 1);
+            const SDL_FColor color = {dimColor.r + (fullColor.r - dimColor.r) * t, dimColor.g + (fullColor.g - dimColor.g) * t,
+                                      dimColor.b + (fullColor.b - dimColor.b) * t, 1.f};
+            // a little smaller than its cell, so neighbouring dots stay apart
+            const float inset = dotCells * 0.125f;
+            queue.push_rect(LayerSprites, 0.f, to_screen(Transform2D((gx0 + gx) * dotCells + inset, (gy0 + gy) * dotCells + inset,
+                                                                     dotCells - 2 * inset, dotCells - 2 * inset)), color);
+        }
+    return true;
+}
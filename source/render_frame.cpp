@@ -0,0 +1,35 @@
+#include "render_frame.h"
+
+void RenderFrames::publish()
+{
+    std::unique_lock lock(mutex);
+    changed.wait(lock, [&] { return ready == None || stopped; });
+    if (stopped)
+        return;
+    ready = writing;
+    // свободен тот буфер, что не ждёт и не рисуется
+    for (int i = 0; i < 3; i++)
+        if (i != ready && i != drawing) {
+            writing = i;
+            break;
+        }
+    changed.notify_all();
+}
+
+RenderFrame *RenderFrames::acquire(std::chrono::milliseconds timeout)
+{
+    std::unique_lock lock(mutex);
+    if (!changed.wait_for(lock, timeout, [&] { return ready != None || stopped; }) || ready == None)
+        return nullptr;
+    drawing = ready;
+    ready = None;
+    changed.notify_all();
+    return &buffers[drawing];
+}
+
+void RenderFrames::stop()
+{
+    std::lock_guard lock(mutex);
+    stopped = true;
+    changed.notify_all();
+}
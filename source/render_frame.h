@@ -0,0 +1,59 @@
+#pragma once
+
+#include "background_cache.h"
+#include "dungeon_overview.h"
+#include "render_queue.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+// Всё, что нужно потоку отрисовки для одного кадра; ссылок на мир нет
+struct RenderFrame {
+    RenderQueue queue;
+    BackgroundCommands background;
+    OverviewCommands overview;
+
+    void clear() {
+        queue.clear();
+        background.clear();
+        overview.clear();
+    }
+};
+
+// Тройной буфер кадров между потоком симуляции и потоком отрисовки (тем, у которого SDL_Renderer).
+// Симуляция заполняет один кадр, пока отрисовка рисует другой, а третий ждёт своей очереди:
+// кадр N+1 считается, пока кадр N показывается и ждёт vsync. Кадры не пропускаются
+// (в них перерисовки фона), поэтому симуляция, обогнавшая отрисовку на целый кадр, ждёт в publish.
+// Размер окна передаётся в обратную сторону
+class RenderFrames {
+public:
+    // Поток симуляции: кадр для заполнения, до publish его никто не трогает
+    RenderFrame &get_writing() { return buffers[writing]; }
+    // Отдаёт заполненный кадр отрисовке; ждёт, пока она заберёт предыдущий, или stop
+    void publish();
+
+    // Поток отрисовки: следующий кадр или nullptr, если за timeout его не было.
+    // Кадр, полученный прошлым вызовом, с этого момента может переписываться
+    RenderFrame *acquire(std::chrono::milliseconds timeout);
+
+    // Будит и отпускает поток симуляции, дальше publish не ждёт
+    void stop();
+
+    void set_screen_size(int width, int height) {
+        screenWidth = width;
+        screenHeight = height;
+    }
+    int get_screen_width() const { return screenWidth; }
+    int get_screen_height() const { return screenHeight; }
+
+private:
+    static constexpr int None = -1;
+
+    RenderFrame buffers[3];
+    std::mutex mutex;
+    std::condition_variable changed;
+    int writing = 0, ready = None, drawing = None;
+    bool stopped = false;
+    std::atomic<int> screenWidth = 0, screenHeight = 0;
+};
@@ -0,0 +1,116 @@
+#include "render_queue.h"
+
+#include <algorithm>
+#include <bit>
+
+uint64_t RenderQueue::make_key(uint8_t layer, uintptr_t texture, float depth)
+{
+    uint64_t textureId = 0;
+    if (texture) {
+        if (lastTexture >= textures.size() || textures[lastTexture] != texture) {
+            lastTexture = 0;
+            while (lastTexture < textures.size() && textures[lastTexture] != texture)
+                lastTexture++;
+            if (lastTexture == textures.size())
+                textures.push_back(texture);
+        }
+        // больше 65535 текстур в кадре не бывает; если всё же так, они делят номер и рисуются вперемешку
+        textureId = std::min<uint64_t>(lastTexture + 1, 0xffff);
+    }
+    // float в беззнаковое число того же порядка: у отрицательных инвертируются все биты, у остальных знак
+    uint32_t bits = std::bit_cast<uint32_t>(depth);
+    bits ^= (bits >> 31) ? 0xffffffffu : 0x80000000u;
+    return (uint64_t(layer) << 56) | (textureId << 40) | (uint64_t(bits) << 8);
+}
+
+void RenderQueue::push(uint8_t layer, float depth, const Sprite &sprite, const SDL_FRect &dst)
+{
+    if (!sprite.texture)
+        return;
+    keys.push_back(make_key(layer, uintptr_t(sprite.texture.get()), depth));
+    items.push_back(Item{ sprite.texture.get(), 0, sprite.src, dst, SDL_FColor{ 1.f, 1.f, 1.f, 1.f }, layer, Direct });
+}
+
+void RenderQueue::push_chunk(uint8_t layer, float depth, uint32_t chunk, const SDL_FRect &src, const SDL_FRect &dst)
+{
+    // нечётные числа не совпадут с адресом текстуры
+    keys.push_back(make_key(layer, (uintptr_t(chunk) << 2) | 1, depth));
+    items.push_back(Item{ nullptr, chunk, src, dst, SDL_FColor{ 1.f, 1.f, 1.f, 1.f }, layer, Chunk });
+}
+
+void RenderQueue::push_overview(uint8_t layer, float depth, uint32_t level, const SDL_FRect &src, const SDL_FRect &dst)
+{
+    keys.push_back(make_key(layer, (uintptr_t(level) << 2) | 3, depth));
+    items.push_back(Item{ nullptr, level, src, dst, SDL_FColor{ 1.f, 1.f, 1.f, 1.f }, layer, Overview });
+}
+
+void RenderQueue::push_rect(uint8_t layer, float depth, const SDL_FRect &dst, SDL_FColor color)
+{
+    keys.push_back(make_key(layer, 0, depth));
+    items.push_back(Item{ nullptr, 0, SDL_FRect{}, dst, color, layer, Rect });
+}
+
+void RenderQueue::sort()
+{
+    const size_t n = keys.size();
+    order.resize(n);
+    for (size_t i = 0; i < n; i++)
+        order[i] = uint32_t(i);
+    keysScratch.resize(n);
+    orderScratch.resize(n);
+    // младший байт ключа всегда 0, его не сортируем
+    for (int shift = 8; shift < 64; shift += 8) {
+        size_t count[256] = {};
+        for (size_t i = 0; i < n; i++)
+            count[(keys[i] >> shift) & 0xff]++;
+        if (n == 0 || count[(keys[0] >> shift) & 0xff] == n)
+            continue;
+        size_t offset = 0;
+        for (size_t &c : count) {
+            const size_t next = offset + c;
+            c = offset;
+            offset = next;
+        }
+        for (size_t i = 0; i < n; i++) {
+            const size_t at = count[(keys[i] >> shift) & 0xff]++;
+            keysScratch[at] = keys[i];
+            orderScratch[at] = order[i];
+        }
+        keys.swap(keysScratch);
+        order.swap(orderScratch);
+    }
+}
+
+void RenderQueue::submit(SpriteBatch &batch, const OwnedTextures &owned) const
+{
+    auto owned_texture = [](std::span<SDL_Texture *const> textures, uint32_t index) {
+        return index < textures.size() ? textures[index] : nullptr;
+    };
+    for (uint32_t i : order) {
+        const Item &item = items[i];
+        batch.set_layer(item.layer);
+        switch (item.source) {
+        case Direct:
+            batch.add(item.texture, item.src, item.dst);
+            break;
+        case Chunk:
+            batch.add(owned_texture(owned.chunks, item.index), item.src, item.dst);
+            break;
+        case Overview:
+            batch.add(owned_texture(owned.overview, item.index), item.src, item.dst);
+            break;
+        case Rect:
+            batch.add_rect(item.dst, item.color);
+            break;
+        }
+    }
+}
+
+void RenderQueue::clear()
+{
+    items.clear();
+    keys.clear();
+    order.clear();
+    textures.clear();
+    lastTexture = 0;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "sprite.h"
+#include "sprite_batch.h"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Очередь отрисовки кадра. Всё, что рисуется, собирается за один проход в плоский массив
+// с 64-битным ключом: слой (старшие 8 бит), номер текстуры в кадре (16 бит) и глубина
+// (32 бита, обычно y: кто ниже на экране, рисуется позже). sort сортирует ключи
+// поразрядно (LSD по байтам, байты, одинаковые у всех ключей, пропускаются), сортировка
+// устойчива, так что при равных ключах сохраняется порядок добавления.
+// Элементы самодостаточны (текстура, src, dst, цвет), поэтому очередь собирается на потоке
+// симуляции, а рисуется на потоке отрисовки (см. RenderFrames). Все массивы живут между кадрами
+class RenderQueue {
+public:
+    // Текстуры, которые есть только у потока отрисовки, по номерам
+    struct OwnedTextures {
+        std::span<SDL_Texture *const> chunks;   // куски фона, см. ChunkTextures
+        std::span<SDL_Texture *const> overview; // уровни обзорной карты, см. OverviewTextures
+    };
+
+    void push(uint8_t layer, float depth, const Sprite &sprite, const SDL_FRect &dst);
+    // Кусок фона номер chunk
+    void push_chunk(uint8_t layer, float depth, uint32_t chunk, const SDL_FRect &src, const SDL_FRect &dst);
+    // Уровень level обзорной карты
+    void push_overview(uint8_t layer, float depth, uint32_t level, const SDL_FRect &src, const SDL_FRect &dst);
+    // Сплошной прямоугольник без текстуры
+    void push_rect(uint8_t layer, float depth, const SDL_FRect &dst, SDL_FColor color);
+
+    // Упорядочивает элементы по ключам, вызывается один раз после всех push
+    void sort();
+    // Отдаёт всё в batch в порядке sort
+    void submit(SpriteBatch &batch, const OwnedTextures &owned) const;
+    void clear();
+
+    size_t size() const { return items.size(); }
+
+private:
+    enum Source : uint8_t {
+        Direct,   // texture
+        Chunk,    // owned.chunks[index]
+        Overview, // owned.overview[index]
+        Rect,     // прямоугольник цвета color
+    };
+
+    struct Item {
+        SDL_Texture *texture;
+        uint32_t index;
+        SDL_FRect src, dst;
+        SDL_FColor color;
+        uint8_t layer;
+        Source source;
+    };
+
+    std::vector<Item> items;
+    std::vector<uint64_t> keys, keysScratch;
+    std::vector<uint32_t> order, orderScratch;
+    std::vector<uintptr_t> textures; // номер текстуры в кадре - индекс + 1, 0 - без текстуры
+    size_t lastTexture = 0;
+
+    uint64_t make_key(uint8_t layer, uintptr_t texture, float depth);
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "component.h"
+#include "game_object.h"
+#include "world.h"
+#include "sprite.h"
+#include "transform2d.h"
+#include "health.h"
+#include "stamina.h"
+#include "food_storage.h"
+#include "spatial_index.h"
+#include <cmath>
+
+// Drawable entities and food bucketed by map cell, a world service read by build_render_frame
+// to draw only what the camera sees
+class SceneIndex {
+public:
+    struct Entry {
+        std::shared_ptr<Sprite> sprite;
+        std::shared_ptr<Transform2D> transform;
+        std::shared_ptr<Health> health;
+        std::shared_ptr<Stamina> stamina;
+    };
+
+    SceneIndex(int width, int height)
+        : entityIndex(width, height), foodIndex(width, height) {}
+
+    std::vector<Entry> entries;
+
+    // Indices of entries and food whose cells are in [min, max], plus a few around it
+    template <class Vector>
+    void query_entities(int2 min, int2 max, Vector &out) const {
+        entityIndex.query(min, max, out);
+    }
+    template <class Vector>
+    void query_food(int2 min, int2 max, Vector &out) const {
+        foodIndex.query(min, max, out);
+    }
+
+    const SpatialIndex &get_entity_index() const { return entityIndex; }
+    // Cell of entries[i] at the last rebuild, read from a dense array instead of through the transform
+    int2 get_entity_cell(uint32_t i) const { return positions[i]; }
+    // Object ids of entries, parallel to them; AiLod maps index queries back to agents with these
+    std::span<const uint32_t> get_entity_ids() const { return ids; }
+
+    void rebuild(World &world, const FoodStorage *food) {
+        entries.clear();
+        positions.clear();
+        ids.clear();
+        for (const auto &object : world.get_objects()) {
+            auto transform = object->get_component<Transform2D>();
+            if (!transform)
+                continue;
+            Entry entry{ object->get_component<Sprite>(), transform, object->get_component<Health>(), object->get_component<Stamina>() };
+            if (!entry.sprite && !entry.health && !entry.stamina)
+                continue;
+            entries.push_back(std::move(entry));
+            positions.push_back(int2(int(std::floor(transform->x)), int(std::floor(transform->y))));
+            ids.push_back(object->get_id());
+        }
+        entityIndex.build(positions);
+        if (food)
+            foodIndex.build(food->cells);
+    }
+
+private:
+    SpatialIndex entityIndex;
+    SpatialIndex foodIndex;
+    std::vector<int2> positions;
+    std::vector<uint32_t> ids;
+};
+
+// Rebuilds the SceneIndex once per tick, after everything has moved
+class SceneIndexSystem : public Component {
+    std::shared_ptr<SceneIndex> index;
+public:
+    SceneIndexSystem(std::shared_ptr<SceneIndex> index)
+        : index(index) {}
+
+    void on_update(float dt) override {
+        World *world = get_owner()->get_world();
+        auto food = world->get_service<FoodStorage>();
+        index->rebuild(*world, food.get());
+    }
+};
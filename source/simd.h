@@ -0,0 +1,80 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+// Векторные пути выбираются во время выполнения, а не флагами сборки. SSE2 есть у любого x86-64,
+// поэтому его варианты собираются и работают всегда. Функции под AVX2 помечаются SIMD_AVX2:
+// компилятор собирает их с AVX2 без -mavx2 для всей программы, а вызываются они, только если
+// get_simd_level() вернул Avx2. На других процессорах остаётся скалярный код (SIMD_X86 не определён).
+// Функции с SIMD_AVX2 не встраиваются в обычный код, поэтому выбор делается один раз на весь цикл
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+// MSVC разрешает интринсики любого набора команд без флагов
+#define SIMD_AVX2
+#else
+#define SIMD_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+enum class SimdLevel : uint8_t {
+    Scalar,
+    Sse2,
+    Avx2,
+};
+
+namespace simd_detail {
+
+inline SimdLevel detect()
+{
+#if defined(SIMD_X86)
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return SimdLevel::Sse2;
+    __cpuid(info, 1);
+    // AVX и OSXSAVE: регистры ymm должна сохранять и система
+    const bool osAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    return osAvx && (info[1] & (1 << 5)) ? SimdLevel::Avx2 : SimdLevel::Sse2;
+#else
+    return __builtin_cpu_supports("avx2") ? SimdLevel::Avx2 : SimdLevel::Sse2;
+#endif
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+// задаётся до запуска потоков, дальше только читается
+inline SimdLevel limit = SimdLevel::Avx2;
+
+} // namespace simd_detail
+
+// Лучший набор команд этого процессора, но не выше limit_simd_level
+inline SimdLevel get_simd_level()
+{
+    static const SimdLevel detected = simd_detail::detect();
+    return std::min(detected, simd_detail::limit);
+}
+
+// Для бенчмарков: сравнить варианты на одной машине. Вызывать до запуска рабочих потоков
+inline void limit_simd_level(SimdLevel level)
+{
+    simd_detail::limit = level;
+}
+
+inline const char *get_simd_name(SimdLevel level)
+{
+    switch (level) {
+    case SimdLevel::Avx2:
+        return "AVX2";
+    case SimdLevel::Sse2:
+        return "SSE2";
+    default:
+        return "scalar";
+    }
+}
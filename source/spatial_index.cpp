@@ -0,0 +1,35 @@
+#include "spatial_index.h"
+
+#include <algorithm>
+
+SpatialIndex::SpatialIndex(int width, int height)
+    : columns(std::max(1, (width + CellSize - 1) / CellSize)), rows(std::max(1, (height + CellSize - 1) / CellSize)),
+      cellStart(size_t(columns) * rows + 1, 0)
+{
+}
+
+uint32_t SpatialIndex::cell_index(int2 position) const
+{
+    const int cx = std::clamp(position.x / CellSize, 0, columns - 1);
+    const int cy = std::clamp(position.y / CellSize, 0, rows - 1);
+    return uint32_t(cy * columns + cx);
+}
+
+void SpatialIndex::build(std::span<const int2> positions)
+{
+    std::fill(cellStart.begin(), cellStart.end(), 0);
+    cellOf.resize(positions.size());
+    for (size_t i = 0; i < positions.size(); i++) {
+        cellOf[i] = cell_index(positions[i]);
+        cellStart[cellOf[i] + 1]++;
+    }
+    for (size_t c = 1; c < cellStart.size(); c++)
+        cellStart[c] += cellStart[c - 1];
+    // cellStart[c] служит курсором записи клетки c - 1 и после раскладки снова указывает на начало клетки c
+    items.resize(positions.size());
+    for (size_t i = 0; i < positions.size(); i++)
+        items[cellStart[cellOf[i]]++] = uint32_t(i);
+    for (size_t c = cellStart.size() - 1; c > 0; c--)
+        cellStart[c] = cellStart[c - 1];
+    cellStart[0] = 0;
+}
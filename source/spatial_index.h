@@ -0,0 +1,52 @@
+#pragma once
+
+#include "math2d.h"
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Точки на карте по крупным клеткам CellSize x CellSize. Индекс пересобирается целиком
+// сортировкой подсчётом за O(N + число клеток); запрос прямоугольника обходит только
+// попавшие в него крупные клетки, так что стоит столько, сколько точек рядом с ним.
+// Точки за картой попадают в крайние клетки
+class SpatialIndex {
+public:
+    static constexpr int CellSize = 16;
+
+    SpatialIndex(int width, int height);
+
+    void build(std::span<const int2> positions);
+
+    int get_columns() const { return columns; }
+    int get_rows() const { return rows; }
+    // Сколько точек в крупной клетке (cx, cy)
+    uint32_t get_count(int cx, int cy) const {
+        const size_t cell = size_t(cy) * columns + cx;
+        return cellStart[cell + 1] - cellStart[cell];
+    }
+
+    // Дописывает в out номера точек из крупных клеток, задевающих [min, max] (включительно).
+    // Точки у краёв прямоугольника могут лежать снаружи, точную проверку делает вызывающий.
+    // out - любой вектор uint32_t, например FrameVector
+    template <class Vector>
+    void query(int2 min, int2 max, Vector &out) const {
+        if (max.x < min.x || max.y < min.y)
+            return;
+        const int x0 = std::clamp(min.x / CellSize, 0, columns - 1), x1 = std::clamp(max.x / CellSize, 0, columns - 1);
+        const int y0 = std::clamp(min.y / CellSize, 0, rows - 1), y1 = std::clamp(max.y / CellSize, 0, rows - 1);
+        for (int cy = y0; cy <= y1; cy++) {
+            // клетки строки лежат в items подряд
+            const size_t begin = cellStart[size_t(cy) * columns + x0], end = cellStart[size_t(cy) * columns + x1 + 1];
+            out.insert(out.end(), items.begin() + begin, items.begin() + end);
+        }
+    }
+
+private:
+    int columns, rows;
+    std::vector<uint32_t> cellStart; // columns * rows + 1, начало клетки в items
+    std::vector<uint32_t> items;
+    std::vector<uint32_t> cellOf;
+
+    uint32_t cell_index(int2 position) const;
+};
@@ -0,0 +1,72 @@
+#include "sprite_batch.h"
+
+static const SDL_FColor White = { 1.f, 1.f, 1.f, 1.f };
+
+SpriteBatch::Batch &SpriteBatch::get_batch(SDL_Texture *texture)
+{
+    if (lastBatch < batches.size() && batches[lastBatch].layer == currentLayer && batches[lastBatch].texture == texture)
+        return batches[lastBatch];
+    size_t found = SIZE_MAX, insertAt = batches.size();
+    for (size_t i = 0; i < batches.size() && found == SIZE_MAX; i++) {
+        if (batches[i].layer == currentLayer && batches[i].texture == texture)
+            found = i;
+        else if (batches[i].layer > currentLayer && insertAt == batches.size())
+            insertAt = i;
+    }
+    if (found == SIZE_MAX) {
+        batches.insert(batches.begin() + insertAt, Batch{ currentLayer, texture, 0.f, 0.f, {} });
+        found = insertAt;
+    }
+    Batch &batch = batches[lastBatch = found];
+    // размер берётся заново в каждом кадре: по тому же адресу может оказаться другая текстура
+    if (texture && batch.vertices.empty()) {
+        float w = 0, h = 0;
+        SDL_GetTextureSize(texture, &w, &h);
+        batch.invWidth = w > 0 ? 1.f / w : 0.f;
+        batch.invHeight = h > 0 ? 1.f / h : 0.f;
+    }
+    return batch;
+}
+
+void SpriteBatch::add(SDL_Texture *texture, const SDL_FRect &src, const SDL_FRect &dst)
+{
+    if (!texture)
+        return;
+    Batch &batch = get_batch(texture);
+    const float u0 = src.x * batch.invWidth, u1 = (src.x + src.w) * batch.invWidth;
+    const float v0 = src.y * batch.invHeight, v1 = (src.y + src.h) * batch.invHeight;
+    batch.vertices.push_back(SDL_Vertex{ { dst.x, dst.y }, White, { u0, v0 } });
+    batch.vertices.push_back(SDL_Vertex{ { dst.x + dst.w, dst.y }, White, { u1, v0 } });
+    batch.vertices.push_back(SDL_Vertex{ { dst.x + dst.w, dst.y + dst.h }, White, { u1, v1 } });
+    batch.vertices.push_back(SDL_Vertex{ { dst.x, dst.y + dst.h }, White, { u0, v1 } });
+}
+
+void SpriteBatch::add_rect(const SDL_FRect &dst, SDL_FColor color)
+{
+    Batch &batch = get_batch(nullptr);
+    batch.vertices.push_back(SDL_Vertex{ { dst.x, dst.y }, color, { 0.f, 0.f } });
+    batch.vertices.push_back(SDL_Vertex{ { dst.x + dst.w, dst.y }, color, { 0.f, 0.f } });
+    batch.vertices.push_back(SDL_Vertex{ { dst.x + dst.w, dst.y + dst.h }, color, { 0.f, 0.f } });
+    batch.vertices.push_back(SDL_Vertex{ { dst.x, dst.y + dst.h }, color, { 0.f, 0.f } });
+}
+
+void SpriteBatch::flush(SDL_Renderer *renderer)
+{
+    quadCount = 0;
+    drawCalls = 0;
+    for (Batch &batch : batches) {
+        const size_t quads = batch.vertices.size() / 4;
+        if (!quads)
+            continue;
+        // индексы одинаковы для всех пар, буфер только дорастает до самой большой
+        for (size_t q = indices.size() / 6; q < quads; q++) {
+            const int v = int(q * 4);
+            indices.insert(indices.end(), { v, v + 1, v + 2, v + 2, v + 3, v });
+        }
+        SDL_RenderGeometry(renderer, batch.texture, batch.vertices.data(), int(batch.vertices.size()),
+                           indices.data(), int(quads * 6));
+        quadCount += quads;
+        drawCalls++;
+        batch.vertices.clear();
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "sprite.h"
+#include <SDL3/SDL_render.h>
+#include <cstddef>
+#include <vector>
+
+// Сборщик четырёхугольников для SDL_RenderGeometry. Спрайты и сплошные прямоугольники
+// (без текстуры) складываются в вершинные буферы по парам (слой, текстура), flush рисует
+// каждую пару одним вызовом: слои по возрастанию, текстуры слоя - в порядке первого появления,
+// внутри пары - в порядке добавления. Буферы и общий индексный буфер живут между кадрами,
+// так что в установившемся режиме память не выделяется
+class SpriteBatch {
+public:
+    // Слой для следующих add; больший рисуется поверх
+    void set_layer(int layer) { currentLayer = layer; }
+
+    void add(const Sprite &sprite, const SDL_FRect &dst) {
+        if (sprite.texture)
+            add(sprite.texture.get(), sprite.src, dst);
+    }
+    void add(SDL_Texture *texture, const SDL_FRect &src, const SDL_FRect &dst);
+    void add_rect(const SDL_FRect &dst, SDL_FColor color);
+
+    void flush(SDL_Renderer *renderer);
+
+    // Статистика последнего flush
+    size_t get_quad_count() const { return quadCount; }
+    size_t get_draw_calls() const { return drawCalls; }
+
+private:
+    struct Batch {
+        int layer;
+        SDL_Texture *texture; // nullptr - сплошные прямоугольники
+        float invWidth, invHeight;
+        std::vector<SDL_Vertex> vertices;
+    };
+
+    std::vector<Batch> batches; // упорядочены по слою
+    std::vector<int> indices;   // 0 1 2 2 3 0 для каждого четырёхугольника
+    int currentLayer = 0;
+    size_t lastBatch = SIZE_MAX;
+    size_t quadCount = 0, drawCalls = 0;
+
+    Batch &get_batch(SDL_Texture *texture);
+};
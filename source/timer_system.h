@@ -0,0 +1,29 @@
+#pragma once
+
+#include "component.h"
+#include "game_object.h"
+#include "world.h"
+#include "timer_wheel.h"
+
+// Advances the world's TimerWheel once per frame; created before the other systems,
+// so timers fire at the start of the tick
+class TimerSystem : public Component {
+    std::shared_ptr<TimerWheel> timers;
+public:
+    TimerSystem(std::shared_ptr<TimerWheel> timers)
+        : timers(timers) {}
+
+    void on_update(float dt) override {
+        timers->advance(dt);
+    }
+};
+
+// A one-shot timer bound to an object: does not fire if the object is gone by then
+template<typename Callback>
+TimerId after_for(TimerWheel &timers, const GameObjectPtr &obj, float seconds, Callback &&callback)
+{
+    return timers.after(seconds, [weak = std::weak_ptr<GameObject>(obj), callback = std::forward<Callback>(callback)]() {
+        if (auto obj = weak.lock())
+            callback(obj);
+    });
+}
@@ -0,0 +1,178 @@
+#include "timer_wheel.h"
+
+#include <algorithm>
+#include <cmath>
+
+TimerWheel::TimerWheel(float resolution)
+    : resolution(resolution > 0.f ? resolution : 1.f / 60.f),
+      heads(size_t(Levels) * Slots, None), tails(size_t(Levels) * Slots, None)
+{
+}
+
+uint32_t TimerWheel::to_steps(float seconds) const
+{
+    const double steps = std::round(double(seconds) / resolution);
+    return uint32_t(std::clamp(steps, 1.0, double(UINT32_MAX)));
+}
+
+TimerId TimerWheel::after(float seconds, TimerCallback callback)
+{
+    return add(to_steps(seconds), 0, std::move(callback));
+}
+
+TimerId TimerWheel::every(float period, TimerCallback callback)
+{
+    const uint32_t steps = to_steps(period);
+    return add(steps, steps, std::move(callback));
+}
+
+TimerId TimerWheel::add(uint32_t delay, uint32_t period, TimerCallback callback)
+{
+    uint32_t index;
+    if (!freeTimers.empty()) {
+        index = freeTimers.back();
+        freeTimers.pop_back();
+    } else {
+        index = uint32_t(timers.size());
+        timers.emplace_back();
+    }
+    Timer &timer = timers[index];
+    timer.callback = std::move(callback);
+    timer.expires = now + delay;
+    timer.period = period;
+    timer.state = State::Scheduled;
+    link(index);
+    activeCount++;
+    return TimerId{ index, timer.generation };
+}
+
+bool TimerWheel::is_active(TimerId id) const
+{
+    return id.index < timers.size() && timers[id.index].generation == id.generation
+        && timers[id.index].state != State::Free;
+}
+
+bool TimerWheel::cancel(TimerId id)
+{
+    if (!is_active(id))
+        return false;
+    // сработавший в этом шаге таймер просто помечается свободным, пачка его пропустит
+    if (timers[id.index].state == State::Scheduled)
+        unlink(id.index);
+    release(id.index);
+    return true;
+}
+
+void TimerWheel::release(uint32_t index)
+{
+    Timer &timer = timers[index];
+    timer.state = State::Free;
+    timer.generation++;
+    timer.callback = nullptr;
+    freeTimers.push_back(index);
+    activeCount--;
+}
+
+void TimerWheel::link(uint32_t index)
+{
+    Timer &timer = timers[index];
+    // самый младший уровень, на котором до срабатывания меньше Slots слотов
+    uint32_t slot = None;
+    for (int level = 0; level < Levels; level++) {
+        const int shift = level * SlotBits;
+        if ((timer.expires >> shift) - (now >> shift) < Slots) {
+            slot = uint32_t(level) * Slots + uint32_t((timer.expires >> shift) & (Slots - 1));
+            break;
+        }
+    }
+    if (slot == None) {
+        // дальше, чем покрывает колесо: в последний слот старшего уровня, оттуда таймер разложится заново
+        const int shift = (Levels - 1) * SlotBits;
+        slot = uint32_t(Levels - 1) * Slots + uint32_t(((now >> shift) + Slots - 1) & (Slots - 1));
+    }
+    timer.slot = slot;
+    timer.prev = tails[slot];
+    timer.next = None;
+    if (tails[slot] != None)
+        timers[tails[slot]].next = index;
+    else
+        heads[slot] = index;
+    tails[slot] = index;
+}
+
+void TimerWheel::unlink(uint32_t index)
+{
+    Timer &timer = timers[index];
+    if (timer.prev != None)
+        timers[timer.prev].next = timer.next;
+    else
+        heads[timer.slot] = timer.next;
+    if (timer.next != None)
+        timers[timer.next].prev = timer.prev;
+    else
+        tails[timer.slot] = timer.prev;
+    timer.prev = timer.next = timer.slot = None;
+}
+
+void TimerWheel::cascade(int level)
+{
+    const uint32_t slot = uint32_t(level) * Slots + uint32_t((now >> (level * SlotBits)) & (Slots - 1));
+    uint32_t index = heads[slot];
+    heads[slot] = tails[slot] = None;
+    while (index != None) {
+        const uint32_t next = timers[index].next;
+        link(index);
+        index = next;
+    }
+}
+
+void TimerWheel::step()
+{
+    now++;
+    // при переходе через границу старшего уровня сначала раскладывается он, потом младшие
+    int top = 0;
+    while (top + 1 < Levels && (now & ((uint64_t(1) << ((top + 1) * SlotBits)) - 1)) == 0)
+        top++;
+    for (int level = top; level > 0; level--)
+        cascade(level);
+
+    const uint32_t slot = uint32_t(now & (Slots - 1));
+    firing.clear();
+    for (uint32_t index = heads[slot]; index != None; index = timers[index].next) {
+        timers[index].state = State::Firing;
+        timers[index].slot = None;
+        firing.push_back(index);
+    }
+    heads[slot] = tails[slot] = None;
+
+    for (uint32_t index : firing) {
+        if (timers[index].state != State::Firing)
+            continue; // отменён из callback другого таймера этой пачки
+        const uint32_t generation = timers[index].generation;
+        // callback может завести новые таймеры и переложить массив, поэтому вызывается копия вне него
+        TimerCallback callback = std::move(timers[index].callback);
+        callback();
+        firedCount++;
+        Timer &timer = timers[index];
+        if (timer.generation != generation || timer.state != State::Firing)
+            continue; // отменён из собственного callback
+        if (timer.period) {
+            timer.callback = std::move(callback);
+            timer.expires = now + timer.period;
+            timer.state = State::Scheduled;
+            link(index);
+        } else {
+            release(index);
+        }
+    }
+}
+
+void TimerWheel::advance(float dt)
+{
+    firedCount = 0;
+    accumulator += dt;
+    while (accumulator >= resolution) {
+        accumulator -= resolution;
+        step();
+    }
+}
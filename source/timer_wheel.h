@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Номер таймера в TimerWheel; после срабатывания разового таймера или cancel устаревает
+struct TimerId {
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+};
+
+using TimerCallback = std::function<void()>;
+
+// Иерархическое колесо таймеров, одно на мир (см. World::get_service).
+// Время идёт шагами по resolution секунд; Levels уровней по Slots слотов, слот уровня l
+// покрывает Slots^l шагов. Таймер лежит в двусвязном списке своего слота, поэтому
+// постановка и отмена - O(1), а за шаг обходится только слот, который наступил,
+// и изредка слот старшего уровня, таймеры которого раскладываются по младшим.
+// Стоимость advance зависит от числа срабатывающих таймеров, а не от числа заведённых.
+// Все таймеры, наступившие за один advance, вызываются одной пачкой в порядке шагов
+class TimerWheel {
+public:
+    static constexpr int SlotBits = 6;
+    static constexpr uint32_t Slots = 1u << SlotBits;
+    static constexpr int Levels = 4;
+
+    explicit TimerWheel(float resolution = 1.f / 60.f);
+
+    // Разовый таймер через seconds секунд (не раньше следующего шага)
+    TimerId after(float seconds, TimerCallback callback);
+    // Периодический таймер: первый раз через period секунд, потом каждые period
+    TimerId every(float period, TimerCallback callback);
+    // false, если таймер уже сработал (разовый) или отменён; таймер можно отменить из его же callback
+    bool cancel(TimerId id);
+    bool is_active(TimerId id) const;
+
+    // Продвигает время на dt секунд и вызывает наступившие таймеры
+    void advance(float dt);
+
+    float get_resolution() const { return resolution; }
+    size_t get_active_count() const { return activeCount; }
+    // таймеров, вызванных последним advance
+    size_t get_fired_count() const { return firedCount; }
+
+private:
+    static constexpr uint32_t None = UINT32_MAX;
+
+    enum class State : uint8_t { Free, Scheduled, Firing };
+    struct Timer {
+        TimerCallback callback;
+        uint64_t expires = 0;   // номер шага
+        uint32_t period = 0;    // шагов, 0 - разовый
+        uint32_t generation = 0;
+        uint32_t prev = None, next = None;
+        uint32_t slot = None;   // level * Slots + slot, пока таймер в колесе
+        State state = State::Free;
+    };
+
+    float resolution;
+    float accumulator = 0.f;
+    uint64_t now = 0;
+    std::vector<Timer> timers;
+    std::vector<uint32_t> freeTimers;
+    std::vector<uint32_t> heads;  // Levels * Slots голов списков
+    std::vector<uint32_t> tails;
+    std::vector<uint32_t> firing;
+    size_t activeCount = 0;
+    size_t firedCount = 0;
+
+    uint32_t to_steps(float seconds) const;
+    TimerId add(uint32_t delay, uint32_t period, TimerCallback callback);
+    void link(uint32_t index);
+    void unlink(uint32_t index);
+    void release(uint32_t index);
+    // таймеры слота level раскладываются по младшим уровням
+    void cascade(int level);
+    void step();
+};
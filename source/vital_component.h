@@ -0,0 +1,45 @@
+#pragma once
+
+#include "component.h"
+#include "game_object.h"
+#include "world.h"
+#include "vitals.h"
+
+// The world's Vitals columns, created by the first object that needs them
+inline std::shared_ptr<Vitals> get_vitals(World &world)
+{
+    auto vitals = world.get_service<Vitals>();
+    return vitals ? vitals : world.add_service(std::make_shared<Vitals>());
+}
+
+// A component whose value lives in a row of the world's Vitals instead of in the object,
+// so VitalsSystem can drain all objects in one pass over dense columns
+class VitalComponent : public Component {
+public:
+    void on_create() override {
+        auto owner = get_owner();
+        vitals = get_vitals(*owner->get_world());
+        vitals->attach(owner, owner->get_id(), kind, initialMax, &row);
+    }
+    void on_destroy() override {
+        if (vitals)
+            vitals->detach(kind, row);
+        row = Vitals::Detached;
+    }
+
+    // 0 after the object is destroyed
+    int get() const { return vitals ? vitals->get(kind, row) : 0; }
+    int get_max() const { return vitals ? vitals->get_max(kind, row) : 0; }
+    // clamped to [0, max]
+    void set(int value) { if (vitals) vitals->set(kind, row, value); }
+    void change(int delta) { if (vitals) vitals->change(kind, row, delta); }
+
+protected:
+    VitalComponent(VitalKind kind, int maxValue) : kind(kind), initialMax(maxValue) {}
+
+private:
+    std::shared_ptr<Vitals> vitals;
+    VitalKind kind;
+    int initialMax;
+    uint32_t row = Vitals::Detached;
+};
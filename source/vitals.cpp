@@ -0,0 +1,140 @@
+#include "vitals.h"
+
+#include "simd.h"
+#include <algorithm>
+#include <bit>
+
+void Vitals::attach(const std::shared_ptr<GameObject> &owner, uint32_t id, VitalKind kind, int maxValue, uint32_t *row)
+{
+    auto [it, added] = rowById.try_emplace(id, uint32_t(owners.size()));
+    const uint32_t r = it->second;
+    if (added) {
+        owners.push_back(owner);
+        ids.push_back(id);
+        for (uint32_t k = 0; k < VitalKindCount; k++) {
+            current[k].push_back(0);
+            max[k].push_back(0);
+            rowRefs[k].push_back(nullptr);
+        }
+    }
+    const uint16_t value = uint16_t(std::clamp(maxValue, 0, MaxValue));
+    current[kind][r] = value;
+    max[kind][r] = value;
+    rowRefs[kind][r] = row;
+    *row = r;
+}
+
+void Vitals::detach(VitalKind kind, uint32_t row)
+{
+    if (row == Detached)
+        return;
+    current[kind][row] = 0;
+    max[kind][row] = 0;
+    rowRefs[kind][row] = nullptr;
+    for (uint32_t k = 0; k < VitalKindCount; k++)
+        if (rowRefs[k][row])
+            return;
+
+    // последняя строка переезжает на место удалённой
+    rowById.erase(ids[row]);
+    const uint32_t last = uint32_t(owners.size() - 1);
+    if (row != last) {
+        owners[row] = std::move(owners[last]);
+        ids[row] = ids[last];
+        rowById[ids[row]] = row;
+        for (uint32_t k = 0; k < VitalKindCount; k++) {
+            current[k][row] = current[k][last];
+            max[k][row] = max[k][last];
+            rowRefs[k][row] = rowRefs[k][last];
+            if (rowRefs[k][row])
+                *rowRefs[k][row] = row;
+        }
+    }
+    owners.pop_back();
+    ids.pop_back();
+    for (uint32_t k = 0; k < VitalKindCount; k++) {
+        current[k].pop_back();
+        max[k].pop_back();
+        rowRefs[k].pop_back();
+    }
+}
+
+void drain_vitals_scalar(Vitals &vitals, const uint16_t (&drain)[VitalKindCount], size_t begin, size_t end,
+                         std::vector<uint32_t> &emptied)
+{
+    for (uint32_t k = 0; k < VitalKindCount; k++) {
+        uint16_t *current = vitals.current[k].data();
+        for (size_t i = begin; i < end; i++)
+            current[i] = current[i] > drain[k] ? uint16_t(current[i] - drain[k]) : 0;
+    }
+    const uint16_t *health = vitals.current[VitalHealth].data();
+    const uint16_t *healthMax = vitals.max[VitalHealth].data();
+    for (size_t i = begin; i < end; i++)
+        if (healthMax[i] && !health[i])
+            emptied.push_back(uint32_t(i));
+}
+
+#if defined(SIMD_X86)
+// Строки [begin, end) по 16 за итерацию; возвращает первую непосчитанную
+SIMD_AVX2 static size_t drain_vitals_avx2(Vitals &vitals, const uint16_t (&drain)[VitalKindCount], size_t begin, size_t end,
+                                          std::vector<uint32_t> &emptied)
+{
+    size_t i = begin;
+    uint16_t *health = vitals.current[VitalHealth].data();
+    uint16_t *stamina = vitals.current[VitalStamina].data();
+    const uint16_t *healthMax = vitals.max[VitalHealth].data();
+    const __m256i healthDrain = _mm256_set1_epi16(short(drain[VitalHealth]));
+    const __m256i staminaDrain = _mm256_set1_epi16(short(drain[VitalStamina]));
+    const __m256i zero = _mm256_setzero_si256();
+    for (; i + 16 <= end; i += 16) {
+        // беззнаковое вычитание с насыщением само останавливается на 0, без сравнений с границами
+        const __m256i h = _mm256_subs_epu16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(health + i)), healthDrain);
+        const __m256i s = _mm256_subs_epu16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(stamina + i)), staminaDrain);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(health + i), h);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(stamina + i), s);
+        // здоровье 0 при ненулевом max; по два бита маски на строку
+        const __m256i noMax = _mm256_cmpeq_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(healthMax + i)), zero);
+        uint32_t mask = uint32_t(_mm256_movemask_epi8(_mm256_andnot_si256(noMax, _mm256_cmpeq_epi16(h, zero))));
+        for (; mask; mask &= mask - 1, mask &= mask - 1)
+            emptied.push_back(uint32_t(i + (std::countr_zero(mask) >> 1)));
+    }
+    return i;
+}
+
+// То же по 8 строк на SSE2: _mm_subs_epu16 - то же вычитание с насыщением
+static size_t drain_vitals_sse2(Vitals &vitals, const uint16_t (&drain)[VitalKindCount], size_t begin, size_t end,
+                                std::vector<uint32_t> &emptied)
+{
+    size_t i = begin;
+    uint16_t *health = vitals.current[VitalHealth].data();
+    uint16_t *stamina = vitals.current[VitalStamina].data();
+    const uint16_t *healthMax = vitals.max[VitalHealth].data();
+    const __m128i healthDrain = _mm_set1_epi16(short(drain[VitalHealth]));
+    const __m128i staminaDrain = _mm_set1_epi16(short(drain[VitalStamina]));
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= end; i += 8) {
+        const __m128i h = _mm_subs_epu16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(health + i)), healthDrain);
+        const __m128i s = _mm_subs_epu16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(stamina + i)), staminaDrain);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(health + i), h);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(stamina + i), s);
+        const __m128i noMax = _mm_cmpeq_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(healthMax + i)), zero);
+        uint32_t mask = uint32_t(_mm_movemask_epi8(_mm_andnot_si128(noMax, _mm_cmpeq_epi16(h, zero))));
+        for (; mask; mask &= mask - 1, mask &= mask - 1)
+            emptied.push_back(uint32_t(i + (std::countr_zero(mask) >> 1)));
+    }
+    return i;
+}
+#endif
+
+void drain_vitals(Vitals &vitals, const uint16_t (&drain)[VitalKindCount], size_t begin, size_t end,
+                  std::vector<uint32_t> &emptied)
+{
+    size_t i = begin;
+#if defined(SIMD_X86)
+    if (get_simd_level() == SimdLevel::Avx2)
+        i = drain_vitals_avx2(vitals, drain, begin, end, emptied);
+    else if (get_simd_level() == SimdLevel::Sse2)
+        i = drain_vitals_sse2(vitals, drain, begin, end, emptied);
+#endif
+    drain_vitals_scalar(vitals, drain, i, end, emptied);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class GameObject;
+
+enum VitalKind : uint32_t {
+    VitalHealth,
+    VitalStamina,
+    VitalKindCount
+};
+
+// Здоровье и выносливость всех объектов мира плотными столбцами current/max по uint16,
+// одна строка на объект (см. компоненты Health и Stamina). Значения, которых у объекта нет,
+// лежат в строке нулями. Строки переставляются при удалении, компонент хранит номер своей строки,
+// и Vitals обновляет его через запомненный указатель
+class Vitals {
+public:
+    static constexpr uint32_t Detached = std::numeric_limits<uint32_t>::max();
+    static constexpr int MaxValue = std::numeric_limits<uint16_t>::max();
+
+    std::vector<uint16_t> current[VitalKindCount];
+    std::vector<uint16_t> max[VitalKindCount];
+
+    size_t size() const { return owners.size(); }
+
+    // Заводит значение kind объекта owner (строка общая для всех значений объекта);
+    // *row получает номер строки и обновляется при перестановках до detach
+    void attach(const std::shared_ptr<GameObject> &owner, uint32_t id, VitalKind kind, int maxValue, uint32_t *row);
+    // Строка удаляется, когда у объекта не осталось значений
+    void detach(VitalKind kind, uint32_t row);
+
+    int get(VitalKind kind, uint32_t row) const {
+        return row == Detached ? 0 : current[kind][row];
+    }
+    int get_max(VitalKind kind, uint32_t row) const {
+        return row == Detached ? 0 : max[kind][row];
+    }
+    void set(VitalKind kind, uint32_t row, int value) {
+        if (row != Detached)
+            current[kind][row] = uint16_t(value < 0 ? 0 : value > max[kind][row] ? max[kind][row] : value);
+    }
+    void change(VitalKind kind, uint32_t row, int delta) {
+        set(kind, row, get(kind, row) + delta);
+    }
+
+    std::shared_ptr<GameObject> get_owner(uint32_t row) const { return owners[row].lock(); }
+    // Строка объекта id или Detached
+    uint32_t find(uint32_t id) const {
+        auto it = rowById.find(id);
+        return it != rowById.end() ? it->second : Detached;
+    }
+
+private:
+    std::vector<std::weak_ptr<GameObject>> owners;
+    std::vector<uint32_t> ids;
+    std::vector<uint32_t *> rowRefs[VitalKindCount];
+    std::unordered_map<uint32_t, uint32_t> rowById;
+};
+
+// Один проход по строкам [begin, end): отнимает drain[kind] у каждого значения с насыщением в 0
+// и дописывает в emptied номера строк, где здоровье есть (max > 0), но кончилось.
+// По 16 строк за итерацию на AVX2 и по 8 на SSE2 (см. simd.h), результат совпадает с drain_vitals_scalar
+void drain_vitals(Vitals &vitals, const uint16_t (&drain)[VitalKindCount], size_t begin, size_t end,
+                  std::vector<uint32_t> &emptied);
+void drain_vitals_scalar(Vitals &vitals, const uint16_t (&drain)[VitalKindCount], size_t begin, size_t end,
+                         std::vector<uint32_t> &emptied);
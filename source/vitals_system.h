@@ -0,0 +1,56 @@
+#pragma once
+
+#include "component.h"
+#include "game_object.h"
+#include "world.h"
+#include "timer_wheel.h"
+#include "vital_component.h"
+#include "vitals.h"
+
+// Starvation and tiredness: every Interval each object loses HealthDrain health and
+// StaminaDrain stamina in one pass over the dense Vitals columns, and objects left
+// without health are destroyed. With slices > 1 the rows are drained in that many ranges,
+// one range every Interval / slices, so the work does not pile up on one frame per second.
+// A row moved by a removal may be drained one slice early or late. Driven by the world's TimerWheel
+class VitalsSystem : public Component {
+public:
+    static constexpr float Interval = 1.0f; // seconds
+    static constexpr uint16_t HealthDrain = 2;
+    static constexpr uint16_t StaminaDrain = 5;
+
+    explicit VitalsSystem(int slices = 1)
+        : slices(slices > 0 ? slices : 1) {}
+
+    void on_create() override {
+        vitals = get_vitals(*get_owner()->get_world());
+        timers = get_owner()->get_world()->get_service<TimerWheel>();
+        if (timers)
+            timer = timers->every(Interval / slices, [this] { drain_slice(); });
+    }
+
+    void on_destroy() override {
+        if (timers)
+            timers->cancel(timer);
+    }
+
+private:
+    std::shared_ptr<Vitals> vitals;
+    std::shared_ptr<TimerWheel> timers;
+    TimerId timer;
+    int slices;
+    int slice = 0;
+    std::vector<uint32_t> emptied;
+
+    void drain_slice() {
+        const uint16_t drain[VitalKindCount] = { HealthDrain, StaminaDrain };
+        const size_t rows = vitals->size();
+        emptied.clear();
+        drain_vitals(*vitals, drain, rows * slice / slices, rows * (slice + 1) / slices, emptied);
+        slice = (slice + 1) % slices;
+        // rows stay in place until the objects are actually destroyed
+        World *world = get_owner()->get_world();
+        for (uint32_t row : emptied)
+            if (auto obj = vitals->get_owner(row))
+                world->destroy_object(obj);
+    }
+};
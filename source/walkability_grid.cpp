@@ -0,0 +1,63 @@
+#include "walkability_grid.h"
+
+#include <algorithm>
+
+static_assert(sizeof(int2) == 2 * sizeof(int));
+
+#if defined(SIMD_X86)
+// Возвращают, сколько клеток с начала проверено; маска уже обнулена
+SIMD_AVX2 static size_t can_pass_avx2(const WalkabilityGrid &grid, std::span<const int2> cells, std::span<uint64_t> mask)
+{
+    const __m256i evenOdd = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    size_t i = 0;
+    for (; i + 8 <= cells.size(); i += 8) {
+        // x0 y0 x1 y1 ... -> x0..x7 и y0..y7
+        const __m256i a = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(&cells[i])), evenOdd);
+        const __m256i b = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(&cells[i + 4])), evenOdd);
+        const __m256i pass = grid.can_pass8(_mm256_permute2x128_si256(a, b, 0x20), _mm256_permute2x128_si256(a, b, 0x31));
+        mask[i >> 6] |= uint64_t(unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(pass)))) << (i & 63);
+    }
+    return i;
+}
+
+static size_t can_pass_sse2(const WalkabilityGrid &grid, std::span<const int2> cells, std::span<uint64_t> mask)
+{
+    size_t i = 0;
+    uint64_t word = 0;
+    for (; i + 4 <= cells.size(); i += 4) {
+        // x0 y0 x1 y1, x2 y2 x3 y3 -> x0..x3 и y0..y3
+        const __m128 a = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(&cells[i])));
+        const __m128 b = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(&cells[i + 2])));
+        const __m128i x = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        const __m128i y = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        word |= uint64_t(unsigned(grid.can_pass4(x, y))) << (i & 63);
+        if ((i & 63) == 60) {
+            mask[i >> 6] = word;
+            word = 0;
+        }
+    }
+    if (i & 63)
+        mask[i >> 6] = word;
+    return i;
+}
+#endif
+
+void WalkabilityGrid::can_pass(std::span<const int2> cells, std::span<uint64_t> mask) const
+{
+    std::fill(mask.begin(), mask.begin() + (cells.size() + 63) / 64, 0);
+    size_t i = 0;
+#if defined(SIMD_X86)
+    if (get_simd_level() == SimdLevel::Avx2)
+        i = can_pass_avx2(*this, cells, mask);
+    else if (get_simd_level() == SimdLevel::Sse2)
+        i = can_pass_sse2(*this, cells, mask);
+#endif
+    // остаток (или всё без SIMD): биты копятся в регистре и пишутся по слову
+    while (i < cells.size()) {
+        const size_t end = std::min(cells.size(), (i | 63) + 1);
+        uint64_t word = 0;
+        for (; i < end; i++)
+            word |= uint64_t(can_pass(cells[i])) << (i & 63);
+        mask[(end - 1) >> 6] |= word;
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "dungeon_generator.h"
+#include "math2d.h"
+#include "simd.h"
+#include <cstdint>
+#include <memory>
+#include <span>
+
+// Одна на мир проверка проходимости поверх битовой маски Dungeon (см. World::get_service).
+// can_pass не виртуальный и встраивается в место вызова; пакетный вариант проверяет
+// сразу много позиций (по 8 на AVX2, по 4 на SSE2, см. simd.h) и возвращает битовую маску.
+// Указатель на биты берётся из Dungeon один раз: setTile меняет их на месте, поэтому он не устаревает
+class WalkabilityGrid {
+public:
+    explicit WalkabilityGrid(std::shared_ptr<Dungeon> dungeon)
+        : dungeon(dungeon), W(dungeon->getWidth()), H(dungeon->getHeight()),
+          wordsPerRow(dungeon->getWordsPerRow()), bits(dungeon->getWalkableBits()) {}
+
+    bool can_pass(int2 cell) const {
+        // отрицательные координаты после приведения к unsigned тоже больше W/H
+        if (unsigned(cell.x) >= unsigned(W) || unsigned(cell.y) >= unsigned(H))
+            return false;
+        return (bits[size_t(cell.y) * wordsPerRow + (cell.x >> 6)] >> (cell.x & 63)) & 1;
+    }
+
+    // Бит i маски - можно ли пройти в cells[i]. В mask должно быть не меньше (cells.size() + 63) / 64 слов
+    void can_pass(std::span<const int2> cells, std::span<uint64_t> mask) const;
+
+#if defined(SIMD_X86)
+    // 4 клетки сразу: бит k результата - можно ли пройти в клетку линии k.
+    // Границы и номера слов считаются векторно, а слова читаются по одному: выборки по индексам в SSE2 нет
+    int can_pass4(__m128i x, __m128i y) const {
+        // беззнаковое сравнение через знаковое: отрицательные координаты становятся больше W и H
+        const __m128i sign = _mm_set1_epi32(int(0x80000000u));
+        const __m128i inside = _mm_and_si128(_mm_cmplt_epi32(_mm_xor_si128(x, sign), _mm_set1_epi32(int(unsigned(W) ^ 0x80000000u))),
+                                             _mm_cmplt_epi32(_mm_xor_si128(y, sign), _mm_set1_epi32(int(unsigned(H) ^ 0x80000000u))));
+        // точки за картой читают слово 0, их бит потом всё равно обнуляется
+        x = _mm_and_si128(x, inside);
+        y = _mm_and_si128(y, inside);
+        // y * wordsPerRow: в SSE2 умножение только чётных линий, нечётные сдвигаются на их место
+        const __m128i rowWords = _mm_set1_epi32(wordsPerRow);
+        const __m128i even = _mm_mul_epu32(y, rowWords), odd = _mm_mul_epu32(_mm_srli_epi64(y, 32), rowWords);
+        const __m128i row = _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+        alignas(16) uint32_t word[4], shift[4];
+        _mm_store_si128(reinterpret_cast<__m128i *>(word), _mm_add_epi32(row, _mm_srli_epi32(x, 6)));
+        _mm_store_si128(reinterpret_cast<__m128i *>(shift), _mm_and_si128(x, _mm_set1_epi32(63)));
+        const int pass = int((bits[word[0]] >> shift[0]) & 1) | int(((bits[word[1]] >> shift[1]) & 1) << 1) |
+                         int(((bits[word[2]] >> shift[2]) & 1) << 2) | int(((bits[word[3]] >> shift[3]) & 1) << 3);
+        return pass & _mm_movemask_ps(_mm_castsi128_ps(inside));
+    }
+
+    // То же для 8 клеток на AVX2; вызывать только из функций с SIMD_AVX2
+    SIMD_AVX2 __m256i can_pass8(__m256i x, __m256i y) const {
+        // беззнаковый min: отрицательные и слишком большие координаты не равны своему min с W-1
+        const __m256i inside = _mm256_and_si256(_mm256_cmpeq_epi32(_mm256_min_epu32(x, _mm256_set1_epi32(W - 1)), x),
+                                                _mm256_cmpeq_epi32(_mm256_min_epu32(y, _mm256_set1_epi32(H - 1)), y));
+        // точки за картой читают слово 0, их бит потом всё равно обнуляется
+        x = _mm256_and_si256(x, inside);
+        y = _mm256_and_si256(y, inside);
+        const __m256i word = _mm256_add_epi32(_mm256_mullo_epi32(y, _mm256_set1_epi32(wordsPerRow)), _mm256_srli_epi32(x, 6));
+        const long long *words = reinterpret_cast<const long long *>(bits);
+        const __m256i lo = _mm256_i32gather_epi64(words, _mm256_castsi256_si128(word), 8);
+        const __m256i hi = _mm256_i32gather_epi64(words, _mm256_extracti128_si256(word, 1), 8);
+        // сдвигаем нужный бит в младший разряд и собираем 64-битные линии обратно в 32-битные
+        const __m256i shift = _mm256_and_si256(x, _mm256_set1_epi32(63));
+        const __m256i loBit = _mm256_srlv_epi64(lo, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(shift)));
+        const __m256i hiBit = _mm256_srlv_epi64(hi, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(shift, 1)));
+        const __m256i packed = _mm256_permutevar8x32_epi32(
+            _mm256_blend_epi32(loBit, _mm256_slli_epi64(hiBit, 32), 0xAA), _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7));
+        const __m256i pass = _mm256_cmpeq_epi32(_mm256_and_si256(packed, _mm256_set1_epi32(1)), _mm256_set1_epi32(1));
+        return _mm256_and_si256(pass, inside);
+    }
+#endif
+
+    const std::shared_ptr<Dungeon> &get_dungeon() const { return dungeon; }
+
+private:
+    std::shared_ptr<Dungeon> dungeon;
+    int W, H, wordsPerRow;
+    const uint64_t *bits;
+};
@@ -0,0 +1,58 @@
+#include "worker_pool.h"
+
+WorkerPool::WorkerPool(int workerCount)
+{
+    for (int i = 1; i <= workerCount; i++)
+        workers.emplace_back(&WorkerPool::worker_loop, this, i);
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &thread : workers)
+        thread.join();
+}
+
+void WorkerPool::dispatch(int count, void (*call)(void *, int), void *context)
+{
+    if (count <= 1) {
+        if (count == 1)
+            call(context, 0);
+        return;
+    }
+    {
+        std::lock_guard lock(mutex);
+        job = Job{ call, context, count };
+        pending = count - 1;
+        generation++;
+    }
+    wake.notify_all();
+    call(context, 0);
+    std::unique_lock lock(mutex);
+    finished.wait(lock, [&] { return pending == 0; });
+}
+
+void WorkerPool::worker_loop(int index)
+{
+    uint64_t seen = 0;
+    std::unique_lock lock(mutex);
+    while (true) {
+        wake.wait(lock, [&] { return stopping || generation != seen; });
+        if (stopping)
+            return;
+        // задачи прошлых вызовов уже выполнены: run ждёт всех участников, поэтому пропустить свою нельзя
+        seen = generation;
+        if (index >= job.count)
+            continue;
+        const Job current = job;
+        lock.unlock();
+        current.call(current.context, index);
+        lock.lock();
+        if (--pending == 0)
+            finished.notify_one();
+    }
+}
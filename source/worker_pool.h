@@ -0,0 +1,54 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Постоянные рабочие потоки для параллельных участков симуляции (волны FlowField и т.п.),
+// сервис мира: потоки создаются один раз, а не на каждый вызов.
+// run(count, task) вызывает task(0) .. task(count - 1) одновременно: task(0) на вызывающем
+// потоке, остальные - каждая на своём рабочем, так что задачи могут ждать друг друга
+// на барьере. Возвращается, когда закончили все. run зовут из одного потока за раз
+// (в игре - из потока симуляции), изнутри task - нельзя
+class WorkerPool {
+public:
+    // workerCount рабочих потоков, не считая вызывающего; по умолчанию - по числу ядер
+    explicit WorkerPool(int workerCount = int(std::thread::hardware_concurrency()) - 1);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    // Сколько задач run выполняет одновременно, вместе с вызывающим потоком
+    int get_thread_count() const { return int(workers.size()) + 1; }
+
+    // count <= get_thread_count()
+    template <class Task>
+    void run(int count, Task &&task) {
+        using Callable = std::remove_reference_t<Task>;
+        dispatch(std::min(count, get_thread_count()), [](void *context, int index) { (*static_cast<Callable *>(context))(index); },
+                 const_cast<void *>(static_cast<const void *>(&task)));
+    }
+
+private:
+    struct Job {
+        void (*call)(void *context, int index) = nullptr;
+        void *context = nullptr;
+        int count = 0;
+    };
+
+    std::mutex mutex;
+    std::condition_variable wake, finished;
+    Job job;
+    uint64_t generation = 0;
+    int pending = 0;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+
+    void dispatch(int count, void (*call)(void *, int), void *context);
+    void worker_loop(int index);
+};
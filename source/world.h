@@ -1,7 +1,11 @@
 #pragma once
 
 #include "game_object.h"
+#include <algorithm>
+#include <cstdint>
 #include <memory>
+#include <typeindex>
+#include <unordered_map>
 #include <vector>
 
 
@@ -11,6 +15,7 @@ public:
     std::shared_ptr<GameObject> create_object() {
         auto obj = std::make_shared<GameObject>();
         obj->world = shared_from_this();
+        obj->id = nextObjectId++;
         delayedAdd.push_back(obj);
         return obj;
     }
@@ -20,6 +25,7 @@ public:
     }
 
     void update(float dt) {
+        tick++;
         for (auto& obj : delayedRemove)
             objects.erase(std::remove(objects.begin(), objects.end(), obj), objects.end());
         delayedRemove.clear();
@@ -36,6 +42,29 @@ public:
         return objects;
     }
 
+    // number of update() calls so far
+    uint32_t get_tick() const {
+        return tick;
+    }
+
+    // World-wide singletons shared by many components (flow fields, etc.)
+    template<typename T>
+    std::shared_ptr<T> add_service(std::shared_ptr<T> service) {
+        services[std::type_index(typeid(T))] = service;
+        return service;
+    }
+
+    template<typename T>
+    std::shared_ptr<T> get_service() const {
+        auto it = services.find(std::type_index(typeid(T)));
+        if (it != services.end())
+            return std::static_pointer_cast<T>(it->second);
+        return nullptr;
+    }
+
 private:
     std::vector<std::shared_ptr<GameObject>> objects, delayedRemove, delayedAdd;
+    std::unordered_map<std::type_index, std::shared_ptr<void>> services;
+    uint32_t nextObjectId = 1;
+    uint32_t tick = 0;
 };
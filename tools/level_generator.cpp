@@ -0,0 +1,41 @@
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+#include "dungeon_generator.h"
+#include "level_file.h"
+
+// Генерирует уровень и сохраняет его в бинарном формате (см. level_file.h)
+// level_generator --out=level.lvl [--width=120] [--height=50] [--rooms=100] [--seed=N] [--chunk=0]
+int main(int argc, char* argv[])
+{
+    int width = 120;
+    int height = 50;
+    int rooms = 100;
+    int chunk = 0;
+    unsigned seed = std::random_device{}();
+    const char* outPath = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (sscanf(argv[i], "--width=%d", &width) == 1) continue;
+        if (sscanf(argv[i], "--height=%d", &height) == 1) continue;
+        if (sscanf(argv[i], "--rooms=%d", &rooms) == 1) continue;
+        if (sscanf(argv[i], "--seed=%u", &seed) == 1) continue;
+        if (sscanf(argv[i], "--chunk=%d", &chunk) == 1) continue;
+        if (strncmp(argv[i], "--out=", 6) == 0) { outPath = argv[i] + 6; continue; }
+        std::cerr << "Unknown argument: " << argv[i] << std::endl;
+        return 1;
+    }
+    if (!outPath || width < 16 || height < 16 || width > LevelMaxSide || height > LevelMaxSide) {
+        std::cerr << "Usage: level_generator --out=level.lvl [--width=120] [--height=50] [--rooms=100] [--seed=N] [--chunk=0]" << std::endl;
+        return 1;
+    }
+
+    Dungeon dungeon(width, height, rooms, seed, chunk);
+    if (!save_level(dungeon, outPath))
+        return 1;
+    std::cout << outPath << ": " << width << "x" << height << ", "
+              << dungeon.getRooms().size() << " rooms, "
+              << dungeon.getFloorCount() << " floor tiles, seed " << seed << std::endl;
+    return 0;
+}